@@ -19,6 +19,9 @@ static CogShell *global_shell = NULL;
 static CogPlatform *global_platform = NULL;
 static GMainLoop *global_main_loop = NULL;
 static CogBridgeConfig global_config = {0};
+#if COG_USE_WPE2
+static WebKitNetworkSession *global_network_session = NULL;
+#endif
 
 /* CogBridge structure */
 struct _CogBridge {
@@ -74,6 +77,12 @@ cogbridge_get_default_config(CogBridgeConfig *config)
     
     // Module directory (NULL = auto-detect from COG_MODULEDIR env or built-in path)
     config->module_dir = NULL;
+
+    // Startup profiling (also enabled by the COG_STARTUP_PROFILE env var)
+    config->startup_profile = false;
+
+    // Memory pressure monitoring
+    config->memory_monitor = false;
 }
 
 #if COG_USE_WPE2
@@ -119,14 +128,35 @@ on_console_message(WebKitWebView *webview,
 }
 #endif
 
+static void
+on_memory_pressure(CogShell *shell, GParamSpec *pspec, CogBridge *bridge)
+{
+    GEnumClass *enum_class = g_type_class_peek(COG_TYPE_MEMORY_PRESSURE);
+    GEnumValue *value = g_enum_get_value(enum_class, cog_shell_get_memory_pressure(shell));
+
+    g_autofree char *json = g_strdup_printf("{\"level\":\"%s\"}", value->value_nick);
+    cogbridge_emit_event(bridge, "memory-pressure", json);
+}
+
 static void
 on_load_changed(WebKitWebView *webview,
                 WebKitLoadEvent load_event,
                 CogBridge *bridge)
 {
-    if (load_event == WEBKIT_LOAD_FINISHED) {
-        bridge->is_ready = true;
-        g_message("CogBridge: Page loaded and ready");
+    switch (load_event) {
+        case WEBKIT_LOAD_STARTED:
+            cog_profile_mark("load: started");
+            break;
+        case WEBKIT_LOAD_COMMITTED:
+            cog_profile_mark("load: committed");
+            break;
+        case WEBKIT_LOAD_FINISHED:
+            bridge->is_ready = true;
+            g_message("CogBridge: Page loaded and ready");
+            cog_profile_finish();
+            break;
+        default:
+            break;
     }
 }
 
@@ -169,13 +199,17 @@ on_message_received(WebKitUserContentManager *manager,
     g_object_unref(args_val);
 #endif
 
+    cog_metrics_add(COG_METRIC_BRIDGE_CALLS, 1);
+
     BoundFunctionData *func_data = g_hash_table_lookup(bridge->bound_functions, function_name);
     if (!func_data) {
         g_warning("CogBridge: Called unbound function: %s", function_name);
         return;
     }
 
+    cog_trace_record(COG_TRACE_BRIDGE_CALL_BEGIN, g_quark_from_string(function_name));
     g_autofree char *result = func_data->callback(bridge, function_name, args_json, func_data->user_data);
+    cog_trace_record(COG_TRACE_BRIDGE_CALL_END, 0);
     
     if (result) {
         g_autofree char *script = g_strdup_printf(
@@ -201,6 +235,10 @@ cogbridge_init(const CogBridgeConfig *config, GError **error)
         cogbridge_get_default_config(&global_config);
     }
 
+    if (global_config.startup_profile)
+        cog_profile_enable();
+    cog_profile_begin("cogbridge: init");
+
     // Determine platform name from enum or string
     const char *platform_name = NULL;
     
@@ -241,8 +279,25 @@ cogbridge_init(const CogBridgeConfig *config, GError **error)
     // Initialize cog with platform and module directory
     cog_init(platform_name, global_config.module_dir);
 
-    // Create shell
+    // Create shell, with the storage directories from the configuration
+#if COG_USE_WPE2
+    g_clear_object(&global_network_session);
+    if (global_config.data_dir || global_config.cache_dir)
+        global_network_session = webkit_network_session_new(global_config.data_dir, global_config.cache_dir);
     global_shell = cog_shell_new("cogbridge", false);
+#else
+    {
+        g_autofree char *data_dir = global_config.data_dir ? g_strdup(global_config.data_dir)
+                                                           : g_build_filename(g_get_user_data_dir(), "cogbridge", NULL);
+        g_autofree char *cache_dir = global_config.cache_dir
+                                         ? g_strdup(global_config.cache_dir)
+                                         : g_build_filename(g_get_user_cache_dir(), "cogbridge", NULL);
+        g_autoptr(WebKitWebsiteDataManager) data_manager =
+            webkit_website_data_manager_new("base-data-directory", data_dir, "base-cache-directory", cache_dir, NULL);
+        global_shell = g_object_new(COG_TYPE_SHELL, "name", "cogbridge", "automated", false, "web-data-manager",
+                                    data_manager, NULL);
+    }
+#endif
     if (!global_shell) {
         g_set_error(error, g_quark_from_static_string("cogbridge"), 2,
                     "Failed to create CogShell");
@@ -279,9 +334,13 @@ cogbridge_init(const CogBridgeConfig *config, GError **error)
         return false;
     }
 
+    if (global_config.memory_monitor)
+        cog_shell_set_memory_monitor(global_shell, true);
+
     // Create main loop
     global_main_loop = g_main_loop_new(NULL, false);
 
+    cog_profile_end("cogbridge: init");
     g_message("CogBridge initialized successfully");
     return true;
 }
@@ -303,6 +362,10 @@ cogbridge_cleanup(void)
         global_shell = NULL;
     }
 
+#if COG_USE_WPE2
+    g_clear_object(&global_network_session);
+#endif
+
     g_message("CogBridge cleaned up");
 }
 
@@ -317,6 +380,8 @@ cogbridge_new(const char *name)
                                                      g_free, (GDestroyNotify)bound_function_data_free);
     bridge->is_ready = false;
 
+    cog_profile_begin("cogbridge: view");
+
     // Create viewport
     bridge->viewport = cog_viewport_new();
     
@@ -328,7 +393,12 @@ cogbridge_new(const char *name)
         view_type = platform_class->get_view_type();
     }
     
-    bridge->view = g_object_new(view_type, NULL);
+    // Use the shell web context, which owns the configured storage directories
+    bridge->view = g_object_new(view_type, "web-context", cog_shell_get_web_context(global_shell),
+#if COG_USE_WPE2
+                                "network-session", global_network_session,
+#endif
+                                NULL);
     bridge->webview = WEBKIT_WEB_VIEW(bridge->view);
 
     // Initialize web view with platform
@@ -348,6 +418,8 @@ cogbridge_new(const char *name)
 #endif
     g_signal_connect(bridge->webview, "load-changed",
                      G_CALLBACK(on_load_changed), bridge);
+    g_signal_connect(global_shell, "notify::memory-pressure",
+                     G_CALLBACK(on_memory_pressure), bridge);
 
     // Register message handler for function calls
 #if COG_USE_WPE2
@@ -409,6 +481,7 @@ cogbridge_new(const char *name)
     webkit_user_content_manager_add_script(bridge->content_manager, script);
     webkit_user_script_unref(script);
 
+    cog_profile_end("cogbridge: view");
     g_message("CogBridge instance created: %s", bridge->name);
     return bridge;
 }
@@ -420,6 +493,9 @@ cogbridge_free(CogBridge *bridge)
 
     g_message("Freeing CogBridge instance: %s", bridge->name);
 
+    if (global_shell)
+        g_signal_handlers_disconnect_by_data(global_shell, bridge);
+
     if (bridge->bound_functions)
         g_hash_table_destroy(bridge->bound_functions);
 
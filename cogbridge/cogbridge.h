@@ -66,12 +66,15 @@ typedef char *(*CogBridgeCallbackFunc)(CogBridge     *bridge,
  * @height: Viewport height (default: 1080)
  * @enable_console: Enable console messages (default: true)
  * @enable_developer_extras: Enable developer tools (default: false)
- * @cache_dir: Cache directory path (NULL for default)
- * @data_dir: Data directory path (NULL for default)
+ * @cache_dir: Base cache directory path, which holds the disk cache (NULL for default)
+ * @data_dir: Base data directory path, which holds local storage and databases (NULL for default)
  * @user_agent: Custom user agent string (NULL for default)
  * @platform: Platform backend to use (default: COGBRIDGE_PLATFORM_AUTO)
  * @platform_name: Platform name string (deprecated, use @platform instead; NULL for auto)
  * @module_dir: Platform module directory (NULL to use built-in or COG_MODULEDIR env var)
+ * @startup_profile: Print how long each startup phase took once the first page has loaded (default: false)
+ * @memory_monitor: Give memory back under memory pressure, and emit the "memory-pressure"
+ *   event to JavaScript listeners of every bridge when the level changes (default: false)
  *
  * Configuration structure for CogBridge initialization.
  * 
@@ -89,6 +92,8 @@ typedef struct {
     CogBridgePlatform    platform;
     const char          *platform_name;  /* Deprecated */
     const char          *module_dir;
+    bool                 startup_profile;
+    bool                 memory_monitor;
 } CogBridgeConfig;
 
 /**
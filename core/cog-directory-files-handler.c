@@ -6,6 +6,7 @@
  */
 
 #include "cog-directory-files-handler.h"
+#include "cog-metrics.h"
 #include <gio/gio.h>
 
 /**
@@ -48,6 +49,15 @@ static void* s_request_resolving_index = (void*) 0xCAFECAFE;
 G_DEFINE_QUARK (cog-directory-files-handler-data, cog_directory_files_handler);
 
 
+static void
+request_finish_error (WebKitURISchemeRequest *request,
+                      GError                 *error)
+{
+    cog_metrics_add (COG_METRIC_REQUEST_ERRORS, 1);
+    webkit_uri_scheme_request_finish_error (request, error);
+}
+
+
 static void
 on_file_read_async_completed (GObject      *source_object,
                               GAsyncResult *result,
@@ -75,7 +85,7 @@ on_file_read_async_completed (GObject      *source_object,
          * TODO: Generate a nicer error page.
          */
         g_assert (error);
-        webkit_uri_scheme_request_finish_error (request, error);
+        request_finish_error (request, error);
     }
 }
 
@@ -93,7 +103,7 @@ on_file_query_info_async_completed (GObject      *source_object,
 
     if (!info) {
         g_assert (error);
-        webkit_uri_scheme_request_finish_error (request, error);
+        request_finish_error (request, error);
         return;
     }
 
@@ -129,7 +139,7 @@ on_file_query_info_async_completed (GObject      *source_object,
                                  COG_DIRECTORY_FILES_HANDLER_ERROR_CANNOT_RESOLVE,
                                  "Path '%s' does not represent a regular file",
                                  path);
-            webkit_uri_scheme_request_finish_error (request, error);
+            request_finish_error (request, error);
         } else {
             /* Mark request as being resolved for its index. */
             g_object_set_qdata (G_OBJECT (request),
@@ -150,7 +160,7 @@ on_file_query_info_async_completed (GObject      *source_object,
                              COG_DIRECTORY_FILES_HANDLER_ERROR_CANNOT_RESOLVE,
                              "Path '%s' does not represent a regular file or directory",
                              path);
-        webkit_uri_scheme_request_finish_error (request, error);
+        request_finish_error (request, error);
     }
 }
 
@@ -202,7 +212,7 @@ cog_directory_files_handler_run (CogRequestHandler      *request_handler,
             g_autofree char *uri_string = g_uri_to_string(uri);
 #endif
             g_autoptr(GError) error = g_error_new(G_FILE_ERROR, G_FILE_ERROR_INVAL, "No host in URI: %s", uri_string);
-            webkit_uri_scheme_request_finish_error (request, error);
+            request_finish_error (request, error);
             return;
         }
         base_path = g_file_get_child (handler->base_path, host);
@@ -256,7 +266,7 @@ cog_directory_files_handler_run (CogRequestHandler      *request_handler,
                                                    "contained in base path '%s'",
                                                    g_file_peek_path (file),
                                                    g_file_peek_path (base_path));
-            return webkit_uri_scheme_request_finish_error (request, error);
+            return request_finish_error (request, error);
         }
     }
 
@@ -0,0 +1,388 @@
+/*
+ * cog-disk-cache.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-disk-cache.h"
+
+#include <errno.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*
+ * Maintenance of the WebKit network cache, which lives in the "WebKitCache"
+ * subdirectory of the base cache directory. It contains one directory per
+ * cache format version, and WebKit removes the ones it does not understand.
+ * These functions are meant to be used before the network process starts,
+ * because the cache contents are indexed only when it opens the cache.
+ */
+
+#define NETWORK_CACHE_SUBDIR "WebKitCache"
+#define SEEDING_SUFFIX       ".seeding"
+
+/*
+ * Record bodies are stored in the "Blobs" directory and hard linked next to
+ * their record as "<record>-blob", with one link per record using the body.
+ * Space is accounted per inode, and is only given back once the last link
+ * other than the one in "Blobs" is gone, which then gets removed as well.
+ */
+#define BLOBS_SUBDIR  "Blobs"
+#define RECORD_SUFFIX "-blob"
+
+typedef struct {
+    dev_t   dev;
+    ino_t   ino;
+    guint64 size;
+    nlink_t links;
+    char   *blobs_path;
+} Inode;
+
+typedef struct {
+    char    *path;
+    Inode   *inode;
+    char    *blob_path;
+    Inode   *blob_inode;
+    int64_t  time;
+} Entry;
+
+static void
+inode_free(Inode *inode)
+{
+    g_free(inode->blobs_path);
+    g_free(inode);
+}
+
+static unsigned
+inode_hash(const void *key)
+{
+    const Inode *inode = key;
+    const guint64 value = (guint64) inode->ino ^ ((guint64) inode->dev << 32);
+    return (unsigned) (value ^ (value >> 32));
+}
+
+static gboolean
+inode_equal(const void *a, const void *b)
+{
+    const Inode *ia = a, *ib = b;
+    return ia->ino == ib->ino && ia->dev == ib->dev;
+}
+
+static void
+entry_clear(Entry *entry)
+{
+    g_free(entry->path);
+    g_free(entry->blob_path);
+}
+
+static gboolean
+set_error_from_errno(GError **error, int saved_errno, const char *message, const char *path)
+{
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno), "%s '%s': %s", message, path,
+                g_strerror(saved_errno));
+    return FALSE;
+}
+
+static void
+remove_tree(const char *path)
+{
+    GStatBuf st;
+    if (g_lstat(path, &st) != 0)
+        return;
+
+    if (S_ISDIR(st.st_mode)) {
+        g_autoptr(GDir) dir = g_dir_open(path, 0, NULL);
+        const char     *name;
+        while (dir && (name = g_dir_read_name(dir))) {
+            g_autofree char *child = g_build_filename(path, name, NULL);
+            remove_tree(child);
+        }
+    }
+    g_remove(path);
+}
+
+static gboolean
+copy_tree(GFile *source, GFile *target, GError **error)
+{
+    g_autoptr(GFileInfo) info =
+        g_file_query_info(source, G_FILE_ATTRIBUTE_STANDARD_TYPE, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, error);
+    if (!info)
+        return FALSE;
+
+    switch (g_file_info_get_file_type(info)) {
+    case G_FILE_TYPE_REGULAR:
+        return g_file_copy(source, target, G_FILE_COPY_NOFOLLOW_SYMLINKS, NULL, NULL, NULL, error);
+
+    case G_FILE_TYPE_DIRECTORY: {
+        if (!g_file_make_directory(target, NULL, error))
+            return FALSE;
+
+        g_autoptr(GFileEnumerator) children =
+            g_file_enumerate_children(source, G_FILE_ATTRIBUTE_STANDARD_NAME, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                      NULL, error);
+        if (!children)
+            return FALSE;
+
+        for (;;) {
+            GFile *child = NULL;
+            if (!g_file_enumerator_iterate(children, NULL, &child, NULL, error))
+                return FALSE;
+            if (!child)
+                return TRUE;
+
+            g_autofree char *name = g_file_get_basename(child);
+            g_autoptr(GFile) target_child = g_file_get_child(target, name);
+            if (!copy_tree(child, target_child, error))
+                return FALSE;
+        }
+    }
+
+    default:
+        /* WebKit does not create anything else, ignore it. */
+        return TRUE;
+    }
+}
+
+/**
+ * cog_disk_cache_seed:
+ * @cache_dir: Base cache directory.
+ * @seed_dir: Directory with the contents used to seed the cache.
+ * @error: Location where to store an error.
+ *
+ * Preloads the network cache from a copy of the `WebKitCache` directory
+ * taken from another device, typically shipped read-only as part of the
+ * system image. Each version directory found in @seed_dir is copied into
+ * the cache unless the cache already has one with the same name, so the
+ * contents of an existing cache are never overwritten, while updating
+ * to a WebKit version which uses a new format picks the seed up again.
+ *
+ * Directories are copied aside and moved into place once complete, so an
+ * interrupted copy does not leave a partially seeded cache behind.
+ *
+ * This must be called before the network process is started.
+ *
+ * Returns: Whether seeding succeeded.
+ *
+ * Since: 0.20
+ */
+gboolean
+cog_disk_cache_seed(const char *cache_dir, const char *seed_dir, GError **error)
+{
+    g_return_val_if_fail(cache_dir, FALSE);
+    g_return_val_if_fail(seed_dir, FALSE);
+
+    const int64_t start = g_get_monotonic_time();
+
+    g_autoptr(GDir) dir = g_dir_open(seed_dir, 0, error);
+    if (!dir)
+        return FALSE;
+
+    g_autofree char *target_dir = g_build_filename(cache_dir, NETWORK_CACHE_SUBDIR, NULL);
+    if (g_mkdir_with_parents(target_dir, 0700) != 0)
+        return set_error_from_errno(error, errno, "Cannot create directory", target_dir);
+
+    unsigned    copied = 0;
+    const char *name;
+    while ((name = g_dir_read_name(dir))) {
+        if (g_str_has_suffix(name, SEEDING_SUFFIX))
+            continue;
+
+        g_autofree char *target_path = g_build_filename(target_dir, name, NULL);
+        if (g_file_test(target_path, G_FILE_TEST_EXISTS))
+            continue;
+
+        g_autofree char *partial_path = g_strconcat(target_path, SEEDING_SUFFIX, NULL);
+        remove_tree(partial_path);
+
+        g_autofree char *source_path = g_build_filename(seed_dir, name, NULL);
+        g_autoptr(GFile) source = g_file_new_for_path(source_path);
+        g_autoptr(GFile) partial = g_file_new_for_path(partial_path);
+        if (!copy_tree(source, partial, error)) {
+            remove_tree(partial_path);
+            return FALSE;
+        }
+        if (g_rename(partial_path, target_path) != 0) {
+            int saved_errno = errno;
+            remove_tree(partial_path);
+            return set_error_from_errno(error, saved_errno, "Cannot move into place", target_path);
+        }
+        copied++;
+    }
+
+    g_debug("%s: Copied %u entries from %s in %.1f ms.", G_STRFUNC, copied, seed_dir,
+            (g_get_monotonic_time() - start) / 1000.0);
+    return TRUE;
+}
+
+static Inode *
+lookup_inode(GHashTable *inodes, const GStatBuf *st, guint64 *total)
+{
+    Inode  key = {.dev = st->st_dev, .ino = st->st_ino};
+    Inode *inode = g_hash_table_lookup(inodes, &key);
+    if (!inode) {
+        inode = g_new0(Inode, 1);
+        *inode = key;
+        /* Allocated blocks, which is what counts on a size limited file system. */
+        inode->size = (guint64) st->st_blocks * 512;
+        inode->links = st->st_nlink;
+        g_hash_table_add(inodes, inode);
+        *total += inode->size;
+    }
+    return inode;
+}
+
+static gboolean
+collect_entries(const char *path, gboolean in_blobs, GArray *entries, GHashTable *inodes, guint64 *total,
+                GError **error)
+{
+    g_autoptr(GDir) dir = g_dir_open(path, 0, error);
+    if (!dir)
+        return FALSE;
+
+    /* Record names to their index in the array plus one, to attach bodies to their record. */
+    g_autoptr(GHashTable) records = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    g_autoptr(GPtrArray)  bodies = g_ptr_array_new_with_free_func(g_free);
+
+    const char *name;
+    while ((name = g_dir_read_name(dir))) {
+        /* Entries are keyed by a hash salted with this file, removing it would invalidate all of them. */
+        if (g_str_equal(name, "salt"))
+            continue;
+
+        g_autofree char *child = g_build_filename(path, name, NULL);
+
+        GStatBuf st;
+        if (g_lstat(child, &st) != 0)
+            continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            if (!collect_entries(child, g_str_equal(name, BLOBS_SUBDIR), entries, inodes, total, error))
+                return FALSE;
+        } else if (S_ISREG(st.st_mode)) {
+            Inode *inode = lookup_inode(inodes, &st, total);
+            if (in_blobs) {
+                g_free(inode->blobs_path);
+                inode->blobs_path = g_steal_pointer(&child);
+            } else if (g_str_has_suffix(name, RECORD_SUFFIX)) {
+                g_ptr_array_add(bodies, g_strdup(name));
+            } else {
+                Entry entry = {
+                    .path = g_steal_pointer(&child),
+                    .inode = inode,
+                    .time = MAX(st.st_atime, st.st_mtime),
+                };
+                g_array_append_val(entries, entry);
+                g_hash_table_insert(records, g_strdup(name), GUINT_TO_POINTER(entries->len));
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < bodies->len; i++) {
+        const char      *body = g_ptr_array_index(bodies, i);
+        g_autofree char *record = g_strndup(body, strlen(body) - strlen(RECORD_SUFFIX));
+        g_autofree char *child = g_build_filename(path, body, NULL);
+
+        GStatBuf st;
+        if (g_lstat(child, &st) != 0)
+            continue;
+
+        /* A body without its record is evicted on its own. */
+        unsigned index = GPOINTER_TO_UINT(g_hash_table_lookup(records, record));
+        if (!index) {
+            Entry entry = {.time = MAX(st.st_atime, st.st_mtime)};
+            g_array_append_val(entries, entry);
+            index = entries->len;
+        }
+
+        Entry *entry = &g_array_index(entries, Entry, index - 1);
+        entry->blob_path = g_steal_pointer(&child);
+        entry->blob_inode = lookup_inode(inodes, &st, total);
+        entry->time = MAX(entry->time, MAX(st.st_atime, st.st_mtime));
+    }
+    return TRUE;
+}
+
+static int
+compare_entries(const void *a, const void *b)
+{
+    const Entry *ea = a, *eb = b;
+    return (ea->time > eb->time) - (ea->time < eb->time);
+}
+
+/*
+ * Removes one link to an inode, and returns the amount of space given back.
+ */
+static guint64
+remove_link(const char *path, Inode *inode)
+{
+    if (g_unlink(path) != 0)
+        return 0;
+
+    if (--inode->links == 1 && inode->blobs_path && g_unlink(inode->blobs_path) == 0)
+        inode->links = 0;
+
+    return inode->links ? 0 : inode->size;
+}
+
+/**
+ * cog_disk_cache_trim:
+ * @cache_dir: Base cache directory.
+ * @max_size: Maximum size in bytes.
+ * @error: Location where to store an error.
+ *
+ * Removes network cache entries, least recently used first, until the
+ * space used by the cache is at most @max_size bytes.
+ *
+ * WebKit bounds the size of the cache by itself, based on the cache model
+ * and the free space available, which may be too much for small flash
+ * storage shared with other applications. Entries which get removed by
+ * this function are refetched from the network when needed.
+ *
+ * This must be called before the network process is started.
+ *
+ * Returns: Whether trimming succeeded.
+ *
+ * Since: 0.20
+ */
+gboolean
+cog_disk_cache_trim(const char *cache_dir, guint64 max_size, GError **error)
+{
+    g_return_val_if_fail(cache_dir, FALSE);
+
+    g_autofree char *path = g_build_filename(cache_dir, NETWORK_CACHE_SUBDIR, NULL);
+    if (!g_file_test(path, G_FILE_TEST_IS_DIR))
+        return TRUE;
+
+    /* Declared first, so that it outlives the entries pointing into it. */
+    g_autoptr(GHashTable) inodes = g_hash_table_new_full(inode_hash, inode_equal, (GDestroyNotify) inode_free, NULL);
+
+    g_autoptr(GArray) entries = g_array_new(FALSE, FALSE, sizeof(Entry));
+    g_array_set_clear_func(entries, (GDestroyNotify) entry_clear);
+
+    guint64 total = 0;
+    if (!collect_entries(path, FALSE, entries, inodes, &total, error))
+        return FALSE;
+
+    if (total <= max_size)
+        return TRUE;
+
+    const guint64 initial = total;
+    g_array_sort(entries, compare_entries);
+
+    unsigned removed = 0;
+    for (unsigned i = 0; i < entries->len && total > max_size; i++) {
+        const Entry *entry = &g_array_index(entries, Entry, i);
+        if (entry->path)
+            total -= remove_link(entry->path, entry->inode);
+        if (entry->blob_path)
+            total -= remove_link(entry->blob_path, entry->blob_inode);
+        removed++;
+    }
+
+    g_debug("%s: Removed %u entries, from %" G_GUINT64_FORMAT " to %" G_GUINT64_FORMAT " bytes.", G_STRFUNC,
+            removed, initial, total);
+    return TRUE;
+}
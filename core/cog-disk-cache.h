@@ -0,0 +1,22 @@
+/*
+ * cog-disk-cache.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#if !(defined(COG_INSIDE_COG__) && COG_INSIDE_COG__)
+#    error "Do not include this header directly, use <cog.h> instead"
+#endif
+
+#include "cog-export.h"
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+COG_API gboolean cog_disk_cache_seed(const char *cache_dir, const char *seed_dir, GError **error);
+COG_API gboolean cog_disk_cache_trim(const char *cache_dir, guint64 max_size, GError **error);
+
+G_END_DECLS
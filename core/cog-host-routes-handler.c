@@ -6,6 +6,7 @@
  */
 
 #include "cog-host-routes-handler.h"
+#include "cog-metrics.h"
 #include "cog-directory-files-handler.h"
 
 /**
@@ -75,6 +76,7 @@ cog_host_routes_handler_run_fallback(CogHostRoutesHandler *self, WebKitURIScheme
                                               G_FILE_ERROR_NOENT,
                                               "No file for URI path: %s",
                                               webkit_uri_scheme_request_get_path(request));
+        cog_metrics_add(COG_METRIC_REQUEST_ERRORS, 1);
         webkit_uri_scheme_request_finish_error(request, error);
     }
 }
@@ -0,0 +1,22 @@
+/*
+ * cog-memory-monitor-private.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "cog-shell.h"
+
+G_BEGIN_DECLS
+
+typedef struct _CogMemoryMonitor CogMemoryMonitor;
+
+typedef void (*CogMemoryMonitorFunc)(CogMemoryPressure level, void *userdata);
+
+CogMemoryMonitor *cog_memory_monitor_new(CogMemoryMonitorFunc callback, void *userdata);
+void              cog_memory_monitor_free(CogMemoryMonitor *self);
+CogMemoryPressure cog_memory_monitor_get_level(CogMemoryMonitor *self);
+
+G_END_DECLS
@@ -0,0 +1,384 @@
+/*
+ * cog-memory-monitor.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-memory-monitor-private.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib-unix.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Memory pressure level tracking, from two kernel sources:
+ *
+ * - Pressure stall information (PSI) in /proc/pressure/memory. Triggers are
+ *   registered for each level, which wake up the monitor only when stalls
+ *   exceed the threshold; without permission to register them, the stall
+ *   averages are sampled periodically instead.
+ * - The memory.events file of the cgroup v2 the process belongs to, whose
+ *   "high", "max", and "oom" counters increase when the limits of the group
+ *   are reached. The kernel notifies changes, so the file is not polled.
+ *
+ * Levels are raised immediately, but only lowered one step at a time after
+ * pressure stays below half the threshold for HOLD_MS, so the reactions to
+ * pressure do not flap back and forth.
+ */
+
+#define N_LEVELS (COG_MEMORY_PRESSURE_CRITICAL + 1)
+
+#define PSI_PATH   "/proc/pressure/memory"
+#define HOLD_MS    10000
+#define SAMPLE_MS  2000
+#define EXIT_RATIO 0.5
+
+/* clang-format off */
+static const struct {
+    const char *trigger;   /* Stall time (µs) per window (µs). */
+    const char *kind;      /* PSI line used when sampling. */
+    double      threshold; /* Percentage of the average over 10 s. */
+} s_levels[N_LEVELS] = {
+    [COG_MEMORY_PRESSURE_MODERATE] = { "some 200000 2000000", "some", 10.0 },
+    [COG_MEMORY_PRESSURE_CRITICAL] = { "full 100000 2000000", "full",  5.0 },
+};
+/* clang-format on */
+
+typedef enum {
+    CGROUP_EVENT_HIGH,
+    CGROUP_EVENT_MAX,
+    CGROUP_EVENT_OOM,
+    CGROUP_EVENT_OOM_KILL,
+    N_CGROUP_EVENTS,
+} CgroupEvent;
+
+static const char *const s_cgroup_events[N_CGROUP_EVENTS] = {"high", "max", "oom", "oom_kill"};
+
+struct _CogMemoryMonitor {
+    CogMemoryMonitorFunc callback;
+    void                *userdata;
+
+    CogMemoryPressure level;
+    int64_t           calm_since; /* Zero while pressure is above the exit threshold. */
+
+    int   psi_fd;
+    int   trigger_fd[N_LEVELS];
+    guint trigger_id[N_LEVELS];
+    guint sample_id;
+
+    int      events_fd;
+    guint    events_id;
+    uint64_t events[N_CGROUP_EVENTS];
+
+    struct {
+        int64_t  level_start;
+        int64_t  time[N_LEVELS];
+        unsigned entered[N_LEVELS];
+        uint64_t cgroup_events[N_CGROUP_EVENTS];
+    } stats;
+};
+
+static bool
+psi_read_averages(int fd, double avg10[N_LEVELS])
+{
+    char    buffer[256];
+    ssize_t n = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0)
+        return false;
+    buffer[n] = '\0';
+
+    avg10[COG_MEMORY_PRESSURE_NONE] = 0.0;
+    for (CogMemoryPressure level = COG_MEMORY_PRESSURE_MODERATE; level < N_LEVELS; level++) {
+        const char *line = strstr(buffer, s_levels[level].kind);
+        if (!line || sscanf(line + strlen(s_levels[level].kind), " avg10=%lf", &avg10[level]) != 1)
+            return false;
+    }
+    return true;
+}
+
+static void
+account_level(CogMemoryMonitor *self, int64_t now)
+{
+    self->stats.time[self->level] += now - self->stats.level_start;
+    self->stats.level_start = now;
+}
+
+static bool
+has_triggers(CogMemoryMonitor *self)
+{
+    return self->trigger_id[COG_MEMORY_PRESSURE_MODERATE] || self->trigger_id[COG_MEMORY_PRESSURE_CRITICAL];
+}
+
+static gboolean on_sample(void *data);
+
+/* Sampling is only needed to notice pressure going away, unless triggers are unavailable. */
+static void
+update_sampling(CogMemoryMonitor *self)
+{
+    const bool needed = self->level > COG_MEMORY_PRESSURE_NONE || (self->psi_fd >= 0 && !has_triggers(self));
+
+    if (needed && !self->sample_id) {
+        self->sample_id = g_timeout_add(SAMPLE_MS, on_sample, self);
+        g_source_set_name_by_id(self->sample_id, "Cog: memory pressure sampling");
+    } else if (!needed) {
+        g_clear_handle_id(&self->sample_id, g_source_remove);
+    }
+}
+
+static void
+set_level(CogMemoryMonitor *self, CogMemoryPressure level)
+{
+    if (self->level == level)
+        return;
+
+    account_level(self, g_get_monotonic_time());
+    g_debug("%s: Memory pressure level %d -> %d.", G_STRFUNC, self->level, level);
+    self->level = level;
+    self->stats.entered[level]++;
+
+    update_sampling(self);
+    self->callback(level, self->userdata);
+}
+
+static void
+raise_level(CogMemoryMonitor *self, CogMemoryPressure level)
+{
+    self->calm_since = 0;
+    if (level > self->level)
+        set_level(self, level);
+}
+
+static gboolean
+on_sample(void *data)
+{
+    CogMemoryMonitor *self = data;
+
+    /* Without PSI, pressure is considered gone when the cgroup stays quiet. */
+    bool   calm = true;
+    double avg10[N_LEVELS];
+    if (self->psi_fd >= 0 && psi_read_averages(self->psi_fd, avg10)) {
+        for (CogMemoryPressure level = N_LEVELS - 1; level > COG_MEMORY_PRESSURE_NONE; level--) {
+            if (avg10[level] >= s_levels[level].threshold) {
+                raise_level(self, level);
+                break;
+            }
+        }
+        if (self->level > COG_MEMORY_PRESSURE_NONE)
+            calm = avg10[self->level] < s_levels[self->level].threshold * EXIT_RATIO;
+    }
+
+    if (self->level == COG_MEMORY_PRESSURE_NONE || !calm) {
+        self->calm_since = 0;
+        return G_SOURCE_CONTINUE;
+    }
+
+    const int64_t now = g_get_monotonic_time();
+    if (!self->calm_since) {
+        self->calm_since = now;
+    } else if (now - self->calm_since >= (int64_t) HOLD_MS * 1000) {
+        /* Each step down needs its own quiet period. */
+        self->calm_since = now;
+        set_level(self, self->level - 1);
+        return self->sample_id ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+on_trigger(int fd, GIOCondition condition, void *data)
+{
+    CogMemoryMonitor *self = data;
+
+    CogMemoryPressure level = COG_MEMORY_PRESSURE_MODERATE;
+    if (fd == self->trigger_fd[COG_MEMORY_PRESSURE_CRITICAL])
+        level = COG_MEMORY_PRESSURE_CRITICAL;
+
+    if (condition & G_IO_ERR) {
+        g_warning("Memory pressure trigger failed, sampling instead.");
+        self->trigger_id[level] = 0;
+        close(self->trigger_fd[level]);
+        self->trigger_fd[level] = -1;
+        update_sampling(self);
+        return G_SOURCE_REMOVE;
+    }
+
+    raise_level(self, level);
+    return G_SOURCE_CONTINUE;
+}
+
+static bool
+psi_add_trigger(CogMemoryMonitor *self, CogMemoryPressure level)
+{
+    int fd = open(PSI_PATH, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    const char *trigger = s_levels[level].trigger;
+    if (write(fd, trigger, strlen(trigger) + 1) < 0) {
+        g_debug("%s: Cannot add trigger '%s' (%s).", G_STRFUNC, trigger, g_strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    self->trigger_fd[level] = fd;
+    self->trigger_id[level] = g_unix_fd_add(fd, G_IO_PRI | G_IO_ERR, on_trigger, self);
+    g_source_set_name_by_id(self->trigger_id[level], "Cog: memory pressure trigger");
+    return true;
+}
+
+static void
+cgroup_read_events(CogMemoryMonitor *self, uint64_t events[N_CGROUP_EVENTS])
+{
+    char    buffer[512];
+    ssize_t n = pread(self->events_fd, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0)
+        return;
+    buffer[n] = '\0';
+
+    g_auto(GStrv) lines = g_strsplit(buffer, "\n", 0);
+    for (unsigned i = 0; lines[i]; i++) {
+        char     name[16];
+        uint64_t value;
+        if (sscanf(lines[i], "%15s %" SCNu64, name, &value) != 2)
+            continue;
+        for (CgroupEvent event = 0; event < N_CGROUP_EVENTS; event++) {
+            if (g_str_equal(name, s_cgroup_events[event]))
+                events[event] = value;
+        }
+    }
+}
+
+static gboolean
+on_cgroup_events(int fd G_GNUC_UNUSED, GIOCondition condition G_GNUC_UNUSED, void *data)
+{
+    CogMemoryMonitor *self = data;
+
+    uint64_t events[N_CGROUP_EVENTS];
+    memcpy(events, self->events, sizeof(events));
+    cgroup_read_events(self, events);
+
+    CogMemoryPressure level = COG_MEMORY_PRESSURE_NONE;
+    for (CgroupEvent event = 0; event < N_CGROUP_EVENTS; event++) {
+        if (events[event] <= self->events[event])
+            continue;
+
+        g_debug("%s: %" PRIu64 " new '%s' cgroup events.", G_STRFUNC, events[event] - self->events[event],
+                s_cgroup_events[event]);
+        self->stats.cgroup_events[event] += events[event] - self->events[event];
+        level = MAX(level, (event == CGROUP_EVENT_HIGH) ? COG_MEMORY_PRESSURE_MODERATE : COG_MEMORY_PRESSURE_CRITICAL);
+    }
+    memcpy(self->events, events, sizeof(events));
+
+    if (level != COG_MEMORY_PRESSURE_NONE)
+        raise_level(self, level);
+    return G_SOURCE_CONTINUE;
+}
+
+static char *
+cgroup_events_path(void)
+{
+    g_autofree char *contents = NULL;
+    if (!g_file_get_contents("/proc/self/cgroup", &contents, NULL, NULL))
+        return NULL;
+
+    /* The unified hierarchy is listed with an empty controller list. */
+    g_auto(GStrv) lines = g_strsplit(contents, "\n", 0);
+    for (unsigned i = 0; lines[i]; i++) {
+        if (g_str_has_prefix(lines[i], "0::/"))
+            return g_build_filename("/sys/fs/cgroup", lines[i] + 3, "memory.events", NULL);
+    }
+    return NULL;
+}
+
+static bool
+cgroup_watch_events(CogMemoryMonitor *self)
+{
+    g_autofree char *path = cgroup_events_path();
+    if (!path || (self->events_fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+        return false;
+
+    cgroup_read_events(self, self->events);
+    self->events_id = g_unix_fd_add(self->events_fd, G_IO_PRI | G_IO_ERR, on_cgroup_events, self);
+    g_source_set_name_by_id(self->events_id, "Cog: cgroup memory events");
+    g_debug("%s: Watching %s.", G_STRFUNC, path);
+    return true;
+}
+
+/*
+ * Returns %NULL when neither PSI nor the cgroup v2 memory controller are
+ * available.
+ */
+CogMemoryMonitor *
+cog_memory_monitor_new(CogMemoryMonitorFunc callback, void *userdata)
+{
+    g_return_val_if_fail(callback, NULL);
+
+    CogMemoryMonitor *self = g_new0(CogMemoryMonitor, 1);
+    *self = (CogMemoryMonitor){
+        .callback = callback,
+        .userdata = userdata,
+        .psi_fd = open(PSI_PATH, O_RDONLY | O_CLOEXEC),
+        .trigger_fd = {-1, -1, -1},
+        .events_fd = -1,
+        .stats.level_start = g_get_monotonic_time(),
+    };
+
+    if (self->psi_fd >= 0) {
+        for (CogMemoryPressure level = COG_MEMORY_PRESSURE_MODERATE; level < N_LEVELS; level++)
+            psi_add_trigger(self, level);
+        g_debug("%s: Using PSI %s.", G_STRFUNC, has_triggers(self) ? "triggers" : "sampling");
+    }
+    const bool has_cgroup = cgroup_watch_events(self);
+
+    if (self->psi_fd < 0 && !has_cgroup) {
+        g_warning("Neither PSI nor cgroup v2 memory events are available, memory pressure monitor disabled.");
+        cog_memory_monitor_free(self);
+        return NULL;
+    }
+
+    update_sampling(self);
+    return self;
+}
+
+void
+cog_memory_monitor_free(CogMemoryMonitor *self)
+{
+    if (!self)
+        return;
+
+    g_clear_handle_id(&self->sample_id, g_source_remove);
+    g_clear_handle_id(&self->events_id, g_source_remove);
+    for (CogMemoryPressure level = 0; level < N_LEVELS; level++) {
+        g_clear_handle_id(&self->trigger_id[level], g_source_remove);
+        if (self->trigger_fd[level] >= 0)
+            close(self->trigger_fd[level]);
+    }
+    if (self->events_fd >= 0)
+        close(self->events_fd);
+    if (self->psi_fd >= 0)
+        close(self->psi_fd);
+
+    account_level(self, g_get_monotonic_time());
+    g_debug("%s: Time at each level %.1f/%.1f/%.1f s, entered %u/%u/%u times; cgroup events high %" PRIu64
+            ", max %" PRIu64 ", oom %" PRIu64 ", oom_kill %" PRIu64 ".",
+            G_STRFUNC, (double) self->stats.time[0] / G_USEC_PER_SEC, (double) self->stats.time[1] / G_USEC_PER_SEC,
+            (double) self->stats.time[2] / G_USEC_PER_SEC, self->stats.entered[0], self->stats.entered[1],
+            self->stats.entered[2], self->stats.cgroup_events[CGROUP_EVENT_HIGH],
+            self->stats.cgroup_events[CGROUP_EVENT_MAX], self->stats.cgroup_events[CGROUP_EVENT_OOM],
+            self->stats.cgroup_events[CGROUP_EVENT_OOM_KILL]);
+
+    g_free(self);
+}
+
+CogMemoryPressure
+cog_memory_monitor_get_level(CogMemoryMonitor *self)
+{
+    g_return_val_if_fail(self, COG_MEMORY_PRESSURE_NONE);
+    return self->level;
+}
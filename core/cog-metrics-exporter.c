@@ -0,0 +1,405 @@
+/*
+ * cog-metrics-exporter.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-metrics-exporter.h"
+#include "cog-metrics.h"
+#include "cog-webkit-utils.h"
+
+#include <gio/gio.h>
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * Scrapes are answered from a thread of its own, which never touches
+ * state owned by the main thread. Instead, the main thread periodically
+ * copies the values into a snapshot, which the exporter thread copies out
+ * before formatting a response. Snapshots are double-buffered: the main
+ * thread fills the buffer not being read and then bumps a generation
+ * counter, whose lowest bit selects the current buffer. The exporter thread
+ * copies the current buffer again if the generation changed meanwhile, so
+ * neither side ever waits for the other.
+ *
+ * Resource usage of the web processes is read from /proc by the exporter
+ * thread when a scrape arrives, to keep file I/O away from the main loop.
+ */
+
+#define PUBLISH_INTERVAL_SECONDS 1
+#define CLIENT_TIMEOUT_SECONDS   5
+#define REQUEST_MAX_SIZE         4096
+
+#define OPENMETRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+enum {
+    SNAPSHOT_FRAME_TIME_P50 = COG_METRIC_LAST,
+    SNAPSHOT_FRAME_TIME_P90,
+    SNAPSHOT_FRAME_TIME_P99,
+    SNAPSHOT_WEB_PROCESS_CRASHES,
+    SNAPSHOT_WEB_PROCESS_OOM,
+    SNAPSHOT_WEB_PROCESS_RESTARTS,
+    SNAPSHOT_WEB_PROCESS_FAILURES,
+    N_SNAPSHOT_VALUES,
+};
+
+typedef struct {
+    const char *name;
+    const char *type;
+    const char *help;
+    double      scale; /* Zero for values reported as integers. */
+} ValueInfo;
+
+/* clang-format off */
+static const ValueInfo s_values[N_SNAPSHOT_VALUES] = {
+    [COG_METRIC_FRAMES_PRESENTED] = {"cog_frames_presented", "counter", "Frames shown on the output."},
+    [COG_METRIC_FRAMES_DROPPED] = {"cog_frames_dropped", "counter",
+                                   "Refresh cycles missed while content was being updated."},
+    [COG_METRIC_PAGE_LOADS] = {"cog_page_loads", "counter", "Page loads finished."},
+    [COG_METRIC_PAGE_LOAD_TIME] = {"cog_page_load_seconds", "counter", "Accumulated duration of page loads.", 1e-6},
+    [COG_METRIC_REQUESTS] = {"cog_requests", "counter", "Requests for custom URI schemes."},
+    [COG_METRIC_REQUEST_ERRORS] = {"cog_request_errors", "counter",
+                                   "Requests for custom URI schemes which were not found, or failed."},
+    [COG_METRIC_BRIDGE_CALLS] = {"cog_bridge_calls", "counter", "Calls from web content to bound functions."},
+    [SNAPSHOT_FRAME_TIME_P50] = {"cog_frame_time_p50_seconds", "gauge", "Median time between frames.", 1e-6},
+    [SNAPSHOT_FRAME_TIME_P90] = {"cog_frame_time_p90_seconds", "gauge",
+                                 "90th percentile of the time between frames.", 1e-6},
+    [SNAPSHOT_FRAME_TIME_P99] = {"cog_frame_time_p99_seconds", "gauge",
+                                 "99th percentile of the time between frames.", 1e-6},
+    [SNAPSHOT_WEB_PROCESS_CRASHES] = {"cog_web_process_crashes", "counter", "Web process crashes."},
+    [SNAPSHOT_WEB_PROCESS_OOM] = {"cog_web_process_memory_limit_exceeded", "counter",
+                                  "Web processes terminated for exceeding their memory limit."},
+    [SNAPSHOT_WEB_PROCESS_RESTARTS] = {"cog_web_process_restarts", "counter",
+                                       "Web processes restarted after terminating."},
+    [SNAPSHOT_WEB_PROCESS_FAILURES] = {"cog_web_process_recovery_failures", "counter",
+                                       "Web process restarts given up on."},
+};
+/* clang-format on */
+
+struct _CogMetricsExporter {
+    GSocketListener *listener;
+    GCancellable    *cancellable;
+    GThread         *thread;
+    char            *socket_path;
+    guint            publish_source;
+
+    uint64_t         snapshots[2][N_SNAPSHOT_VALUES];
+    guint            generation;
+};
+
+static void
+snapshot_read(CogMetricsExporter *self, uint64_t values[N_SNAPSHOT_VALUES])
+{
+    guint generation;
+    do {
+        generation = g_atomic_int_get(&self->generation);
+        memcpy(values, self->snapshots[generation & 1], sizeof(self->snapshots[0]));
+        /* After a publish, the next one fills the buffer which was just copied. */
+    } while ((guint) g_atomic_int_get(&self->generation) != generation);
+}
+
+static void
+append_value(GString *body, const char *name, const char *type, const char *help, double scale, uint64_t value)
+{
+    g_string_append_printf(body, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+    g_string_append_printf(body, "%s%s ", name, g_str_equal(type, "counter") ? "_total" : "");
+
+    if (scale) {
+        char buffer[G_ASCII_DTOSTR_BUF_SIZE];
+        g_string_append(body, g_ascii_formatd(buffer, sizeof(buffer), "%.6f", value * scale));
+    } else {
+        g_string_append_printf(body, "%" G_GUINT64_FORMAT, value);
+    }
+    g_string_append_c(body, '\n');
+}
+
+static GString *
+format_metrics(CogMetricsExporter *self)
+{
+    uint64_t values[N_SNAPSHOT_VALUES];
+    snapshot_read(self, values);
+
+    GString *body = g_string_sized_new(2048);
+    for (unsigned i = 0; i < N_SNAPSHOT_VALUES; i++)
+        append_value(body, s_values[i].name, s_values[i].type, s_values[i].help, s_values[i].scale, values[i]);
+
+    uint64_t rss_bytes, cpu_time_usec;
+    if (cog_metrics_get_web_process_usage(&rss_bytes, &cpu_time_usec)) {
+        append_value(body, "cog_web_process_resident_memory_bytes", "gauge", "Resident memory used by web processes.",
+                     0, rss_bytes);
+        /* Not a counter: processes which exit take the time they used with them. */
+        append_value(body, "cog_web_process_cpu_seconds", "gauge",
+                     "Processor time used by the web processes currently running.", 1e-6, cpu_time_usec);
+    }
+
+    g_string_append(body, "# EOF\n");
+    return body;
+}
+
+static gboolean
+read_request(GInputStream *input, char *buffer, size_t size, GCancellable *cancellable, GError **error)
+{
+    size_t length = 0;
+    while (length < size - 1) {
+        gssize n = g_input_stream_read(input, buffer + length, size - 1 - length, cancellable, error);
+        if (n < 0)
+            return FALSE;
+        if (n == 0)
+            break;
+
+        length += n;
+        buffer[length] = '\0';
+        if (strstr(buffer, "\r\n\r\n") || strstr(buffer, "\n\n"))
+            return TRUE;
+    }
+
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Incomplete request");
+    return FALSE;
+}
+
+static void
+serve_client(CogMetricsExporter *self, GSocketConnection *connection)
+{
+    g_socket_set_timeout(g_socket_connection_get_socket(connection), CLIENT_TIMEOUT_SECONDS);
+
+    g_autoptr(GError) error = NULL;
+    char              request[REQUEST_MAX_SIZE];
+    if (!read_request(g_io_stream_get_input_stream(G_IO_STREAM(connection)), request, sizeof(request),
+                      self->cancellable, &error)) {
+        g_debug("%s: %s", G_STRFUNC, error->message);
+        return;
+    }
+
+    const char         *status = "200 OK";
+    g_autoptr(GString)  body = NULL;
+    if (g_str_has_prefix(request, "GET ")) {
+        const char *path = request + strlen("GET ");
+        size_t      path_length = strcspn(path, " \r\n");
+        if ((path_length == 1 && path[0] == '/') ||
+            (path_length == strlen("/metrics") && strncmp(path, "/metrics", path_length) == 0))
+            body = format_metrics(self);
+        else
+            status = "404 Not Found";
+    } else {
+        status = "405 Method Not Allowed";
+    }
+
+    g_autofree char *header =
+        g_strdup_printf("HTTP/1.0 %s\r\n"
+                        "Content-Type: %s\r\n"
+                        "Content-Length: %zu\r\n"
+                        "Connection: close\r\n"
+                        "\r\n",
+                        status, body ? OPENMETRICS_CONTENT_TYPE : "text/plain", body ? body->len : 0);
+
+    GOutputStream *output = g_io_stream_get_output_stream(G_IO_STREAM(connection));
+    if (!g_output_stream_write_all(output, header, strlen(header), NULL, self->cancellable, &error) ||
+        (body && !g_output_stream_write_all(output, body->str, body->len, NULL, self->cancellable, &error))) {
+        g_debug("%s: %s", G_STRFUNC, error->message);
+        return;
+    }
+
+    g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+}
+
+static void *
+exporter_thread(void *data)
+{
+    CogMetricsExporter *self = data;
+
+    while (!g_cancellable_is_cancelled(self->cancellable)) {
+        g_autoptr(GError) error = NULL;
+        g_autoptr(GSocketConnection) connection =
+            g_socket_listener_accept(self->listener, NULL, self->cancellable, &error);
+        if (connection) {
+            serve_client(self, connection);
+        } else if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_warning("Metrics exporter cannot accept connection: %s", error->message);
+            /* Avoid spinning if the error is persistent, e.g. out of file descriptors. */
+            g_usleep(G_USEC_PER_SEC);
+        }
+    }
+    return NULL;
+}
+
+static gboolean
+on_publish_timeout(void *userdata)
+{
+    cog_metrics_exporter_publish(userdata);
+    return G_SOURCE_CONTINUE;
+}
+
+static GSocketAddress *
+parse_address(const char *address, char **socket_path, GError **error)
+{
+    const char *path = g_str_has_prefix(address, "unix:") ? address + strlen("unix:") : NULL;
+    if (!path && g_path_is_absolute(address))
+        path = address;
+
+    if (path) {
+        struct sockaddr_un addr = {.sun_family = AF_UNIX};
+        if (!*path || strlen(path) >= sizeof(addr.sun_path)) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid socket path '%s'", path);
+            return NULL;
+        }
+        strcpy(addr.sun_path, path);
+
+        /*
+         * Left behind by a previous instance which did not exit cleanly, if
+         * nothing accepts connections on it. A socket still in use is left
+         * alone, and binding fails.
+         */
+        GStatBuf st;
+        if (g_lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+            int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd >= 0) {
+                if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 && errno == ECONNREFUSED)
+                    g_unlink(path);
+                close(fd);
+            }
+        }
+
+        *socket_path = g_strdup(path);
+        return g_socket_address_new_from_native(&addr, sizeof(addr));
+    }
+
+    const char *port_text = g_str_has_prefix(address, "localhost:") ? address + strlen("localhost:") : address;
+    char       *end = NULL;
+    guint64     port = g_ascii_strtoull(port_text, &end, 10);
+    if (!g_ascii_isdigit(*port_text) || *end || port == 0 || port > G_MAXUINT16) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid address '%s'", address);
+        return NULL;
+    }
+
+    /* Only reachable from the device itself, there is no access control. */
+    g_autoptr(GInetAddress) loopback = g_inet_address_new_loopback(G_SOCKET_FAMILY_IPV4);
+    return g_inet_socket_address_new(loopback, port);
+}
+
+/**
+ * cog_metrics_exporter_new:
+ * @address: Where to listen for connections.
+ * @error: Location where to store an error.
+ *
+ * Creates an exporter which serves metrics over HTTP, in the OpenMetrics
+ * text format, so they can be scraped by a monitoring agent.
+ *
+ * The @address may be the path of a Unix domain socket, optionally prefixed
+ * with `unix:`, or a TCP port number, optionally prefixed with `localhost:`,
+ * on which connections are accepted only from the loopback interface.
+ *
+ * Connections are handled in a dedicated thread. Values are published from
+ * the thread which creates the exporter every second, which must be running
+ * the default main context, and at any time using
+ * [method@MetricsExporter.publish].
+ *
+ * Returns: (transfer full) (nullable): A new exporter, or %NULL on error.
+ *
+ * Since: 0.20
+ */
+CogMetricsExporter *
+cog_metrics_exporter_new(const char *address, GError **error)
+{
+    g_return_val_if_fail(address, NULL);
+
+    g_autofree char *socket_path = NULL;
+    g_autoptr(GSocketAddress) socket_address = parse_address(address, &socket_path, error);
+    if (!socket_address)
+        return NULL;
+
+    g_autoptr(GSocketListener) listener = g_socket_listener_new();
+    if (!g_socket_listener_add_address(listener, socket_address, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                       NULL, NULL, error))
+        return NULL;
+
+    CogMetricsExporter *self = g_new0(CogMetricsExporter, 1);
+    self->listener = g_steal_pointer(&listener);
+    self->cancellable = g_cancellable_new();
+    self->socket_path = g_steal_pointer(&socket_path);
+
+    cog_metrics_exporter_publish(self);
+    self->publish_source = g_timeout_add_seconds(PUBLISH_INTERVAL_SECONDS, on_publish_timeout, self);
+
+    if (!(self->thread = g_thread_try_new("cog-metrics", exporter_thread, self, error))) {
+        cog_metrics_exporter_free(self);
+        return NULL;
+    }
+
+    g_debug("%s: Listening on %s.", G_STRFUNC, address);
+    return self;
+}
+
+/**
+ * cog_metrics_exporter_publish:
+ * @self: An exporter.
+ *
+ * Updates the values served by the exporter. This is done periodically
+ * already, and may be used to make recent changes visible sooner.
+ *
+ * This must be called from the thread which created the exporter.
+ *
+ * Since: 0.20
+ */
+void
+cog_metrics_exporter_publish(CogMetricsExporter *self)
+{
+    g_return_if_fail(self);
+
+    uint64_t values[N_SNAPSHOT_VALUES];
+    for (CogMetric metric = 0; metric < COG_METRIC_LAST; metric++)
+        values[metric] = cog_metrics_get(metric);
+
+    values[SNAPSHOT_FRAME_TIME_P50] = cog_metrics_get_frame_time_percentile(50);
+    values[SNAPSHOT_FRAME_TIME_P90] = cog_metrics_get_frame_time_percentile(90);
+    values[SNAPSHOT_FRAME_TIME_P99] = cog_metrics_get_frame_time_percentile(99);
+
+    CogWebProcessTerminationStats termination;
+    cog_web_process_get_termination_stats(&termination);
+    values[SNAPSHOT_WEB_PROCESS_CRASHES] = termination.crashed;
+    values[SNAPSHOT_WEB_PROCESS_OOM] = termination.exceeded_memory_limit;
+    values[SNAPSHOT_WEB_PROCESS_RESTARTS] = termination.restarts;
+    values[SNAPSHOT_WEB_PROCESS_FAILURES] = termination.failures;
+
+    /* Being a full barrier, bumping the generation makes the values visible before the buffer is used. */
+    const guint generation = self->generation + 1;
+    memcpy(self->snapshots[generation & 1], values, sizeof(self->snapshots[0]));
+    g_atomic_int_set(&self->generation, generation);
+}
+
+/**
+ * cog_metrics_exporter_free:
+ * @self: An exporter.
+ *
+ * Stops the exporter, waiting for a scrape in progress to finish, and
+ * frees it. The Unix domain socket, if one was used, is removed.
+ *
+ * Since: 0.20
+ */
+void
+cog_metrics_exporter_free(CogMetricsExporter *self)
+{
+    g_return_if_fail(self);
+
+    g_cancellable_cancel(self->cancellable);
+    if (self->thread)
+        g_thread_join(self->thread);
+
+    if (self->publish_source)
+        g_source_remove(self->publish_source);
+
+    g_socket_listener_close(self->listener);
+    g_object_unref(self->listener);
+    g_object_unref(self->cancellable);
+
+    if (self->socket_path)
+        g_unlink(self->socket_path);
+    g_free(self->socket_path);
+
+    g_free(self);
+}
@@ -0,0 +1,33 @@
+/*
+ * cog-metrics-exporter.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#if !(defined(COG_INSIDE_COG__) && COG_INSIDE_COG__)
+#    error "Do not include this header directly, use <cog.h> instead"
+#endif
+
+#include "cog-export.h"
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * CogMetricsExporter:
+ *
+ * Serves the values of the [enum@Metric] counters, and other statistics,
+ * in the OpenMetrics text format.
+ *
+ * Since: 0.20
+ */
+typedef struct _CogMetricsExporter CogMetricsExporter;
+
+COG_API CogMetricsExporter *cog_metrics_exporter_new(const char *address, GError **error);
+COG_API void                cog_metrics_exporter_publish(CogMetricsExporter *self);
+COG_API void                cog_metrics_exporter_free(CogMetricsExporter *self);
+
+G_END_DECLS
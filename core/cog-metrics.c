@@ -0,0 +1,284 @@
+/*
+ * cog-metrics.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-metrics.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Counters are updated and read with atomic operations, without locking,
+ * so any thread can use them. GLib provides atomic operations only for int
+ * and pointer sized values, so counters are pointer sized: on 32-bit systems
+ * they wrap around at 2^32, which consumers of the values must handle as for
+ * any other 32-bit counter. Nothing gets sampled in the background: values
+ * which need work to be obtained, like percentiles or the resource usage
+ * of the web processes, are computed when read.
+ */
+
+/* Frame intervals are recorded in 1 ms buckets; the last one holds everything longer. */
+#define FRAME_TIME_BUCKETS 101
+
+/* Longer intervals mean there was nothing to update, rather than slow frames. */
+#define FRAME_IDLE_USEC (250 * 1000)
+
+#define WEB_PROCESS_NAME "WPEWebProcess"
+
+/* clang-format off */
+static const char *const s_metric_names[COG_METRIC_LAST] = {
+    [COG_METRIC_FRAMES_PRESENTED] = "frames-presented",
+    [COG_METRIC_FRAMES_DROPPED]   = "frames-dropped",
+    [COG_METRIC_PAGE_LOADS]       = "page-loads",
+    [COG_METRIC_PAGE_LOAD_TIME]   = "page-load-time",
+    [COG_METRIC_REQUESTS]         = "requests",
+    [COG_METRIC_REQUEST_ERRORS]   = "request-errors",
+    [COG_METRIC_BRIDGE_CALLS]     = "bridge-calls",
+};
+/* clang-format on */
+
+static gsize   s_counters[COG_METRIC_LAST];
+static gsize   s_frame_times[FRAME_TIME_BUCKETS];
+static int64_t s_last_frame_time; /* Only used from the main thread. */
+
+static inline void
+counter_add(gsize *counter, uint64_t value)
+{
+    g_atomic_pointer_add(counter, (gssize) value);
+}
+
+static inline uint64_t
+counter_get(gsize *counter)
+{
+    return (gsize) g_atomic_pointer_get(counter);
+}
+
+/**
+ * cog_metrics_add:
+ * @metric: A metric.
+ * @value: Amount to add.
+ *
+ * Increments the value of a counter.
+ *
+ * This function can be called from any thread.
+ *
+ * Since: 0.20
+ */
+void
+cog_metrics_add(CogMetric metric, uint64_t value)
+{
+    g_return_if_fail(metric < COG_METRIC_LAST);
+
+    counter_add(&s_counters[metric], value);
+}
+
+/**
+ * cog_metrics_get:
+ * @metric: A metric.
+ *
+ * Reads the value of a counter. On 32-bit systems counters wrap around
+ * at 2^32.
+ *
+ * This function can be called from any thread.
+ *
+ * Returns: Current value.
+ *
+ * Since: 0.20
+ */
+uint64_t
+cog_metrics_get(CogMetric metric)
+{
+    g_return_val_if_fail(metric < COG_METRIC_LAST, 0);
+
+    return counter_get(&s_counters[metric]);
+}
+
+/**
+ * cog_metrics_get_name:
+ * @metric: A metric.
+ *
+ * Obtains a name for a metric, suitable to be used as a key when
+ * reporting its value.
+ *
+ * Returns: Name of the metric.
+ *
+ * Since: 0.20
+ */
+const char *
+cog_metrics_get_name(CogMetric metric)
+{
+    g_return_val_if_fail(metric < COG_METRIC_LAST, NULL);
+    return s_metric_names[metric];
+}
+
+/**
+ * cog_metrics_frame_presented:
+ * @time_usec: Presentation time, in microseconds of the monotonic clock.
+ * @refresh_rate: Refresh rate of the output in Hz, or zero if unknown.
+ *
+ * Records a frame being shown on the output. The time elapsed since the
+ * previous frame is used to compute frame time percentiles, and refresh
+ * cycles skipped in between are counted as dropped frames. Longer pauses
+ * are considered to be periods without updates, and ignored.
+ *
+ * Platform implementations should call this from the main thread, for
+ * their primary output. The DRM, Wayland, X11 and GTK4 platforms do; with
+ * others the frame counters and percentiles stay at zero.
+ *
+ * Since: 0.20
+ */
+void
+cog_metrics_frame_presented(int64_t time_usec, unsigned refresh_rate)
+{
+    const int64_t interval = time_usec - s_last_frame_time;
+    const gboolean have_interval = s_last_frame_time && interval > 0 && interval < FRAME_IDLE_USEC;
+    s_last_frame_time = time_usec;
+
+    uint64_t dropped = 0;
+    if (have_interval && refresh_rate) {
+        const int64_t  period = G_USEC_PER_SEC / refresh_rate;
+        const uint64_t cycles = (interval + period / 2) / period;
+        dropped = cycles > 1 ? cycles - 1 : 0;
+    }
+
+    counter_add(&s_counters[COG_METRIC_FRAMES_PRESENTED], 1);
+    if (dropped)
+        counter_add(&s_counters[COG_METRIC_FRAMES_DROPPED], dropped);
+    if (have_interval)
+        counter_add(&s_frame_times[MIN(interval / 1000, FRAME_TIME_BUCKETS - 1)], 1);
+}
+
+/**
+ * cog_metrics_get_frame_time_percentile:
+ * @percentile: Percentile, between 0 and 100.
+ *
+ * Computes a percentile of the time between presented frames, with
+ * a resolution of one millisecond.
+ *
+ * This function can be called from any thread.
+ *
+ * Returns: Frame time in microseconds, or zero if no frames have been
+ *    recorded yet.
+ *
+ * Since: 0.20
+ */
+uint64_t
+cog_metrics_get_frame_time_percentile(double percentile)
+{
+    g_return_val_if_fail(percentile >= 0.0 && percentile <= 100.0, 0);
+
+    /* Buckets are read one by one, frames recorded meanwhile may be partially included. */
+    uint64_t counts[FRAME_TIME_BUCKETS];
+    uint64_t total = 0;
+    for (unsigned i = 0; i < FRAME_TIME_BUCKETS; i++)
+        total += (counts[i] = counter_get(&s_frame_times[i]));
+
+    if (!total)
+        return 0;
+
+    const uint64_t rank = MAX(1, (uint64_t) (percentile / 100.0 * total + 0.5));
+    uint64_t       seen = 0;
+    for (unsigned i = 0; i < FRAME_TIME_BUCKETS - 1; i++) {
+        if ((seen += counts[i]) >= rank)
+            return (uint64_t) (i + 1) * 1000;
+    }
+    return FRAME_IDLE_USEC;
+}
+
+typedef struct {
+    int      pid;
+    int      ppid;
+    gboolean is_web_process;
+    uint64_t cpu_ticks;
+    uint64_t rss_pages;
+} ProcessInfo;
+
+static gboolean
+read_process_info(const char *pid_name, ProcessInfo *info)
+{
+    g_autofree char *path = g_build_filename("/proc", pid_name, "stat", NULL);
+    g_autofree char *contents = NULL;
+    if (!g_file_get_contents(path, &contents, NULL, NULL))
+        return FALSE;
+
+    /* The command name may contain spaces and parentheses, fields resume after the last one. */
+    const char *name_start = strchr(contents, '(');
+    const char *name_end = strrchr(contents, ')');
+    if (!name_start || !name_end || name_end < name_start)
+        return FALSE;
+
+    unsigned long utime, stime;
+    long          rss;
+    if (sscanf(name_end + 2,
+               "%*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu %*d %*d %*d %*d %*d %*d %*llu %*lu %ld", &info->ppid,
+               &utime, &stime, &rss) != 4)
+        return FALSE;
+
+    info->pid = atoi(pid_name);
+    info->is_web_process = (size_t) (name_end - name_start - 1) == strlen(WEB_PROCESS_NAME) &&
+                           strncmp(name_start + 1, WEB_PROCESS_NAME, strlen(WEB_PROCESS_NAME)) == 0;
+    info->cpu_ticks = utime + stime;
+    info->rss_pages = MAX(rss, 0);
+    return TRUE;
+}
+
+/**
+ * cog_metrics_get_web_process_usage:
+ * @rss_bytes: (out): Location where to store the resident memory size.
+ * @cpu_time_usec: (out): Location where to store the processor time used.
+ *
+ * Obtains the resources used by web processes launched by the current
+ * process, added up. Web processes launched through an intermediate
+ * process, like the sandbox, are included.
+ *
+ * This scans the process list, so it should not be called frequently.
+ *
+ * Returns: Whether the values could be obtained.
+ *
+ * Since: 0.20
+ */
+gboolean
+cog_metrics_get_web_process_usage(uint64_t *rss_bytes, uint64_t *cpu_time_usec)
+{
+    g_return_val_if_fail(rss_bytes, FALSE);
+    g_return_val_if_fail(cpu_time_usec, FALSE);
+
+    g_autoptr(GDir) dir = g_dir_open("/proc", 0, NULL);
+    if (!dir)
+        return FALSE;
+
+    g_autoptr(GArray) processes = g_array_new(FALSE, FALSE, sizeof(ProcessInfo));
+    const char       *name;
+    while ((name = g_dir_read_name(dir))) {
+        ProcessInfo info;
+        if (g_ascii_isdigit(*name) && read_process_info(name, &info))
+            g_array_append_val(processes, info);
+    }
+
+    const int self = getpid();
+    uint64_t  ticks = 0, pages = 0;
+    for (unsigned i = 0; i < processes->len; i++) {
+        const ProcessInfo *info = &g_array_index(processes, ProcessInfo, i);
+        if (!info->is_web_process)
+            continue;
+
+        gboolean is_descendant = info->ppid == self;
+        for (unsigned j = 0; !is_descendant && j < processes->len; j++) {
+            const ProcessInfo *parent = &g_array_index(processes, ProcessInfo, j);
+            is_descendant = parent->pid == info->ppid && parent->ppid == self;
+        }
+        if (is_descendant) {
+            ticks += info->cpu_ticks;
+            pages += info->rss_pages;
+        }
+    }
+
+    *rss_bytes = pages * sysconf(_SC_PAGESIZE);
+    *cpu_time_usec = ticks * G_USEC_PER_SEC / sysconf(_SC_CLK_TCK);
+    return TRUE;
+}
@@ -0,0 +1,59 @@
+/*
+ * cog-metrics.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#if !(defined(COG_INSIDE_COG__) && COG_INSIDE_COG__)
+#    error "Do not include this header directly, use <cog.h> instead"
+#endif
+
+#include "cog-export.h"
+#include <glib.h>
+#include <stdint.h>
+
+G_BEGIN_DECLS
+
+/**
+ * CogMetric:
+ * @COG_METRIC_FRAMES_PRESENTED: Frames shown on the output.
+ * @COG_METRIC_FRAMES_DROPPED: Refresh cycles missed while content was
+ *    being updated.
+ * @COG_METRIC_PAGE_LOADS: Page loads finished.
+ * @COG_METRIC_PAGE_LOAD_TIME: Accumulated duration of the page loads,
+ *    in microseconds.
+ * @COG_METRIC_REQUESTS: Requests for custom URI schemes.
+ * @COG_METRIC_REQUEST_ERRORS: Requests for custom URI schemes which were
+ *    not found, or failed.
+ * @COG_METRIC_BRIDGE_CALLS: Calls from web content to functions bound
+ *    with the CogBridge library.
+ * @COG_METRIC_LAST: Number of metrics.
+ *
+ * Counters which can be read with [func@metrics_get].
+ *
+ * Since: 0.20
+ */
+typedef enum {
+    COG_METRIC_FRAMES_PRESENTED,
+    COG_METRIC_FRAMES_DROPPED,
+    COG_METRIC_PAGE_LOADS,
+    COG_METRIC_PAGE_LOAD_TIME,
+    COG_METRIC_REQUESTS,
+    COG_METRIC_REQUEST_ERRORS,
+    COG_METRIC_BRIDGE_CALLS,
+    COG_METRIC_LAST,
+} CogMetric;
+
+COG_API void        cog_metrics_add(CogMetric metric, uint64_t value);
+COG_API uint64_t    cog_metrics_get(CogMetric metric);
+COG_API const char *cog_metrics_get_name(CogMetric metric);
+
+COG_API void     cog_metrics_frame_presented(int64_t time_usec, unsigned refresh_rate);
+COG_API uint64_t cog_metrics_get_frame_time_percentile(double percentile);
+
+COG_API gboolean cog_metrics_get_web_process_usage(uint64_t *rss_bytes, uint64_t *cpu_time_usec);
+
+G_END_DECLS
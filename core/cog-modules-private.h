@@ -0,0 +1,16 @@
+/*
+ * cog-modules-private.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "cog-modules.h"
+
+G_BEGIN_DECLS
+
+void cog_modules_forget_probe(void);
+
+G_END_DECLS
@@ -5,10 +5,12 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include "cog-modules.h"
+#include "cog-modules-private.h"
 
 #include "cog-config.h"
 #include "cog-fallback-platform.h"
+#include "cog-profile.h"
+#include <glib/gstdio.h>
 
 struct ExtensionPoints {
     GIOExtensionPoint *platform;
@@ -49,6 +51,192 @@ ensure_builtin_types(void)
     g_once(&once, ensure_builtin_types_internal, (void *) G_STRFUNC);
 }
 
+static GIOModuleScope *
+get_module_scope(void)
+{
+    static GIOModuleScope *scope = NULL;
+    if (!scope)
+        scope = g_io_module_scope_new(G_IO_MODULE_SCOPE_BLOCK_DUPLICATES);
+    return scope;
+}
+
+G_LOCK_DEFINE_STATIC(module_scan);
+
+/*
+ * Statically linked modules use a type module which does nothing when loaded
+ * or unloaded, besides registering their types the first time it is used.
+ */
+struct _CogStaticModule {
+    GTypeModule        parent;
+    CogModulesLoadFunc load_func;
+};
+
+G_DECLARE_FINAL_TYPE(CogStaticModule, cog_static_module, COG, STATIC_MODULE, GTypeModule)
+G_DEFINE_TYPE(CogStaticModule, cog_static_module, G_TYPE_TYPE_MODULE)
+
+static gboolean
+cog_static_module_load(GTypeModule *type_module)
+{
+    CogStaticModule *self = COG_STATIC_MODULE(type_module);
+    if (self->load_func) {
+        (*self->load_func)((GIOModule *) type_module);
+        self->load_func = NULL;
+    }
+    return TRUE;
+}
+
+static void
+cog_static_module_unload(GTypeModule *type_module G_GNUC_UNUSED)
+{
+}
+
+static void
+cog_static_module_class_init(CogStaticModuleClass *klass)
+{
+    GTypeModuleClass *type_module_class = G_TYPE_MODULE_CLASS(klass);
+    type_module_class->load = cog_static_module_load;
+    type_module_class->unload = cog_static_module_unload;
+}
+
+static void
+cog_static_module_init(CogStaticModule *self G_GNUC_UNUSED)
+{
+}
+
+/**
+ * cog_modules_add_static:
+ * @filename: (nullable): File name of the loadable module being replaced.
+ * @load_func: (scope forever): Function which registers the module types.
+ *
+ * Registers a module which is linked into the program instead of being
+ * loaded from a module directory.
+ *
+ * The @load_func is the same function used as entry point for a loadable
+ * module, i.e. `g_io_<name>_load()`. It gets called with a `GTypeModule`
+ * which is only typed as `GIOModule` for compatibility with said entry
+ * points, and must only be used as a `GTypeModule`.
+ *
+ * If @filename is not %NULL, modules with that file name (e.g.
+ * `libcogplatform-drm.so`) will be skipped when scanning directories.
+ *
+ * Static modules must be added before the first platform instance is
+ * created, typically at the beginning of `main()`.
+ *
+ * Since: 0.20
+ */
+void
+cog_modules_add_static(const char *filename, CogModulesLoadFunc load_func)
+{
+    g_return_if_fail(load_func != NULL);
+
+    ensure_extension_points();
+
+    G_LOCK(module_scan);
+
+    if (filename)
+        g_io_module_scope_block(get_module_scope(), filename);
+
+    CogStaticModule *module = g_object_new(cog_static_module_get_type(), NULL);
+    g_type_module_set_name(G_TYPE_MODULE(module), filename ?: "static");
+    module->load_func = load_func;
+
+    /* Type modules must never be finalized, the reference is kept. */
+    if (!g_type_module_use(G_TYPE_MODULE(module)))
+        g_warning("%s: Cannot load static module '%s'.", G_STRFUNC, filename ?: "static");
+    g_debug("%s: Added '%s'.", G_STRFUNC, filename ?: "static");
+
+    G_UNLOCK(module_scan);
+}
+
+/*
+ * The result of choosing a platform module depends on which modules are
+ * available, the display server sockets, and the DRM devices present. The
+ * cache key combines all of those, so a different environment results in a
+ * probe, and the outcome gets saved for the next time.
+ */
+static char *
+probe_cache_key(const char *preferred_module)
+{
+    g_autoptr(GString) key = g_string_new(preferred_module);
+
+    static const char *const env_vars[] = {
+        "COG_MODULEDIR", "WAYLAND_DISPLAY", "WAYLAND_SOCKET", "DISPLAY", "XDG_RUNTIME_DIR", "XDG_SESSION_TYPE",
+    };
+    for (unsigned i = 0; i < G_N_ELEMENTS(env_vars); i++)
+        g_string_append_printf(key, "\n%s=%s", env_vars[i], g_getenv(env_vars[i]) ?: "");
+
+    GStatBuf st;
+    const char *module_dir = g_getenv("COG_MODULEDIR") ?: COG_MODULEDIR;
+    if (g_stat(module_dir, &st) == 0)
+        g_string_append_printf(key, "\nmodules=%" G_GINT64_FORMAT, (gint64) st.st_mtime);
+
+    g_autoptr(GDir) dri_dir = g_dir_open("/dev/dri", 0, NULL);
+    if (dri_dir) {
+        g_autoptr(GPtrArray) names = g_ptr_array_new();
+        const char          *name;
+        while ((name = g_dir_read_name(dri_dir)))
+            g_ptr_array_add(names, (void *) name);
+        g_ptr_array_sort(names, (GCompareFunc) g_strcmp0);
+        for (unsigned i = 0; i < names->len; i++)
+            g_string_append_printf(key, "\ndri=%s", (const char *) g_ptr_array_index(names, i));
+    }
+
+    return g_compute_checksum_for_string(G_CHECKSUM_SHA256, key->str, key->len);
+}
+
+static const char *
+probe_cache_path(void)
+{
+    const char *path = g_getenv("COG_MODULES_PROBE_CACHE");
+    return (path && path[0] != '\0') ? path : NULL;
+}
+
+static char *
+probe_cache_lookup(const char *key)
+{
+    const char *path = probe_cache_path();
+    if (!path)
+        return NULL;
+
+    g_autoptr(GKeyFile) key_file = g_key_file_new();
+    if (!g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, NULL))
+        return NULL;
+
+    g_autofree char *cached_key = g_key_file_get_string(key_file, "probe", "key", NULL);
+    if (g_strcmp0(key, cached_key) != 0)
+        return NULL;
+
+    return g_key_file_get_string(key_file, "probe", "module", NULL);
+}
+
+static void
+probe_cache_store(const char *key, const char *module_name)
+{
+    const char *path = probe_cache_path();
+    if (!path)
+        return;
+
+    g_autoptr(GKeyFile) key_file = g_key_file_new();
+    g_key_file_set_string(key_file, "probe", "key", key);
+    g_key_file_set_string(key_file, "probe", "module", module_name);
+
+    g_autoptr(GError) error = NULL;
+    if (!g_key_file_save_to_file(key_file, path, &error))
+        g_warning("Cannot save module probe cache: %s", error->message);
+}
+
+/*
+ * Called when the chosen platform fails to set up, so that the next time
+ * modules get probed again instead of repeating the same choice.
+ */
+void
+cog_modules_forget_probe(void)
+{
+    const char *path = probe_cache_path();
+    if (path && g_unlink(path) == 0)
+        g_debug("%s: Removed '%s'.", G_STRFUNC, path);
+}
+
 /**
  * cog_modules_get_platform_extension_point:
  *
@@ -73,9 +261,18 @@ can_use_extension(GIOExtension *extension, size_t is_supported_offset)
 
     typedef gboolean (*VerifyFunction)(void);
 
+    g_autofree char *phase =
+        cog_profile_is_enabled() ? g_strconcat("modules: probe ", g_io_extension_get_name(extension), NULL) : NULL;
+    if (phase)
+        cog_profile_begin(phase);
+
     GType type = g_io_extension_get_type(extension);
     g_autoptr(GTypeClass) type_class = g_type_class_ref(type);
-    return (*G_STRUCT_MEMBER(VerifyFunction, type_class, is_supported_offset))();
+    gboolean supported = (*G_STRUCT_MEMBER(VerifyFunction, type_class, is_supported_offset))();
+
+    if (phase)
+        cog_profile_end(phase);
+    return supported;
 }
 
 /**
@@ -106,13 +303,39 @@ cog_modules_get_preferred(GIOExtensionPoint *extension_point, const char *prefer
     g_return_val_if_fail(extension_point != NULL, G_TYPE_INVALID);
 
     ensure_builtin_types();
-    cog_modules_add_directory(NULL);
 
     if (extension_point == COG_MODULES_PLATFORM && g_strcmp0(preferred_module, "fdo") == 0) {
         g_warning("Platform module name 'fdo' is deprecated, please use 'wl' instead.");
         preferred_module = "wl";
     }
 
+    /*
+     * Probing modules may be expensive, e.g. checking for DRM devices or
+     * connecting to a display server. When the environment is the same as
+     * the last time, reuse the result without probing nor scanning modules
+     * from directories, unless the chosen one was not statically linked.
+     */
+    g_autofree char *cache_key = NULL;
+    if (extension_point == COG_MODULES_PLATFORM && is_supported_offset && probe_cache_path()) {
+        cache_key = probe_cache_key(preferred_module);
+
+        g_autofree char *cached_name = probe_cache_lookup(cache_key);
+        if (cached_name) {
+            GIOExtension *extension = g_io_extension_point_get_extension_by_name(extension_point, cached_name);
+            if (!extension) {
+                cog_modules_add_directory(NULL);
+                extension = g_io_extension_point_get_extension_by_name(extension_point, cached_name);
+            }
+            if (extension) {
+                g_debug("%s: Using cached choice '%s'.", G_STRFUNC, cached_name);
+                cog_profile_mark("modules: cached probe");
+                return g_io_extension_get_type(extension);
+            }
+        }
+    }
+
+    cog_modules_add_directory(NULL);
+
     GIOExtension *extension, *chosen = NULL;
     if (preferred_module) {
         extension = g_io_extension_point_get_extension_by_name(extension_point, preferred_module);
@@ -133,6 +356,9 @@ cog_modules_get_preferred(GIOExtensionPoint *extension_point, const char *prefer
         item = g_list_next(item);
     }
 
+    if (chosen && cache_key)
+        probe_cache_store(cache_key, g_io_extension_get_name(chosen));
+
     return chosen ? g_io_extension_get_type(chosen) : G_TYPE_INVALID;
 }
 
@@ -200,7 +426,6 @@ cog_modules_add_directory(const char *directory_path)
     // it does *NOT* need to run guarded by the "module_scan" lock.
     ensure_extension_points();
 
-    G_LOCK_DEFINE_STATIC(module_scan);
     G_LOCK(module_scan);
 
     /*
@@ -248,12 +473,10 @@ cog_modules_add_directory(const char *directory_path)
      * 4. At this point, "directory_path" contains the path to scan.
      *    Create a scope if needed to avoid loading duplicate plug-ins.
      */
-    static GIOModuleScope *scope = NULL;
-    if (!scope)
-        scope = g_io_module_scope_new(G_IO_MODULE_SCOPE_BLOCK_DUPLICATES);
-
     g_debug("%s: Scanning '%s'", G_STRFUNC, directory_path);
-    g_io_modules_scan_all_in_directory_with_scope(directory_path, scope);
+    cog_profile_begin("modules: scan");
+    g_io_modules_scan_all_in_directory_with_scope(directory_path, get_module_scope());
+    cog_profile_end("modules: scan");
 
 out:
     G_UNLOCK(module_scan);
@@ -33,4 +33,9 @@ void cog_modules_foreach(GIOExtensionPoint *extension_point, void (*callback)(GI
 COG_API
 void cog_modules_add_directory(const char *directory_path);
 
+typedef void (*CogModulesLoadFunc)(GIOModule *module);
+
+COG_API
+void cog_modules_add_static(const char *filename, CogModulesLoadFunc load_func);
+
 G_END_DECLS
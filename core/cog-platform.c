@@ -7,8 +7,9 @@
  * SPDX-License-Identifier: MIT
  */
 
-#include "cog-modules.h"
+#include "cog-modules-private.h"
 #include "cog-platform-private.h"
+#include "cog-profile.h"
 #include "cog-viewport.h"
 
 G_DEFINE_QUARK(COG_PLATFORM_ERROR, cog_platform_error)
@@ -95,8 +96,6 @@ static inline gboolean
 cog_platform_ensure_singleton(const char *name)
 {
     if (g_once_init_enter(&platform_singleton)) {
-        cog_modules_add_directory(NULL);
-
         GType platform_type =
             cog_modules_get_preferred(COG_MODULES_PLATFORM, name, G_STRUCT_OFFSET(CogPlatformClass, is_supported));
 
@@ -147,7 +146,8 @@ cog_platform_ensure_singleton(const char *name)
 void
 cog_init(const char *platform_name, const char *module_path)
 {
-    cog_modules_add_directory(module_path);
+    if (module_path)
+        cog_modules_add_directory(module_path);
     gboolean already_initialized = cog_platform_ensure_singleton(platform_name ?: g_getenv("COG_PLATFORM_NAME"));
     g_return_if_fail(!already_initialized);
 }
@@ -200,13 +200,20 @@ cog_platform_setup(CogPlatform *platform, CogShell *shell, const char *params, G
     g_return_val_if_fail(COG_IS_PLATFORM(platform), FALSE);
     g_return_val_if_fail(COG_IS_SHELL(shell), FALSE);
 
-    if (G_IS_INITABLE(platform) && !g_initable_init(G_INITABLE(platform), NULL /* cancellable */, error))
-        return FALSE;
+    cog_profile_begin("platform: setup");
+
+    gboolean ok = !G_IS_INITABLE(platform) || g_initable_init(G_INITABLE(platform), NULL /* cancellable */, error);
+    if (ok) {
+        if (!params || params[0] == '\0')
+            params = g_getenv("COG_PLATFORM_PARAMS") ?: "";
+        ok = COG_PLATFORM_GET_CLASS(platform)->setup(platform, shell, params, error);
+    }
 
-    if (!params || params[0] == '\0')
-        params = g_getenv("COG_PLATFORM_PARAMS") ?: "";
+    cog_profile_end("platform: setup");
 
-    return COG_PLATFORM_GET_CLASS(platform)->setup(platform, shell, params, error);
+    if (!ok)
+        cog_modules_forget_probe();
+    return ok;
 }
 
 WebKitWebViewBackend*
@@ -0,0 +1,281 @@
+/*
+ * cog-profile.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-profile.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Timestamps for the phases of the startup sequence: module scanning,
+ * platform setup, web context and view creation, and page loading. While
+ * profiling is disabled the recording functions return immediately. Each
+ * entry is also written to the kernel tracing marker file when writable,
+ * which makes them show up in system wide Sysprof or Perfetto captures.
+ */
+
+typedef enum {
+    RECORD_BEGIN,
+    RECORD_END,
+    RECORD_MARK,
+} RecordKind;
+
+typedef struct {
+    const char *name; /* Interned. */
+    RecordKind  kind;
+    int64_t     time;
+} Record;
+
+static struct {
+    gboolean enabled;
+    gboolean finished;
+    int64_t  start;      /* Monotonic time, in microseconds. */
+    int64_t  start_boot; /* Time since boot, in microseconds. */
+    GArray  *records;    /* (Record) */
+    int      trace_fd;
+} s_profile = {
+    .trace_fd = -1,
+};
+
+G_LOCK_DEFINE_STATIC(s_profile);
+
+/* clang-format off */
+static const char *const s_trace_marker_paths[] = {
+    "/sys/kernel/tracing/trace_marker",
+    "/sys/kernel/debug/tracing/trace_marker",
+};
+/* clang-format on */
+
+static void *
+check_environment_internal(void *data G_GNUC_UNUSED)
+{
+    const char *value = g_getenv("COG_STARTUP_PROFILE");
+    if (value && value[0] != '\0')
+        cog_profile_enable();
+    return NULL;
+}
+
+static void
+check_environment(void)
+{
+    static GOnce once = G_ONCE_INIT;
+    g_once(&once, check_environment_internal, NULL);
+}
+
+/**
+ * cog_profile_enable:
+ *
+ * Enables recording of startup profiling data.
+ *
+ * Profiling may also be enabled by setting the `COG_STARTUP_PROFILE`
+ * environment variable to a non-empty value.
+ *
+ * Timestamps are reported relative to the moment profiling gets enabled,
+ * so this should be called as early as possible. Calling this function
+ * more than once has no effect.
+ *
+ * Since: 0.20
+ */
+void
+cog_profile_enable(void)
+{
+    G_LOCK(s_profile);
+
+    if (!s_profile.enabled && !s_profile.finished) {
+        struct timespec ts;
+        clock_gettime(CLOCK_BOOTTIME, &ts);
+
+        s_profile.enabled = TRUE;
+        s_profile.start = g_get_monotonic_time();
+        s_profile.start_boot = (int64_t) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+        s_profile.records = g_array_sized_new(FALSE, FALSE, sizeof(Record), 32);
+
+        for (unsigned i = 0; i < G_N_ELEMENTS(s_trace_marker_paths) && s_profile.trace_fd < 0; i++)
+            s_profile.trace_fd = open(s_trace_marker_paths[i], O_WRONLY | O_CLOEXEC);
+        g_debug("%s: Trace marker %s.", G_STRFUNC, s_profile.trace_fd >= 0 ? "available" : "unavailable");
+    }
+
+    G_UNLOCK(s_profile);
+}
+
+/**
+ * cog_profile_is_enabled:
+ *
+ * Checks whether startup profiling data is being recorded.
+ *
+ * Returns: Whether profiling is enabled.
+ *
+ * Since: 0.20
+ */
+gboolean
+cog_profile_is_enabled(void)
+{
+    check_environment();
+    return s_profile.enabled;
+}
+
+static void
+add_record(RecordKind kind, const char *name)
+{
+    const int64_t now = g_get_monotonic_time();
+
+    G_LOCK(s_profile);
+
+    if (s_profile.enabled) {
+        Record record = {g_intern_string(name), kind, now};
+        g_array_append_val(s_profile.records, record);
+
+        if (s_profile.trace_fd >= 0) {
+            static const char *const prefixes[] = {"begin ", "end ", ""};
+            char                     buffer[256];
+            int length = snprintf(buffer, sizeof(buffer), "cog-startup: %s%s", prefixes[kind], name);
+            if (write(s_profile.trace_fd, buffer, MIN((size_t) length, sizeof(buffer) - 1)) < 0) {
+                close(s_profile.trace_fd);
+                s_profile.trace_fd = -1;
+            }
+        }
+    }
+
+    G_UNLOCK(s_profile);
+}
+
+/**
+ * cog_profile_begin:
+ * @phase: Name of the phase.
+ *
+ * Records the beginning of a startup phase, which is expected to be
+ * followed by a matching call to [func@profile_end] with the same name.
+ *
+ * Since: 0.20
+ */
+void
+cog_profile_begin(const char *phase)
+{
+    g_return_if_fail(phase != NULL);
+
+    if (cog_profile_is_enabled())
+        add_record(RECORD_BEGIN, phase);
+}
+
+/**
+ * cog_profile_end:
+ * @phase: Name of the phase.
+ *
+ * Records the end of a startup phase.
+ *
+ * Since: 0.20
+ */
+void
+cog_profile_end(const char *phase)
+{
+    g_return_if_fail(phase != NULL);
+
+    if (cog_profile_is_enabled())
+        add_record(RECORD_END, phase);
+}
+
+/**
+ * cog_profile_mark:
+ * @event: Name of the event.
+ *
+ * Records an event which happens at a single point in time during
+ * startup, for example the first frame being shown.
+ *
+ * Since: 0.20
+ */
+void
+cog_profile_mark(const char *event)
+{
+    g_return_if_fail(event != NULL);
+
+    if (cog_profile_is_enabled())
+        add_record(RECORD_MARK, event);
+}
+
+static int64_t
+find_phase_duration(const GArray *records, unsigned end_index)
+{
+    const Record *end = &g_array_index(records, Record, end_index);
+
+    for (unsigned i = end_index; i-- > 0;) {
+        const Record *record = &g_array_index(records, Record, i);
+        if (record->kind == RECORD_BEGIN && record->name == end->name)
+            return end->time - record->time;
+    }
+    return -1;
+}
+
+/**
+ * cog_profile_finish:
+ *
+ * Marks startup as finished, prints the recorded timeline to the standard
+ * error output, and stops recording. The longest phase, which is usually
+ * the one worth looking into first, is highlighted.
+ *
+ * Since: 0.20
+ */
+void
+cog_profile_finish(void)
+{
+    if (!cog_profile_is_enabled())
+        return;
+
+    add_record(RECORD_MARK, "startup finished");
+
+    G_LOCK(s_profile);
+
+    const GArray *records = s_profile.records;
+    unsigned      longest = G_MAXUINT;
+    int64_t       longest_duration = -1;
+    for (unsigned i = 0; i < records->len; i++) {
+        if (g_array_index(records, Record, i).kind != RECORD_END)
+            continue;
+        int64_t duration = find_phase_duration(records, i);
+        if (duration > longest_duration) {
+            longest_duration = duration;
+            longest = i;
+        }
+    }
+
+    g_autoptr(GString) report = g_string_new(NULL);
+    g_string_append_printf(report, "Startup profile, started %.1f ms after boot:\n",
+                           (double) s_profile.start_boot / 1000);
+
+    for (unsigned i = 0; i < records->len; i++) {
+        const Record *record = &g_array_index(records, Record, i);
+        const double  time = (double) (record->time - s_profile.start) / 1000;
+
+        switch (record->kind) {
+        case RECORD_BEGIN:
+            g_string_append_printf(report, "  %9.1f ms            %s\n", time, record->name);
+            break;
+        case RECORD_END: {
+            int64_t duration = find_phase_duration(records, i);
+            g_string_append_printf(report, "  %9.1f ms %c %7.1f ms %s done\n", time, (i == longest) ? '*' : ' ',
+                                   (double) duration / 1000, record->name);
+            break;
+        }
+        case RECORD_MARK:
+            g_string_append_printf(report, "  %9.1f ms   -------- %s\n", time, record->name);
+            break;
+        }
+    }
+
+    g_printerr("%s", report->str);
+
+    s_profile.enabled = FALSE;
+    s_profile.finished = TRUE;
+    g_clear_pointer(&s_profile.records, g_array_unref);
+    if (s_profile.trace_fd >= 0) {
+        close(s_profile.trace_fd);
+        s_profile.trace_fd = -1;
+    }
+
+    G_UNLOCK(s_profile);
+}
@@ -0,0 +1,27 @@
+/*
+ * cog-profile.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#if !(defined(COG_INSIDE_COG__) && COG_INSIDE_COG__)
+#    error "Do not include this header directly, use <cog.h> instead"
+#endif
+
+#include "cog-export.h"
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+COG_API void     cog_profile_enable(void);
+COG_API gboolean cog_profile_is_enabled(void);
+
+COG_API void cog_profile_begin(const char *phase);
+COG_API void cog_profile_end(const char *phase);
+COG_API void cog_profile_mark(const char *event);
+COG_API void cog_profile_finish(void);
+
+G_END_DECLS
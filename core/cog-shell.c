@@ -8,6 +8,11 @@
 
 #include "cog-shell.h"
 
+#include "cog-memory-monitor-private.h"
+#include "cog-metrics.h"
+#include "cog-platform.h"
+#include "cog-profile.h"
+#include "cog-trace.h"
 #include "cog-view.h"
 #include "cog-viewport.h"
 
@@ -17,6 +22,38 @@
  * A shell managed a [class@WebKit.WebView], the default URI that it will
  * load, the view configuration, and keeps track of a number of registered
  * [iface@Cog.RequestHandler] instances.
+ *
+ * ## Prewarmed views
+ *
+ * Creating a web view and loading its first page needs a new web process
+ * to be launched, which may take a noticeable amount of time on slower
+ * devices. Setting [property@Cog.Shell:prewarm-count] keeps a number of
+ * spare views around, each one with its web process already launched.
+ * New views can be obtained from the pool using
+ * [method@Cog.Shell.take_prewarmed_view], and the pool gets replenished
+ * in the background when idle.
+ *
+ * Spare views are created using the [signal@Cog.Shell::create-view]
+ * signal, which allows choosing the properties they are constructed with.
+ * Prewarming is only available with platform implementations that support
+ * multiple views, see [func@Cog.View.get_impl_type].
+ *
+ * ## Memory pressure
+ *
+ * Enabling [property@Cog.Shell:memory-monitor] makes the shell watch the
+ * memory pressure reported by the Linux kernel, and give memory back
+ * before the out of memory killer steps in:
+ *
+ * - On moderate pressure, prewarmed views are released and the cache
+ *   model of the web context is switched to
+ *   `WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER`, which disables most caching.
+ * - On critical pressure, additionally the in-memory cache is cleared and
+ *   the web process of hidden views is terminated, see
+ *   [method@Cog.Viewport.discard_hidden_views].
+ *
+ * Once pressure goes away the cache model is restored, and prewarmed views
+ * are created again. Applications may react as well by watching
+ * [property@Cog.Shell:memory-pressure].
  */
 
 typedef struct {
@@ -26,6 +63,15 @@ typedef struct {
     GHashTable *request_handlers; /* (string, RequestHandlerMapEntry) */
     gboolean    automated;
 
+    unsigned prewarm_count;
+    GQueue   prewarm_views; /* (CogView) */
+    unsigned prewarm_source_id;
+
+    CogMemoryMonitor *memory_monitor;
+    CogMemoryPressure memory_pressure;
+    WebKitCacheModel  saved_cache_model; /* Restored once pressure goes away. */
+    GPtrArray        *viewports;         /* (CogViewport) (unowned) */
+
     WebKitSettings   *web_settings;
     WebKitWebContext *web_context;
 
@@ -54,6 +100,9 @@ enum {
     PROP_DEVICE_SCALE_FACTOR,
     PROP_AUTOMATED,
     PROP_WEB_DATA_MANAGER,
+    PROP_PREWARM_COUNT,
+    PROP_MEMORY_MONITOR,
+    PROP_MEMORY_PRESSURE,
 #if COG_HAVE_MEM_PRESSURE
     PROP_WEB_MEMORY_SETTINGS,
     PROP_NETWORK_MEMORY_SETTINGS,
@@ -66,9 +115,14 @@ static GParamSpec *s_properties[N_PROPERTIES] = { NULL, };
 enum {
     STARTUP,
     SHUTDOWN,
+    CREATE_VIEW,
     N_SIGNALS,
 };
 
+static unsigned s_signals[N_SIGNALS] = {
+    0,
+};
+
 typedef struct {
     CogRequestHandler *handler;
     gboolean           registered;
@@ -96,12 +150,29 @@ request_handler_map_entry_free (void *pointer)
 }
 
 
+static void
+on_uri_scheme_request_released (void    *userdata,
+                                GObject *request)
+{
+    cog_trace_record (COG_TRACE_HANDLER_END, (uintptr_t) request);
+}
+
+
 static void
 handle_uri_scheme_request (WebKitURISchemeRequest *request,
                            void                   *userdata)
 {
     RequestHandlerMapEntry *entry = userdata;
     g_assert (COG_IS_REQUEST_HANDLER (entry->handler));
+    cog_metrics_add (COG_METRIC_REQUESTS, 1);
+
+    /*
+     * Handlers may finish requests asynchronously, and WebKit releases
+     * them once finished, which makes for a reliable end marker.
+     */
+    cog_trace_record (COG_TRACE_HANDLER_BEGIN, (uintptr_t) request);
+    g_object_weak_ref (G_OBJECT (request), on_uri_scheme_request_released, NULL);
+
     cog_request_handler_run (entry->handler, request);
 }
 
@@ -138,6 +209,15 @@ cog_shell_get_property (GObject    *object,
         case PROP_WEB_CONTEXT:
             g_value_set_object (value, cog_shell_get_web_context (shell));
             break;
+        case PROP_PREWARM_COUNT:
+            g_value_set_uint(value, cog_shell_get_prewarm_count(shell));
+            break;
+        case PROP_MEMORY_MONITOR:
+            g_value_set_boolean(value, cog_shell_get_memory_monitor(shell));
+            break;
+        case PROP_MEMORY_PRESSURE:
+            g_value_set_enum(value, cog_shell_get_memory_pressure(shell));
+            break;
 #if COG_HAVE_MEM_PRESSURE
         case PROP_WEB_MEMORY_SETTINGS:
             g_value_set_boxed(value, PRIV(shell)->web_mem_settings);
@@ -183,6 +263,12 @@ cog_shell_set_property (GObject      *object,
         case PROP_AUTOMATED:
             priv->automated = g_value_get_boolean(value);
             break;
+        case PROP_PREWARM_COUNT:
+            cog_shell_set_prewarm_count(shell, g_value_get_uint(value));
+            break;
+        case PROP_MEMORY_MONITOR:
+            cog_shell_set_memory_monitor(shell, g_value_get_boolean(value));
+            break;
 #if COG_HAVE_MEM_PRESSURE
         case PROP_WEB_MEMORY_SETTINGS:
             g_clear_pointer(&priv->web_mem_settings, webkit_memory_pressure_settings_free);
@@ -204,6 +290,18 @@ cog_shell_set_property (GObject      *object,
         }
 }
 
+static void
+cog_shell_on_viewport_created(CogPlatform *platform G_GNUC_UNUSED, CogViewport *viewport, CogShell *shell)
+{
+    g_ptr_array_add(PRIV(shell)->viewports, viewport);
+}
+
+static void
+cog_shell_on_viewport_disposed(CogPlatform *platform G_GNUC_UNUSED, CogViewport *viewport, CogShell *shell)
+{
+    g_ptr_array_remove_fast(PRIV(shell)->viewports, viewport);
+}
+
 static void
 cog_shell_constructed(GObject *object)
 {
@@ -229,6 +327,7 @@ cog_shell_constructed(GObject *object)
     }
 #endif
 
+    cog_profile_begin("shell: web context");
     priv->web_context = g_object_new(WEBKIT_TYPE_WEB_CONTEXT,
 #if !COG_USE_WPE2
                                      "website-data-manager", priv->web_data_manager,
@@ -239,6 +338,15 @@ cog_shell_constructed(GObject *object)
                                      NULL);
 
     webkit_web_context_set_automation_allowed(priv->web_context, priv->automated);
+    cog_profile_end("shell: web context");
+
+    /* Hidden views in all viewports get discarded on critical memory pressure. */
+    priv->viewports = g_ptr_array_new();
+    CogPlatform *platform = cog_platform_get();
+    if (platform) {
+        g_signal_connect_object(platform, "viewport-created", G_CALLBACK(cog_shell_on_viewport_created), object, 0);
+        g_signal_connect_object(platform, "viewport-disposed", G_CALLBACK(cog_shell_on_viewport_disposed), object, 0);
+    }
 }
 
 static void
@@ -246,6 +354,13 @@ cog_shell_dispose(GObject *object)
 {
     CogShellPrivate *priv = PRIV(object);
 
+    g_clear_pointer(&priv->memory_monitor, cog_memory_monitor_free);
+    g_clear_pointer(&priv->viewports, g_ptr_array_unref);
+
+    g_clear_handle_id(&priv->prewarm_source_id, g_source_remove);
+    while (!g_queue_is_empty(&priv->prewarm_views))
+        g_object_unref(g_queue_pop_head(&priv->prewarm_views));
+
     g_clear_object(&priv->web_context);
     g_clear_object(&priv->web_settings);
 #if !COG_USE_WPE2
@@ -383,7 +498,74 @@ cog_shell_class_init(CogShellClass *klass)
                             WEBKIT_TYPE_WEBSITE_DATA_MANAGER,
                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
 
+    /**
+     * CogShell:prewarm-count: (attributes org.gtk.Property.get=cog_shell_get_prewarm_count org.gtk.Property.set=cog_shell_set_prewarm_count) (setter set_prewarm_count) (getter get_prewarm_count)
+     *
+     * Number of spare views to keep with their web process already
+     * launched, ready to be handed out by
+     * [method@Cog.Shell.take_prewarmed_view].
+     *
+     * The default value is zero, which disables prewarming.
+     *
+     * Since: 0.20
+     */
+    s_properties[PROP_PREWARM_COUNT] =
+        g_param_spec_uint("prewarm-count", NULL, NULL, 0, COG_SHELL_PREWARM_COUNT_MAX, 0,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * CogShell:memory-monitor: (attributes org.gtk.Property.get=cog_shell_get_memory_monitor org.gtk.Property.set=cog_shell_set_memory_monitor) (setter set_memory_monitor) (getter get_memory_monitor)
+     *
+     * Whether to watch memory pressure and react to it, see the
+     * [class@Cog.Shell] overview.
+     *
+     * Pressure is obtained from the pressure stall information of the kernel
+     * (`/proc/pressure/memory`), and the `memory.events` file of the cgroup
+     * the process runs in, when using cgroup v2. The property stays %FALSE
+     * if neither is available.
+     *
+     * Since: 0.20
+     */
+    s_properties[PROP_MEMORY_MONITOR] =
+        g_param_spec_boolean("memory-monitor", NULL, NULL, FALSE,
+                             G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * CogShell:memory-pressure: (attributes org.gtk.Property.get=cog_shell_get_memory_pressure) (getter get_memory_pressure)
+     *
+     * Current level of memory pressure, while
+     * [property@Cog.Shell:memory-monitor] is enabled.
+     *
+     * The level is raised as soon as pressure is detected, but lowered only
+     * after it has stayed low for a few seconds.
+     *
+     * Since: 0.20
+     */
+    s_properties[PROP_MEMORY_PRESSURE] =
+        g_param_spec_enum("memory-pressure", NULL, NULL, COG_TYPE_MEMORY_PRESSURE, COG_MEMORY_PRESSURE_NONE,
+                          G_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
     g_object_class_install_properties(object_class, N_PROPERTIES, s_properties);
+
+    /**
+     * CogShell::create-view:
+     * @self: The shell.
+     *
+     * Emitted when a spare view needs to be created to be added to the pool
+     * of prewarmed views. Handlers may return a new [class@Cog.View] built
+     * with the properties needed by the application, typically using
+     * [ctor@Cog.View.new]. The first handler which returns a view stops the
+     * emission.
+     *
+     * If no handler returns a view, the shell creates one using its
+     * [property@Cog.Shell:web-settings] and [property@Cog.Shell:web-context].
+     *
+     * Returns: (transfer full) (nullable): A new view.
+     *
+     * Since: 0.20
+     */
+    s_signals[CREATE_VIEW] = g_signal_new("create-view", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST, 0,
+                                          g_signal_accumulator_first_wins, NULL, NULL, COG_TYPE_VIEW, 0);
 }
 
 static void
@@ -519,3 +701,252 @@ cog_shell_set_request_handler(CogShell *shell, const char *scheme, CogRequestHan
 
     request_handler_map_entry_register (scheme, entry, priv->web_context);
 }
+
+static gboolean
+cog_shell_prewarm_supported(void)
+{
+    /*
+     * Platforms which do not provide their own view type have a single
+     * view backend, and creating another view would take it over.
+     */
+    CogPlatform *platform = cog_platform_get();
+    return platform && COG_PLATFORM_GET_CLASS(platform)->get_view_type;
+}
+
+static gboolean
+cog_shell_on_prewarm_idle(void *data)
+{
+    CogShellPrivate *priv = PRIV(data);
+
+    if (priv->prewarm_views.length >= priv->prewarm_count) {
+        priv->prewarm_source_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    CogView *view = NULL;
+    g_signal_emit(data, s_signals[CREATE_VIEW], 0, &view);
+    if (!view)
+        view = cog_view_new("settings", priv->web_settings, "web-context", priv->web_context, NULL);
+
+    /* Loading the first page launches and initializes the web process. */
+    webkit_web_view_load_uri(WEBKIT_WEB_VIEW(view), "about:blank");
+    g_queue_push_tail(&priv->prewarm_views, view);
+
+    g_debug("%s: %u/%u views prewarmed", G_STRFUNC, priv->prewarm_views.length, priv->prewarm_count);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+cog_shell_schedule_prewarm(CogShell *shell)
+{
+    CogShellPrivate *priv = PRIV(shell);
+
+    if (priv->prewarm_source_id || priv->prewarm_views.length >= priv->prewarm_count ||
+        priv->memory_pressure != COG_MEMORY_PRESSURE_NONE)
+        return;
+
+    /* Spare views are created one at a time, when there is nothing else to do. */
+    priv->prewarm_source_id = g_idle_add_full(G_PRIORITY_LOW, cog_shell_on_prewarm_idle, shell, NULL);
+    g_source_set_name_by_id(priv->prewarm_source_id, "Cog: shell view prewarming");
+}
+
+/**
+ * cog_shell_get_prewarm_count: (get-property prewarm-count)
+ *
+ * Gets the number of spare views kept prewarmed.
+ *
+ * Returns: Number of prewarmed views.
+ *
+ * Since: 0.20
+ */
+unsigned
+cog_shell_get_prewarm_count(CogShell *shell)
+{
+    g_return_val_if_fail(COG_IS_SHELL(shell), 0);
+    return PRIV(shell)->prewarm_count;
+}
+
+/**
+ * cog_shell_set_prewarm_count: (set-property prewarm-count)
+ * @count: Number of views.
+ *
+ * Sets the number of spare views kept prewarmed.
+ *
+ * Views in excess are released immediately, and missing ones are created
+ * in the background. Prewarming is not enabled with platforms that do not
+ * support multiple views.
+ *
+ * Since: 0.20
+ */
+void
+cog_shell_set_prewarm_count(CogShell *shell, unsigned count)
+{
+    g_return_if_fail(COG_IS_SHELL(shell));
+    g_return_if_fail(count <= COG_SHELL_PREWARM_COUNT_MAX);
+
+    CogShellPrivate *priv = PRIV(shell);
+
+    if (count && !cog_shell_prewarm_supported()) {
+        g_warning("%s: Platform does not support multiple views, prewarming disabled.", G_STRFUNC);
+        count = 0;
+    }
+
+    if (priv->prewarm_count == count)
+        return;
+
+    priv->prewarm_count = count;
+    while (priv->prewarm_views.length > count)
+        g_object_unref(g_queue_pop_tail(&priv->prewarm_views));
+
+    cog_shell_schedule_prewarm(shell);
+    g_object_notify_by_pspec(G_OBJECT(shell), s_properties[PROP_PREWARM_COUNT]);
+}
+
+/**
+ * cog_shell_take_prewarmed_view:
+ *
+ * Takes a view from the pool of prewarmed views, and schedules the creation
+ * of a new one to replace it.
+ *
+ * The returned view has already loaded `about:blank`. Before using the view
+ * it must be passed to [method@Cog.Platform.init_web_view], as done for
+ * any other newly created view.
+ *
+ * Returns: (transfer full) (nullable): A view, or %NULL if none is available.
+ *
+ * Since: 0.20
+ */
+CogView *
+cog_shell_take_prewarmed_view(CogShell *shell)
+{
+    g_return_val_if_fail(COG_IS_SHELL(shell), NULL);
+
+    CogShellPrivate *priv = PRIV(shell);
+    CogView         *view = g_queue_pop_head(&priv->prewarm_views);
+
+    cog_shell_schedule_prewarm(shell);
+    return view;
+}
+
+GType
+cog_memory_pressure_get_type(void)
+{
+    static gsize type_id = 0;
+
+    if (g_once_init_enter(&type_id)) {
+        /* clang-format off */
+        static const GEnumValue values[] = {
+            { COG_MEMORY_PRESSURE_NONE,     "COG_MEMORY_PRESSURE_NONE",     "none"     },
+            { COG_MEMORY_PRESSURE_MODERATE, "COG_MEMORY_PRESSURE_MODERATE", "moderate" },
+            { COG_MEMORY_PRESSURE_CRITICAL, "COG_MEMORY_PRESSURE_CRITICAL", "critical" },
+            { 0, NULL, NULL },
+        };
+        /* clang-format on */
+        g_once_init_leave(&type_id, g_enum_register_static(g_intern_static_string("CogMemoryPressure"), values));
+    }
+    return type_id;
+}
+
+static void
+cog_shell_release_prewarmed_views(CogShellPrivate *priv)
+{
+    g_clear_handle_id(&priv->prewarm_source_id, g_source_remove);
+    while (!g_queue_is_empty(&priv->prewarm_views))
+        g_object_unref(g_queue_pop_head(&priv->prewarm_views));
+}
+
+static void
+cog_shell_on_memory_pressure(CogMemoryPressure level, void *data)
+{
+    CogShell        *shell = data;
+    CogShellPrivate *priv = PRIV(shell);
+
+    const CogMemoryPressure previous = priv->memory_pressure;
+    priv->memory_pressure = level;
+
+    if (previous == COG_MEMORY_PRESSURE_NONE) {
+        priv->saved_cache_model = webkit_web_context_get_cache_model(priv->web_context);
+        webkit_web_context_set_cache_model(priv->web_context, WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER);
+        cog_shell_release_prewarmed_views(priv);
+    } else if (level == COG_MEMORY_PRESSURE_NONE) {
+        webkit_web_context_set_cache_model(priv->web_context, priv->saved_cache_model);
+        cog_shell_schedule_prewarm(shell);
+    }
+
+    if (level == COG_MEMORY_PRESSURE_CRITICAL) {
+#if !COG_USE_WPE2
+        /* With the WPE 2 API the memory cache belongs to the network session, not known to the shell. */
+        webkit_website_data_manager_clear(priv->web_data_manager, WEBKIT_WEBSITE_DATA_MEMORY_CACHE, 0, NULL, NULL,
+                                          NULL);
+#endif
+        unsigned n_discarded = 0;
+        for (unsigned i = 0; i < priv->viewports->len; i++)
+            n_discarded += cog_viewport_discard_hidden_views(g_ptr_array_index(priv->viewports, i));
+        g_debug("%s: Critical memory pressure, %u hidden views discarded.", G_STRFUNC, n_discarded);
+    }
+
+    g_object_notify_by_pspec(G_OBJECT(shell), s_properties[PROP_MEMORY_PRESSURE]);
+}
+
+/**
+ * cog_shell_get_memory_monitor: (get-property memory-monitor)
+ *
+ * Gets whether memory pressure is being monitored.
+ *
+ * Returns: Whether the memory monitor is enabled.
+ *
+ * Since: 0.20
+ */
+gboolean
+cog_shell_get_memory_monitor(CogShell *shell)
+{
+    g_return_val_if_fail(COG_IS_SHELL(shell), FALSE);
+    return PRIV(shell)->memory_monitor != NULL;
+}
+
+/**
+ * cog_shell_set_memory_monitor: (set-property memory-monitor)
+ * @enabled: Whether to enable the monitor.
+ *
+ * Enables or disables monitoring memory pressure. Disabling the monitor
+ * undoes the changes done in response to pressure.
+ *
+ * Since: 0.20
+ */
+void
+cog_shell_set_memory_monitor(CogShell *shell, gboolean enabled)
+{
+    g_return_if_fail(COG_IS_SHELL(shell));
+
+    CogShellPrivate *priv = PRIV(shell);
+    if (!priv->memory_monitor == !enabled)
+        return;
+
+    if (enabled) {
+        if (!(priv->memory_monitor = cog_memory_monitor_new(cog_shell_on_memory_pressure, shell)))
+            return;
+    } else {
+        g_clear_pointer(&priv->memory_monitor, cog_memory_monitor_free);
+        if (priv->memory_pressure != COG_MEMORY_PRESSURE_NONE)
+            cog_shell_on_memory_pressure(COG_MEMORY_PRESSURE_NONE, shell);
+    }
+
+    g_object_notify_by_pspec(G_OBJECT(shell), s_properties[PROP_MEMORY_MONITOR]);
+}
+
+/**
+ * cog_shell_get_memory_pressure: (get-property memory-pressure)
+ *
+ * Gets the current level of memory pressure.
+ *
+ * Returns: Pressure level, always %COG_MEMORY_PRESSURE_NONE while the
+ *    memory monitor is disabled.
+ *
+ * Since: 0.20
+ */
+CogMemoryPressure
+cog_shell_get_memory_pressure(CogShell *shell)
+{
+    g_return_val_if_fail(COG_IS_SHELL(shell), COG_MEMORY_PRESSURE_NONE);
+    return PRIV(shell)->memory_pressure;
+}
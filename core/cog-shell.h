@@ -18,9 +18,32 @@
 G_BEGIN_DECLS
 
 #define COG_SHELL_DEFAULT_VIEWPORT_INDEX 0
+#define COG_SHELL_PREWARM_COUNT_MAX      8
 
 typedef struct _CogView CogView;
 
+/**
+ * CogMemoryPressure:
+ * @COG_MEMORY_PRESSURE_NONE: Memory is not scarce.
+ * @COG_MEMORY_PRESSURE_MODERATE: Some tasks are stalled waiting for memory
+ *    to be reclaimed, or the cgroup reached its high limit.
+ * @COG_MEMORY_PRESSURE_CRITICAL: All tasks are stalled waiting for memory,
+ *    or the cgroup reached its maximum limit.
+ *
+ * Level of memory pressure, see [property@Cog.Shell:memory-pressure].
+ *
+ * Since: 0.20
+ */
+typedef enum {
+    COG_MEMORY_PRESSURE_NONE = 0,
+    COG_MEMORY_PRESSURE_MODERATE,
+    COG_MEMORY_PRESSURE_CRITICAL,
+} CogMemoryPressure;
+
+#define COG_TYPE_MEMORY_PRESSURE (cog_memory_pressure_get_type())
+
+COG_API GType cog_memory_pressure_get_type(void);
+
 #define COG_TYPE_SHELL (cog_shell_get_type())
 
 COG_API
@@ -39,4 +62,12 @@ COG_API gdouble           cog_shell_get_device_scale_factor(CogShell *shell);
 COG_API gboolean          cog_shell_is_automated(CogShell *shell);
 COG_API void cog_shell_set_request_handler(CogShell *shell, const char *scheme, CogRequestHandler *handler);
 
+COG_API unsigned cog_shell_get_prewarm_count(CogShell *shell);
+COG_API void     cog_shell_set_prewarm_count(CogShell *shell, unsigned count);
+COG_API CogView *cog_shell_take_prewarmed_view(CogShell *shell);
+
+COG_API gboolean          cog_shell_get_memory_monitor(CogShell *shell);
+COG_API void              cog_shell_set_memory_monitor(CogShell *shell, gboolean enabled);
+COG_API CogMemoryPressure cog_shell_get_memory_pressure(CogShell *shell);
+
 G_END_DECLS
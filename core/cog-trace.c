@@ -0,0 +1,324 @@
+/*
+ * cog-trace.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define _GNU_SOURCE /* For syscall() and SYS_gettid. */
+
+#include "cog-trace.h"
+
+#include <inttypes.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Each thread which records events gets a ring of fixed-size slots, so
+ * recording is a handful of atomic stores without locks nor allocations.
+ * Only the owning thread writes to a ring. Each slot carries the sequence
+ * number of the event it holds, which the writer clears before reusing the
+ * slot and sets again once the new event is in place. Readers copy a slot
+ * only if its sequence number is the expected one both before and after
+ * reading the rest of it, which discards slots being reused meanwhile.
+ *
+ * Like the rest of Cog, this uses the GLib atomic operations, which act as
+ * full memory barriers. Values wider than 32 bits are split in two halves,
+ * and sequence numbers wrap around; a slot whose sequence number would be
+ * zero, which marks slots being written, is never shown to readers.
+ *
+ * Rings are kept in a list which only grows; when a thread exits its ring
+ * is left for another thread to claim, keeping the events of the thread
+ * which exited until they are overwritten.
+ */
+
+/* Must be a power of two. At 28 bytes per slot, this is under 256 KiB per thread. */
+#define RING_SIZE 8192
+
+typedef struct {
+    guint seq;
+    guint time[2]; /* Nanoseconds, monotonic clock. */
+    guint arg[2];
+    guint event;
+    guint tid;
+} Slot;
+
+typedef struct _Ring Ring;
+
+struct _Ring {
+    Ring *next;
+    gint  in_use;
+    guint head;
+    Slot  slots[RING_SIZE];
+};
+
+typedef struct {
+    uint64_t time;
+    uint64_t arg;
+    uint32_t event;
+    uint32_t tid;
+} Event;
+
+/* clang-format off */
+static const struct {
+    const char *name;
+    const char *category;
+    const char *phase;
+} s_event_info[COG_TRACE_LAST] = {
+    [COG_TRACE_FRAME_EXPORT]      = {"frame-export",       "frame",   "i"},
+    [COG_TRACE_PAGE_FLIP]         = {"page-flip",          "frame",   "i"},
+    [COG_TRACE_INPUT_DISPATCH]    = {"input-dispatch",     "input",   "i"},
+    [COG_TRACE_HANDLER_BEGIN]     = {"uri-scheme-request", "handler", "b"},
+    [COG_TRACE_HANDLER_END]       = {"uri-scheme-request", "handler", "e"},
+    [COG_TRACE_BRIDGE_CALL_BEGIN] = {"bridge-call",        "bridge",  "B"},
+    [COG_TRACE_BRIDGE_CALL_END]   = {"bridge-call",        "bridge",  "E"},
+};
+/* clang-format on */
+
+static Ring *s_rings;
+
+static void
+ring_release(void *ring)
+{
+    g_atomic_int_set(&((Ring *) ring)->in_use, FALSE);
+}
+
+static GPrivate s_thread_ring = G_PRIVATE_INIT(ring_release);
+
+static Ring *
+ring_claim(void)
+{
+    for (Ring *ring = g_atomic_pointer_get(&s_rings); ring; ring = ring->next) {
+        if (g_atomic_int_compare_and_exchange(&ring->in_use, FALSE, TRUE))
+            return ring;
+    }
+
+    Ring *ring = g_new0(Ring, 1);
+    ring->in_use = TRUE;
+
+    do
+        ring->next = g_atomic_pointer_get(&s_rings);
+    while (!g_atomic_pointer_compare_and_exchange(&s_rings, ring->next, ring));
+    return ring;
+}
+
+/**
+ * cog_trace_record:
+ * @event: Type of event.
+ * @arg: Argument for the event, see [enum@TraceEvent].
+ *
+ * Records an event, with the current time, in the trace buffer of the
+ * calling thread. The most recent events of each thread are kept, and
+ * can be retrieved with [func@trace_to_json].
+ *
+ * This function can be called from any thread, and is cheap enough to be
+ * used in hot paths.
+ *
+ * Since: 0.20
+ */
+void
+cog_trace_record(CogTraceEvent event, uint64_t arg)
+{
+    g_return_if_fail(event < COG_TRACE_LAST);
+
+    Ring *ring = g_private_get(&s_thread_ring);
+    if (G_UNLIKELY(!ring))
+        g_private_set(&s_thread_ring, (ring = ring_claim()));
+
+    static __thread uint32_t tid;
+    if (G_UNLIKELY(!tid))
+        tid = syscall(SYS_gettid);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    const uint64_t time = (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+    const guint head = ring->head;
+    Slot       *slot = &ring->slots[head & (RING_SIZE - 1)];
+
+    /* Claim the slot first; being a full barrier, none of the stores below can be seen before. */
+    g_atomic_int_set(&slot->seq, 0);
+
+    g_atomic_int_set(&slot->time[0], (guint) time);
+    g_atomic_int_set(&slot->time[1], (guint) (time >> 32));
+    g_atomic_int_set(&slot->arg[0], (guint) arg);
+    g_atomic_int_set(&slot->arg[1], (guint) (arg >> 32));
+    g_atomic_int_set(&slot->event, event);
+    g_atomic_int_set(&slot->tid, tid);
+
+    g_atomic_int_set(&slot->seq, head + 1);
+    g_atomic_int_set(&ring->head, head + 1);
+}
+
+static inline uint64_t
+slot_get_u64(guint *halves)
+{
+    return (uint64_t) (guint) g_atomic_int_get(&halves[1]) << 32 | (guint) g_atomic_int_get(&halves[0]);
+}
+
+static void
+ring_read(Ring *ring, GArray *events)
+{
+    const guint head = g_atomic_int_get(&ring->head);
+
+    /* Unsigned arithmetic wraps around along with the sequence numbers. */
+    for (guint i = head - RING_SIZE; i != head; i++) {
+        Slot       *slot = &ring->slots[i & (RING_SIZE - 1)];
+        const guint seq = i + 1;
+
+        /* Slots not written yet, or being reused, hold a different sequence number. */
+        if (!seq || (guint) g_atomic_int_get(&slot->seq) != seq)
+            continue;
+
+        Event event = {
+            .time = slot_get_u64(slot->time),
+            .arg = slot_get_u64(slot->arg),
+            .event = g_atomic_int_get(&slot->event),
+            .tid = g_atomic_int_get(&slot->tid),
+        };
+
+        /* The writer may have claimed the slot again while it was being read. */
+        if ((guint) g_atomic_int_get(&slot->seq) != seq)
+            continue;
+
+        g_array_append_val(events, event);
+    }
+}
+
+static void
+append_json_string(GString *json, const char *str)
+{
+    g_string_append_c(json, '"');
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            g_string_append_printf(json, "\\%c", *str);
+        else if ((unsigned char) *str < 0x20)
+            g_string_append_printf(json, "\\u%04x", (unsigned char) *str);
+        else
+            g_string_append_c(json, *str);
+    }
+    g_string_append_c(json, '"');
+}
+
+static void
+append_thread_name(GString *json, pid_t pid, uint32_t tid)
+{
+    /* Only available while the thread is alive. */
+    g_autofree char *path = g_strdup_printf("/proc/%d/task/%" PRIu32 "/comm", pid, tid);
+    g_autofree char *name = NULL;
+    if (!g_file_get_contents(path, &name, NULL, NULL))
+        return;
+
+    g_string_append_printf(json,
+                           "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%" PRIu32
+                           ",\"args\":{\"name\":",
+                           pid, tid);
+    append_json_string(json, g_strchomp(name));
+    g_string_append(json, "}},\n");
+}
+
+static void
+append_event(GString *json, pid_t pid, const Event *event)
+{
+    g_string_append_printf(json,
+                           "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%" PRIu64 ".%03u,\"pid\":%d,"
+                           "\"tid\":%" PRIu32,
+                           s_event_info[event->event].name, s_event_info[event->event].category,
+                           s_event_info[event->event].phase, event->time / 1000, (unsigned) (event->time % 1000), pid,
+                           event->tid);
+
+    switch (event->event) {
+    case COG_TRACE_FRAME_EXPORT:
+    case COG_TRACE_BRIDGE_CALL_END:
+        break;
+    case COG_TRACE_PAGE_FLIP:
+        g_string_append_printf(json, ",\"args\":{\"presentation-time\":%" PRIu64 "}", event->arg);
+        break;
+    case COG_TRACE_INPUT_DISPATCH:
+        g_string_append_printf(json, ",\"args\":{\"event-time\":%" PRIu64 "}", event->arg);
+        break;
+    case COG_TRACE_HANDLER_BEGIN:
+    case COG_TRACE_HANDLER_END:
+        g_string_append_printf(json, ",\"id\":\"0x%" PRIx64 "\"", event->arg);
+        break;
+    case COG_TRACE_BRIDGE_CALL_BEGIN: {
+        const char *function = g_quark_to_string(event->arg);
+        g_string_append(json, ",\"args\":{\"function\":");
+        append_json_string(json, function ? function : "");
+        g_string_append_c(json, '}');
+        break;
+    }
+    }
+
+    /* Instant events apply to their thread only. */
+    if (s_event_info[event->event].phase[0] == 'i')
+        g_string_append(json, ",\"s\":\"t\"");
+    g_string_append(json, "},\n");
+}
+
+/**
+ * cog_trace_to_json:
+ *
+ * Formats the events recorded by all threads as a JSON trace, in the
+ * format used by the Chrome trace viewer, which can also be opened with
+ * the Perfetto UI.
+ *
+ * Threads can keep recording events while this function runs.
+ *
+ * Returns: (transfer full): JSON trace.
+ *
+ * Since: 0.20
+ */
+char *
+cog_trace_to_json(void)
+{
+    g_autoptr(GArray) events = g_array_new(FALSE, FALSE, sizeof(Event));
+    g_autoptr(GHashTable) tids = g_hash_table_new(NULL, NULL);
+
+    for (Ring *ring = g_atomic_pointer_get(&s_rings); ring; ring = ring->next)
+        ring_read(ring, events);
+
+    const pid_t pid = getpid();
+    GString    *json = g_string_sized_new(events->len * 128 + 64);
+    g_string_append(json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    for (unsigned i = 0; i < events->len; i++) {
+        const Event *event = &g_array_index(events, Event, i);
+        if (event->event >= COG_TRACE_LAST)
+            continue;
+
+        if (g_hash_table_add(tids, GUINT_TO_POINTER(event->tid)))
+            append_thread_name(json, pid, event->tid);
+        append_event(json, pid, event);
+    }
+
+    /* Drop the separator after the last element, JSON does not allow it. */
+    if (g_str_has_suffix(json->str, ",\n"))
+        g_string_truncate(json, json->len - 2);
+    g_string_append(json, "\n]}\n");
+
+    return g_string_free(json, FALSE);
+}
+
+/**
+ * cog_trace_dump:
+ * @path: Path to the file to write.
+ * @error: Location where to store an error.
+ *
+ * Writes the events recorded by all threads to a file, as formatted by
+ * [func@trace_to_json].
+ *
+ * Returns: Whether the file was written.
+ *
+ * Since: 0.20
+ */
+gboolean
+cog_trace_dump(const char *path, GError **error)
+{
+    g_return_val_if_fail(path, FALSE);
+
+    g_autofree char *json = cog_trace_to_json();
+    return g_file_set_contents(path, json, -1, error);
+}
@@ -0,0 +1,58 @@
+/*
+ * cog-trace.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#if !(defined(COG_INSIDE_COG__) && COG_INSIDE_COG__)
+#    error "Do not include this header directly, use <cog.h> instead"
+#endif
+
+#include "cog-export.h"
+#include <glib.h>
+#include <stdint.h>
+
+G_BEGIN_DECLS
+
+/**
+ * CogTraceEvent:
+ * @COG_TRACE_FRAME_EXPORT: A frame was received from the web process.
+ *    The argument is unused.
+ * @COG_TRACE_PAGE_FLIP: A frame was shown on the output. The argument is
+ *    the presentation time, in microseconds.
+ * @COG_TRACE_INPUT_DISPATCH: An input event was sent to the web view. The
+ *    argument is the time of the event, in milliseconds.
+ * @COG_TRACE_HANDLER_BEGIN: A custom URI scheme request handler started
+ *    processing a request. The argument identifies the request.
+ * @COG_TRACE_HANDLER_END: A custom URI scheme request was released. The
+ *    argument identifies the request.
+ * @COG_TRACE_BRIDGE_CALL_BEGIN: A function bound with the CogBridge library
+ *    was called from web content. The argument is a #GQuark for the name
+ *    of the function.
+ * @COG_TRACE_BRIDGE_CALL_END: A function bound with the CogBridge library
+ *    returned. The argument is unused.
+ * @COG_TRACE_LAST: Number of event types.
+ *
+ * Types of events recorded with [func@trace_record].
+ *
+ * Since: 0.20
+ */
+typedef enum {
+    COG_TRACE_FRAME_EXPORT,
+    COG_TRACE_PAGE_FLIP,
+    COG_TRACE_INPUT_DISPATCH,
+    COG_TRACE_HANDLER_BEGIN,
+    COG_TRACE_HANDLER_END,
+    COG_TRACE_BRIDGE_CALL_BEGIN,
+    COG_TRACE_BRIDGE_CALL_END,
+    COG_TRACE_LAST,
+} CogTraceEvent;
+
+COG_API void     cog_trace_record(CogTraceEvent event, uint64_t arg);
+COG_API char    *cog_trace_to_json(void);
+COG_API gboolean cog_trace_dump(const char *path, GError **error);
+
+G_END_DECLS
@@ -6,7 +6,9 @@
  */
 
 #include "cog-view.h"
+#include "cog-metrics.h"
 #include "cog-platform.h"
+#include "cog-trace.h"
 #include "cog-view-private.h"
 
 /**
@@ -29,6 +31,8 @@ typedef struct {
     gboolean use_key_bindings;
 
     GWeakRef viewport; /* Weak reference to the associated CogViewport */
+
+    int64_t load_start; /* Monotonic time at which the current load started. */
 } CogViewPrivate;
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE(CogView, cog_view, WEBKIT_TYPE_WEB_VIEW)
@@ -131,6 +135,27 @@ cog_view_class_init(CogViewClass *klass)
     g_object_class_install_properties(object_class, N_PROPERTIES, s_properties);
 }
 
+static void
+cog_view_load_changed(WebKitWebView *web_view, WebKitLoadEvent load_event)
+{
+    CogViewPrivate *priv = cog_view_get_instance_private(COG_VIEW(web_view));
+
+    switch (load_event) {
+    case WEBKIT_LOAD_STARTED:
+        priv->load_start = g_get_monotonic_time();
+        break;
+    case WEBKIT_LOAD_FINISHED:
+        if (priv->load_start) {
+            cog_metrics_add(COG_METRIC_PAGE_LOADS, 1);
+            cog_metrics_add(COG_METRIC_PAGE_LOAD_TIME, g_get_monotonic_time() - priv->load_start);
+            priv->load_start = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
 static void
 cog_view_init(CogView *self)
 {
@@ -138,6 +163,8 @@ cog_view_init(CogView *self)
 
     // Init the weak reference to the CogViewport.
     g_weak_ref_init(&priv->viewport, NULL);
+
+    g_signal_connect(self, "load-changed", G_CALLBACK(cog_view_load_changed), NULL);
 }
 
 static inline struct wpe_view_backend *
@@ -359,6 +386,8 @@ cog_view_handle_key_event(CogView *self, const struct wpe_input_keyboard_event *
     if (priv->use_key_bindings && cog_view_try_handle_key_binding(self, event))
         return;
 
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, event->time);
+
     struct wpe_input_keyboard_event event_copy = *event;
     wpe_view_backend_dispatch_keyboard_event(cog_view_get_backend_internal(self), &event_copy);
 }
@@ -33,12 +33,76 @@
  * viewport class implementation by overriding
  * the [func@CogPlatform.get_viewport_type] method.
  *
+ * ## Pre-rendering
+ *
+ * By default views which are not visible stop rendering, and showing them
+ * again needs a new frame to be produced. Setting the
+ * [property@CogViewport:prerender-limit] property allows up to that many
+ * hidden views to keep loading and rendering off-screen, at the reduced
+ * pace given by [property@CogViewport:prerender-interval], so switching to
+ * them shows their last frame right away. The views chosen are those which
+ * were most recently visible, or most recently added; views beyond the limit
+ * are suspended, which bounds the amount of memory used by the rendered
+ * frames of hidden views.
+ *
+ * ## Hidden View Lifecycle
+ *
+ * Views which stay hidden for long enough can progressively give up more
+ * resources. Each step is configured with a delay, counted from the moment
+ * the view was hidden, and is disabled by default:
+ *
+ * - [property@CogViewport:throttle-delay]: The view stops rendering, even
+ *   if it was being pre-rendered. WebKit throttles the timers of pages
+ *   which are not visible.
+ * - [property@CogViewport:freeze-delay]: The view is detached from the
+ *   window, which makes WebKit suspend animations and media, and stop
+ *   processing rendering updates altogether.
+ * - [property@CogViewport:discard-delay]: The web process of the view is
+ *   terminated, freeing all its memory. The page is loaded again from its
+ *   URL once the view becomes visible.
+ *
+ * Views get all their resources back when they become visible again.
+ *
  * Since: 0.20
  */
 
+#define DEFAULT_PRERENDER_INTERVAL 200 /* ms */
+
+typedef enum {
+    VIEW_TIER_ACTIVE = 0,
+    VIEW_TIER_THROTTLED,
+    VIEW_TIER_FROZEN,
+    VIEW_TIER_DISCARDED,
+    N_VIEW_TIERS,
+} ViewTier;
+
+typedef struct {
+    ViewTier tier;
+    int64_t  hidden_since;
+
+    /* Saved when the view is discarded, to bring it back as it was. */
+    WebKitWebViewSessionState *session_state;
+} ViewLifecycle;
+
+static void
+view_lifecycle_free(ViewLifecycle *lifecycle)
+{
+    g_clear_pointer(&lifecycle->session_state, webkit_web_view_session_state_unref);
+    g_free(lifecycle);
+}
+
 typedef struct {
     GPtrArray *views;
     CogView   *visible_view;
+
+    /* Views ordered from the most to the least recently visible. */
+    GQueue   recent_views;
+    unsigned prerender_limit;
+    unsigned prerender_interval;
+
+    GHashTable *lifecycle;              /* CogView* -> ViewLifecycle* */
+    unsigned    tier_delay[N_VIEW_TIERS]; /* In ms, G_MAXUINT if disabled. */
+    guint       lifecycle_timer_id;
 } CogViewportPrivate;
 
 enum {
@@ -54,6 +118,11 @@ static unsigned s_signals[N_SIGNALS] = {
 enum {
     PROP_0,
     PROP_VISIBLE_VIEW,
+    PROP_PRERENDER_LIMIT,
+    PROP_PRERENDER_INTERVAL,
+    PROP_THROTTLE_DELAY,
+    PROP_FREEZE_DELAY,
+    PROP_DISCARD_DELAY,
     N_PROPERTIES,
 };
 
@@ -91,6 +160,21 @@ cog_viewport_set_property(GObject *object, unsigned prop_id, const GValue *value
     case PROP_VISIBLE_VIEW:
         cog_viewport_set_visible_view(self, g_value_get_object(value));
         break;
+    case PROP_PRERENDER_LIMIT:
+        cog_viewport_set_prerender_limit(self, g_value_get_uint(value));
+        break;
+    case PROP_PRERENDER_INTERVAL:
+        cog_viewport_set_prerender_interval(self, g_value_get_uint(value));
+        break;
+    case PROP_THROTTLE_DELAY:
+        cog_viewport_set_throttle_delay(self, g_value_get_uint(value));
+        break;
+    case PROP_FREEZE_DELAY:
+        cog_viewport_set_freeze_delay(self, g_value_get_uint(value));
+        break;
+    case PROP_DISCARD_DELAY:
+        cog_viewport_set_discard_delay(self, g_value_get_uint(value));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
@@ -104,6 +188,21 @@ cog_viewport_get_property(GObject *object, unsigned prop_id, GValue *value, GPar
     case PROP_VISIBLE_VIEW:
         g_value_set_object(value, cog_viewport_get_visible_view(self));
         break;
+    case PROP_PRERENDER_LIMIT:
+        g_value_set_uint(value, cog_viewport_get_prerender_limit(self));
+        break;
+    case PROP_PRERENDER_INTERVAL:
+        g_value_set_uint(value, cog_viewport_get_prerender_interval(self));
+        break;
+    case PROP_THROTTLE_DELAY:
+        g_value_set_uint(value, cog_viewport_get_throttle_delay(self));
+        break;
+    case PROP_FREEZE_DELAY:
+        g_value_set_uint(value, cog_viewport_get_freeze_delay(self));
+        break;
+    case PROP_DISCARD_DELAY:
+        g_value_set_uint(value, cog_viewport_get_discard_delay(self));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
@@ -157,6 +256,9 @@ cog_viewport_new(void)
 static void
 cog_viewport_dispose(GObject *object)
 {
+    g_clear_handle_id(&PRIV(object)->lifecycle_timer_id, g_source_remove);
+    g_hash_table_remove_all(PRIV(object)->lifecycle);
+    g_queue_clear(&PRIV(object)->recent_views);
     g_ptr_array_set_size(PRIV(object)->views, 0);
 
     G_OBJECT_CLASS(cog_viewport_parent_class)->dispose(object);
@@ -168,6 +270,7 @@ static void
 cog_viewport_finalize(GObject *object)
 {
     g_ptr_array_free(PRIV(object)->views, TRUE);
+    g_hash_table_unref(PRIV(object)->lifecycle);
 
     G_OBJECT_CLASS(cog_viewport_parent_class)->finalize(object);
 }
@@ -199,6 +302,72 @@ cog_viewport_class_init(CogViewportClass *klass)
         g_param_spec_object("visible-view", NULL, NULL, COG_TYPE_VIEW,
                             G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
 
+    /**
+     * CogViewport:prerender-limit: (attributes org.gtk.Property.get=cog_viewport_get_prerender_limit org.gtk.Property.set=cog_viewport_set_prerender_limit) (setter set_prerender_limit) (getter get_prerender_limit):
+     *
+     * Maximum number of hidden views which keep rendering off-screen.
+     *
+     * The default value of zero disables pre-rendering.
+     *
+     * Since: 0.20
+     */
+    s_properties[PROP_PRERENDER_LIMIT] =
+        g_param_spec_uint("prerender-limit", NULL, NULL, 0, G_MAXUINT, 0,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * CogViewport:prerender-interval: (attributes org.gtk.Property.get=cog_viewport_get_prerender_interval org.gtk.Property.set=cog_viewport_set_prerender_interval) (setter set_prerender_interval) (getter get_prerender_interval):
+     *
+     * Minimum time between frames of pre-rendered hidden views, in
+     * milliseconds.
+     *
+     * Since: 0.20
+     */
+    s_properties[PROP_PRERENDER_INTERVAL] =
+        g_param_spec_uint("prerender-interval", NULL, NULL, 1, G_MAXUINT, DEFAULT_PRERENDER_INTERVAL,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * CogViewport:throttle-delay: (attributes org.gtk.Property.get=cog_viewport_get_throttle_delay org.gtk.Property.set=cog_viewport_set_throttle_delay) (setter set_throttle_delay) (getter get_throttle_delay):
+     *
+     * Time after which hidden views stop rendering, in milliseconds. The
+     * default value, %G_MAXUINT, disables this step.
+     *
+     * Only pre-rendered views keep rendering while hidden, so this limits
+     * how long they are kept up to date.
+     *
+     * Since: 0.20
+     */
+    s_properties[PROP_THROTTLE_DELAY] =
+        g_param_spec_uint("throttle-delay", NULL, NULL, 0, G_MAXUINT, G_MAXUINT,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * CogViewport:freeze-delay: (attributes org.gtk.Property.get=cog_viewport_get_freeze_delay org.gtk.Property.set=cog_viewport_set_freeze_delay) (setter set_freeze_delay) (getter get_freeze_delay):
+     *
+     * Time after which hidden views are detached from the window, in
+     * milliseconds. The default value, %G_MAXUINT, disables this step.
+     *
+     * Since: 0.20
+     */
+    s_properties[PROP_FREEZE_DELAY] =
+        g_param_spec_uint("freeze-delay", NULL, NULL, 0, G_MAXUINT, G_MAXUINT,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * CogViewport:discard-delay: (attributes org.gtk.Property.get=cog_viewport_get_discard_delay org.gtk.Property.set=cog_viewport_set_discard_delay) (setter set_discard_delay) (getter get_discard_delay):
+     *
+     * Time after which the web process of hidden views is terminated, in
+     * milliseconds. The default value, %G_MAXUINT, disables this step.
+     *
+     * Requires WebKit 2.34 or newer.
+     *
+     * Since: 0.20
+     */
+    s_properties[PROP_DISCARD_DELAY] =
+        g_param_spec_uint("discard-delay", NULL, NULL, 0, G_MAXUINT, G_MAXUINT,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
     g_object_class_install_properties(object_class, N_PROPERTIES, s_properties);
 
     /**
@@ -227,7 +396,165 @@ cog_viewport_class_init(CogViewportClass *klass)
 static void
 cog_viewport_init(CogViewport *self)
 {
-    PRIV(self)->views = g_ptr_array_new_full(3, g_object_unref);
+    CogViewportPrivate *priv = PRIV(self);
+    priv->views = g_ptr_array_new_full(3, g_object_unref);
+    priv->prerender_interval = DEFAULT_PRERENDER_INTERVAL;
+    g_queue_init(&priv->recent_views);
+
+    priv->lifecycle = g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify) view_lifecycle_free);
+    for (unsigned i = 0; i < N_VIEW_TIERS; i++)
+        priv->tier_delay[i] = G_MAXUINT;
+}
+
+static inline ViewLifecycle *
+cog_viewport_get_lifecycle(CogViewportPrivate *priv, CogView *view)
+{
+    return g_hash_table_lookup(priv->lifecycle, view);
+}
+
+static void
+cog_viewport_apply_tier(CogViewport *self, CogView *view, ViewLifecycle *lifecycle, ViewTier tier)
+{
+    struct wpe_view_backend *backend = cog_view_get_backend(view);
+
+    switch (tier) {
+    case VIEW_TIER_THROTTLED:
+        g_debug("%s<%p>: throttling view %p", G_STRFUNC, self, view);
+        wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_visible);
+        break;
+    case VIEW_TIER_FROZEN:
+        g_debug("%s<%p>: freezing view %p", G_STRFUNC, self, view);
+        wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_in_window);
+        break;
+    case VIEW_TIER_DISCARDED:
+#if WEBKIT_CHECK_VERSION(2, 34, 0)
+        g_debug("%s<%p>: discarding view %p, URI %s", G_STRFUNC, self, view,
+                webkit_web_view_get_uri(WEBKIT_WEB_VIEW(view)));
+        g_clear_pointer(&lifecycle->session_state, webkit_web_view_session_state_unref);
+        lifecycle->session_state = webkit_web_view_get_session_state(WEBKIT_WEB_VIEW(view));
+        webkit_web_view_terminate_web_process(WEBKIT_WEB_VIEW(view));
+#else
+        g_debug("%s<%p>: discarding view %p needs WebKit 2.34, skipped", G_STRFUNC, self, view);
+#endif /* WEBKIT_CHECK_VERSION */
+        break;
+    default:
+        g_assert_not_reached();
+    }
+
+    lifecycle->tier = tier;
+}
+
+/* Brings back the resources given up by a hidden view which is now visible. */
+static void
+cog_viewport_restore_view(CogViewport *self, CogView *view, ViewLifecycle *lifecycle)
+{
+    if (lifecycle->tier >= VIEW_TIER_FROZEN)
+        wpe_view_backend_add_activity_state(cog_view_get_backend(view), wpe_view_activity_state_in_window);
+
+#if WEBKIT_CHECK_VERSION(2, 34, 0)
+    if (lifecycle->tier == VIEW_TIER_DISCARDED) {
+        WebKitWebView *web_view = WEBKIT_WEB_VIEW(view);
+        g_debug("%s<%p>: restoring view %p, URI %s", G_STRFUNC, self, view, webkit_web_view_get_uri(web_view));
+
+        /*
+         * Going to the current item of the restored back/forward list brings
+         * back scroll positions and form contents, which a reload would not.
+         */
+        WebKitBackForwardListItem *item = NULL;
+        if (lifecycle->session_state) {
+            webkit_web_view_restore_session_state(web_view, lifecycle->session_state);
+            g_clear_pointer(&lifecycle->session_state, webkit_web_view_session_state_unref);
+            item = webkit_back_forward_list_get_current_item(webkit_web_view_get_back_forward_list(web_view));
+        }
+
+        if (item)
+            webkit_web_view_go_to_back_forward_list_item(web_view, item);
+        else
+            webkit_web_view_reload(web_view);
+    }
+#endif /* WEBKIT_CHECK_VERSION */
+
+    lifecycle->tier = VIEW_TIER_ACTIVE;
+}
+
+static gboolean cog_viewport_on_lifecycle_timeout(void *data);
+
+/*
+ * Moves hidden views through the lifecycle steps whose delay has elapsed,
+ * and arranges to be called again when the next one is due.
+ */
+static void
+cog_viewport_update_lifecycle(CogViewport *self, CogViewportPrivate *priv)
+{
+    g_clear_handle_id(&priv->lifecycle_timer_id, g_source_remove);
+
+    const int64_t now = g_get_monotonic_time();
+    int64_t       next_due = G_MAXINT64;
+
+    for (unsigned i = 0; i < priv->views->len; i++) {
+        CogView *view = g_ptr_array_index(priv->views, i);
+        if (view == priv->visible_view)
+            continue;
+
+        ViewLifecycle *lifecycle = cog_viewport_get_lifecycle(priv, view);
+        for (ViewTier tier = lifecycle->tier + 1; tier < N_VIEW_TIERS; tier++) {
+            if (priv->tier_delay[tier] == G_MAXUINT)
+                continue;
+
+            const int64_t due = lifecycle->hidden_since + (int64_t) priv->tier_delay[tier] * 1000;
+            if (due > now) {
+                next_due = MIN(next_due, due);
+                break;
+            }
+            cog_viewport_apply_tier(self, view, lifecycle, tier);
+        }
+    }
+
+    if (next_due != G_MAXINT64) {
+        priv->lifecycle_timer_id =
+            g_timeout_add((next_due - now + 999) / 1000, cog_viewport_on_lifecycle_timeout, self);
+        g_source_set_name_by_id(priv->lifecycle_timer_id, "Cog: viewport lifecycle");
+    }
+}
+
+static gboolean
+cog_viewport_on_lifecycle_timeout(void *data)
+{
+    CogViewportPrivate *priv = PRIV(data);
+    priv->lifecycle_timer_id = 0;
+    cog_viewport_update_lifecycle(data, priv);
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Hidden views keep the "visible" activity state, which makes WebKit keep
+ * rendering them, while they are among the "prerender_limit" most recently
+ * visible ones; the rest are suspended.
+ */
+static void
+cog_viewport_update_prerender(CogViewport *self, CogViewportPrivate *priv)
+{
+    unsigned n_prerendered = 0;
+
+    for (GList *item = priv->recent_views.head; item; item = g_list_next(item)) {
+        CogView *view = item->data;
+        if (view == priv->visible_view || cog_viewport_get_lifecycle(priv, view)->tier >= VIEW_TIER_THROTTLED)
+            continue;
+
+        struct wpe_view_backend *backend = cog_view_get_backend(view);
+        const bool               rendering = wpe_view_backend_get_activity_state(backend) & wpe_view_activity_state_visible;
+
+        if (n_prerendered < priv->prerender_limit) {
+            n_prerendered++;
+            if (!rendering) {
+                g_debug("%s<%p>: pre-rendering view %p", G_STRFUNC, self, view);
+                wpe_view_backend_add_activity_state(backend, wpe_view_activity_state_visible);
+            }
+        } else if (rendering) {
+            g_debug("%s<%p>: suspending view %p", G_STRFUNC, self, view);
+            wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_visible);
+        }
+    }
 }
 
 static void
@@ -238,17 +565,28 @@ cog_viewport_set_visible_view_internal(CogViewport *self, CogViewportPrivate *pr
 
     if (priv->visible_view) {
         struct wpe_view_backend *backend = cog_view_get_backend(priv->visible_view);
-        wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_visible);
         wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_focused);
+
+        ViewLifecycle *lifecycle = cog_viewport_get_lifecycle(priv, priv->visible_view);
+        if (lifecycle)
+            lifecycle->hidden_since = g_get_monotonic_time();
     }
 
     priv->visible_view = view;
+    cog_viewport_update_prerender(self, priv);
     g_object_notify_by_pspec(G_OBJECT(self), s_properties[PROP_VISIBLE_VIEW]);
 
     if (priv->visible_view) {
+        g_queue_remove(&priv->recent_views, view);
+        g_queue_push_head(&priv->recent_views, view);
+
+        cog_viewport_restore_view(self, view, cog_viewport_get_lifecycle(priv, view));
+
         struct wpe_view_backend *backend = cog_view_get_backend(priv->visible_view);
         wpe_view_backend_add_activity_state(backend, wpe_view_activity_state_visible);
     }
+
+    cog_viewport_update_lifecycle(self, priv);
 }
 
 /**
@@ -272,6 +610,11 @@ cog_viewport_add(CogViewport *self, CogView *view)
     cog_view_set_viewport(view, self);
 
     g_ptr_array_add(priv->views, g_object_ref(view));
+    g_queue_push_head(&priv->recent_views, view);
+
+    ViewLifecycle *lifecycle = g_new0(ViewLifecycle, 1);
+    lifecycle->hidden_since = g_get_monotonic_time();
+    g_hash_table_insert(priv->lifecycle, view, lifecycle);
     g_signal_emit(self, s_signals[ADD], 0, view);
 
     struct wpe_view_backend *backend = cog_view_get_backend(view);
@@ -287,6 +630,8 @@ cog_viewport_add(CogViewport *self, CogView *view)
         g_debug("%s<%p>: adding view %p as invisible", G_STRFUNC, self, view);
         wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_visible);
         wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_focused);
+        cog_viewport_update_prerender(self, priv);
+        cog_viewport_update_lifecycle(self, priv);
     }
 
     g_signal_connect_swapped(WEBKIT_WEB_VIEW(view), "close", G_CALLBACK(cog_viewport_remove), self);
@@ -328,6 +673,8 @@ cog_viewport_remove(CogViewport *self, CogView *view)
 
     g_object_ref(view);
     g_ptr_array_remove_index(priv->views, index);
+    g_queue_remove(&priv->recent_views, view);
+    g_hash_table_remove(priv->lifecycle, view);
     g_signal_emit(self, s_signals[REMOVE], 0, view);
 
     if (priv->visible_view == view) {
@@ -339,9 +686,13 @@ cog_viewport_remove(CogViewport *self, CogView *view)
     }
 
     struct wpe_view_backend *backend = cog_view_get_backend(view);
+    wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_visible);
     wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_in_window);
     wpe_view_backend_remove_activity_state(backend, wpe_view_activity_state_focused);
 
+    /* Another hidden view may now fit within the pre-rendering limit. */
+    cog_viewport_update_prerender(self, priv);
+
     g_object_unref(view);
 }
 
@@ -470,3 +821,266 @@ cog_viewport_set_visible_view(CogViewport *self, CogView *view)
 
     cog_viewport_set_visible_view_internal(self, PRIV(self), view);
 }
+
+/**
+ * cog_viewport_get_prerender_limit: (get-property prerender-limit)
+ * @self: Viewport.
+ *
+ * Gets the maximum number of hidden views which keep rendering off-screen.
+ *
+ * Returns: Number of views.
+ *
+ * Since: 0.20
+ */
+unsigned
+cog_viewport_get_prerender_limit(CogViewport *self)
+{
+    g_return_val_if_fail(COG_IS_VIEWPORT(self), 0);
+    return PRIV(self)->prerender_limit;
+}
+
+/**
+ * cog_viewport_set_prerender_limit: (set-property prerender-limit)
+ * @self: Viewport.
+ * @limit: Number of views.
+ *
+ * Sets the maximum number of hidden views which keep rendering off-screen.
+ *
+ * The views which were most recently visible, or were most recently added
+ * to the viewport, are chosen. Lowering the limit suspends rendering of
+ * the least recently visible views beyond it.
+ *
+ * Since: 0.20
+ */
+void
+cog_viewport_set_prerender_limit(CogViewport *self, unsigned limit)
+{
+    g_return_if_fail(COG_IS_VIEWPORT(self));
+
+    CogViewportPrivate *priv = PRIV(self);
+    if (priv->prerender_limit == limit)
+        return;
+
+    priv->prerender_limit = limit;
+    cog_viewport_update_prerender(self, priv);
+    g_object_notify_by_pspec(G_OBJECT(self), s_properties[PROP_PRERENDER_LIMIT]);
+}
+
+/**
+ * cog_viewport_get_prerender_interval: (get-property prerender-interval)
+ * @self: Viewport.
+ *
+ * Gets the minimum time between frames of pre-rendered hidden views.
+ *
+ * Returns: Interval in milliseconds.
+ *
+ * Since: 0.20
+ */
+unsigned
+cog_viewport_get_prerender_interval(CogViewport *self)
+{
+    g_return_val_if_fail(COG_IS_VIEWPORT(self), DEFAULT_PRERENDER_INTERVAL);
+    return PRIV(self)->prerender_interval;
+}
+
+/**
+ * cog_viewport_set_prerender_interval: (set-property prerender-interval)
+ * @self: Viewport.
+ * @interval: Interval in milliseconds.
+ *
+ * Sets the minimum time between frames of pre-rendered hidden views.
+ *
+ * Platform implementations delay completion of the frames of hidden views
+ * by this amount, which lowers the pace at which WebKit renders them.
+ *
+ * Since: 0.20
+ */
+void
+cog_viewport_set_prerender_interval(CogViewport *self, unsigned interval)
+{
+    g_return_if_fail(COG_IS_VIEWPORT(self));
+    g_return_if_fail(interval > 0);
+
+    CogViewportPrivate *priv = PRIV(self);
+    if (priv->prerender_interval == interval)
+        return;
+
+    priv->prerender_interval = interval;
+    g_object_notify_by_pspec(G_OBJECT(self), s_properties[PROP_PRERENDER_INTERVAL]);
+}
+
+/**
+ * cog_viewport_is_prerendering:
+ * @self: Viewport.
+ * @view: A view contained in the viewport.
+ *
+ * Checks whether a hidden view is being rendered off-screen.
+ *
+ * Returns: Whether the view is hidden and pre-rendered.
+ *
+ * Since: 0.20
+ */
+gboolean
+cog_viewport_is_prerendering(CogViewport *self, CogView *view)
+{
+    g_return_val_if_fail(COG_IS_VIEWPORT(self), FALSE);
+    g_return_val_if_fail(COG_IS_VIEW(view), FALSE);
+
+    if (PRIV(self)->visible_view == view)
+        return FALSE;
+
+    return wpe_view_backend_get_activity_state(cog_view_get_backend(view)) & wpe_view_activity_state_visible;
+}
+
+/**
+ * cog_viewport_discard_hidden_views:
+ * @self: Viewport.
+ *
+ * Terminates the web process of all hidden views right away, regardless
+ * of [property@CogViewport:discard-delay]. This is typically done to give
+ * back memory when the system is running low on it. As with views
+ * discarded after the delay, pages are loaded again once their views
+ * become visible.
+ *
+ * Returns: Number of views discarded.
+ *
+ * Since: 0.20
+ */
+unsigned
+cog_viewport_discard_hidden_views(CogViewport *self)
+{
+    g_return_val_if_fail(COG_IS_VIEWPORT(self), 0);
+
+    CogViewportPrivate *priv = PRIV(self);
+    unsigned            n_discarded = 0;
+
+    for (unsigned i = 0; i < priv->views->len; i++) {
+        CogView *view = g_ptr_array_index(priv->views, i);
+        if (view == priv->visible_view)
+            continue;
+
+        ViewLifecycle *lifecycle = cog_viewport_get_lifecycle(priv, view);
+        if (lifecycle->tier == VIEW_TIER_DISCARDED)
+            continue;
+
+        for (ViewTier tier = lifecycle->tier + 1; tier < N_VIEW_TIERS; tier++)
+            cog_viewport_apply_tier(self, view, lifecycle, tier);
+        n_discarded++;
+    }
+
+    cog_viewport_update_lifecycle(self, priv);
+    return n_discarded;
+}
+
+static void
+cog_viewport_set_tier_delay(CogViewport *self, ViewTier tier, unsigned delay, unsigned prop_id)
+{
+    CogViewportPrivate *priv = PRIV(self);
+    if (priv->tier_delay[tier] == delay)
+        return;
+
+    priv->tier_delay[tier] = delay;
+    cog_viewport_update_lifecycle(self, priv);
+    g_object_notify_by_pspec(G_OBJECT(self), s_properties[prop_id]);
+}
+
+/**
+ * cog_viewport_get_throttle_delay: (get-property throttle-delay)
+ * @self: Viewport.
+ *
+ * Gets the time after which hidden views stop rendering.
+ *
+ * Returns: Delay in milliseconds, or %G_MAXUINT if disabled.
+ *
+ * Since: 0.20
+ */
+unsigned
+cog_viewport_get_throttle_delay(CogViewport *self)
+{
+    g_return_val_if_fail(COG_IS_VIEWPORT(self), G_MAXUINT);
+    return PRIV(self)->tier_delay[VIEW_TIER_THROTTLED];
+}
+
+/**
+ * cog_viewport_set_throttle_delay: (set-property throttle-delay)
+ * @self: Viewport.
+ * @delay: Delay in milliseconds, or %G_MAXUINT to disable.
+ *
+ * Sets the time after which hidden views stop rendering.
+ *
+ * Since: 0.20
+ */
+void
+cog_viewport_set_throttle_delay(CogViewport *self, unsigned delay)
+{
+    g_return_if_fail(COG_IS_VIEWPORT(self));
+    cog_viewport_set_tier_delay(self, VIEW_TIER_THROTTLED, delay, PROP_THROTTLE_DELAY);
+}
+
+/**
+ * cog_viewport_get_freeze_delay: (get-property freeze-delay)
+ * @self: Viewport.
+ *
+ * Gets the time after which hidden views are detached from the window.
+ *
+ * Returns: Delay in milliseconds, or %G_MAXUINT if disabled.
+ *
+ * Since: 0.20
+ */
+unsigned
+cog_viewport_get_freeze_delay(CogViewport *self)
+{
+    g_return_val_if_fail(COG_IS_VIEWPORT(self), G_MAXUINT);
+    return PRIV(self)->tier_delay[VIEW_TIER_FROZEN];
+}
+
+/**
+ * cog_viewport_set_freeze_delay: (set-property freeze-delay)
+ * @self: Viewport.
+ * @delay: Delay in milliseconds, or %G_MAXUINT to disable.
+ *
+ * Sets the time after which hidden views are detached from the window.
+ *
+ * Since: 0.20
+ */
+void
+cog_viewport_set_freeze_delay(CogViewport *self, unsigned delay)
+{
+    g_return_if_fail(COG_IS_VIEWPORT(self));
+    cog_viewport_set_tier_delay(self, VIEW_TIER_FROZEN, delay, PROP_FREEZE_DELAY);
+}
+
+/**
+ * cog_viewport_get_discard_delay: (get-property discard-delay)
+ * @self: Viewport.
+ *
+ * Gets the time after which the web process of hidden views is terminated.
+ *
+ * Returns: Delay in milliseconds, or %G_MAXUINT if disabled.
+ *
+ * Since: 0.20
+ */
+unsigned
+cog_viewport_get_discard_delay(CogViewport *self)
+{
+    g_return_val_if_fail(COG_IS_VIEWPORT(self), G_MAXUINT);
+    return PRIV(self)->tier_delay[VIEW_TIER_DISCARDED];
+}
+
+/**
+ * cog_viewport_set_discard_delay: (set-property discard-delay)
+ * @self: Viewport.
+ * @delay: Delay in milliseconds, or %G_MAXUINT to disable.
+ *
+ * Sets the time after which the web process of hidden views is terminated.
+ *
+ * Discarded views load their page again when they become visible.
+ *
+ * Since: 0.20
+ */
+void
+cog_viewport_set_discard_delay(CogViewport *self, unsigned delay)
+{
+    g_return_if_fail(COG_IS_VIEWPORT(self));
+    cog_viewport_set_tier_delay(self, VIEW_TIER_DISCARDED, delay, PROP_DISCARD_DELAY);
+}
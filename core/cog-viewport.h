@@ -46,4 +46,18 @@ COG_API CogView *cog_viewport_get_nth_view(CogViewport *self, gsize index);
 COG_API CogView *cog_viewport_get_visible_view(CogViewport *self);
 COG_API void     cog_viewport_set_visible_view(CogViewport *self, CogView *view);
 
+COG_API unsigned cog_viewport_get_prerender_limit(CogViewport *self);
+COG_API void     cog_viewport_set_prerender_limit(CogViewport *self, unsigned limit);
+COG_API unsigned cog_viewport_get_prerender_interval(CogViewport *self);
+COG_API void     cog_viewport_set_prerender_interval(CogViewport *self, unsigned interval);
+COG_API gboolean cog_viewport_is_prerendering(CogViewport *self, CogView *view);
+
+COG_API unsigned cog_viewport_get_throttle_delay(CogViewport *self);
+COG_API void     cog_viewport_set_throttle_delay(CogViewport *self, unsigned delay);
+COG_API unsigned cog_viewport_get_freeze_delay(CogViewport *self);
+COG_API void     cog_viewport_set_freeze_delay(CogViewport *self, unsigned delay);
+COG_API unsigned cog_viewport_get_discard_delay(CogViewport *self);
+COG_API void     cog_viewport_set_discard_delay(CogViewport *self, unsigned delay);
+COG_API unsigned cog_viewport_discard_hidden_views(CogViewport *self);
+
 G_END_DECLS
@@ -172,6 +172,8 @@ cog_handle_web_view_load_failed_with_tls_errors (WebKitWebView       *web_view,
  *
  * Handles unexpected web process termination, showing a simple error page
  * and logging a message to the standard error output.
+ * Terminations requested with webkit_web_view_terminate_web_process()
+ * are ignored.
  *
  * This function is typically used in a callback that handles the
  * [signal@WebKit.WebView::web-process-terminated] signal, and can be
@@ -205,6 +207,12 @@ cog_handle_web_view_web_process_terminated (WebKitWebView                     *w
             title = "Out of memory!";
             break;
 
+#if WEBKIT_CHECK_VERSION(2, 34, 0)
+        case WEBKIT_WEB_PROCESS_TERMINATED_BY_API:
+            /* Expected, e.g. when a CogViewport discards a hidden view. */
+            return FALSE;
+#endif /* WEBKIT_CHECK_VERSION */
+
         default:
             g_assert_not_reached ();
     }
@@ -222,6 +230,8 @@ cog_handle_web_view_web_process_terminated (WebKitWebView                     *w
  *
  * Handles unexpected web process termination, exiting the program with the
  * value passed as `userdata` as status.
+ * Terminations requested with webkit_web_view_terminate_web_process()
+ * are ignored.
  *
  * This function is typically used as a callback for the
  * [signal@WebKit.WebView::web-process-terminated-signal]:
@@ -247,6 +257,10 @@ cog_handle_web_view_web_process_terminated_exit (WebKitWebView
         case WEBKIT_WEB_PROCESS_EXCEEDED_MEMORY_LIMIT:
             reason_string = "ran out of memory";
             break;
+#if WEBKIT_CHECK_VERSION(2, 34, 0)
+        case WEBKIT_WEB_PROCESS_TERMINATED_BY_API:
+            return FALSE;
+#endif /* WEBKIT_CHECK_VERSION */
         default:
             g_assert_not_reached ();
     }
@@ -257,13 +271,68 @@ cog_handle_web_view_web_process_terminated_exit (WebKitWebView
 
 
 struct RestartData {
-    unsigned tries;
-    unsigned max_tries;
-    unsigned try_window_ms;
-    unsigned tries_timeout_id;
+    WebKitWebView              *web_view;
+    CogWebProcessRecoveryPolicy policy;
+    unsigned                    tries;
+    unsigned                    tries_timeout_id;
+    unsigned                    restart_timeout_id;
+    unsigned                    snapshot_timeout_id;
+    gulong                      load_changed_id;
+    WebKitWebViewSessionState  *session_state;
 };
 
 
+/* Updated atomically, so they may be read from any thread. */
+static struct {
+    int crashed;
+    int exceeded_memory_limit;
+    int restarts;
+    int failures;
+} s_termination_stats;
+
+
+static void
+remove_source (unsigned *source_id)
+{
+#if GLIB_CHECK_VERSION(2, 56, 0)
+    g_clear_handle_id (source_id, g_source_remove);
+#else
+    if (*source_id) {
+        g_source_remove (*source_id);
+        *source_id = 0;
+    }
+#endif // GLIB_CHECK_VERSION
+}
+
+
+static void
+take_session_snapshot (struct RestartData *restart)
+{
+    g_clear_pointer (&restart->session_state, webkit_web_view_session_state_unref);
+    restart->session_state = webkit_web_view_get_session_state (restart->web_view);
+}
+
+
+static gboolean
+on_session_snapshot_timeout (struct RestartData *restart)
+{
+    /* Pages which are still loading have no useful state yet. */
+    if (!webkit_web_view_is_loading (restart->web_view))
+        take_session_snapshot (restart);
+    return G_SOURCE_CONTINUE;
+}
+
+
+static void
+on_web_view_load_changed_snapshot (WebKitWebView      *web_view,
+                                   WebKitLoadEvent     load_event,
+                                   struct RestartData *restart)
+{
+    if (load_event == WEBKIT_LOAD_FINISHED)
+        take_session_snapshot (restart);
+}
+
+
 static gboolean
 reset_recovery_tries (struct RestartData *restart)
 {
@@ -273,46 +342,307 @@ reset_recovery_tries (struct RestartData *restart)
 }
 
 
+static gboolean
+restart_web_process (struct RestartData *restart)
+{
+    restart->restart_timeout_id = 0;
+
+    /*
+     * The back/forward list kept by the UI process outlives the web process,
+     * but the scroll positions and form contents stored in its items are only
+     * as fresh as the last snapshot. Restoring it and going to the current
+     * item brings those back, which a plain reload would not.
+     */
+    WebKitBackForwardListItem *item = NULL;
+    if (restart->session_state) {
+        webkit_web_view_restore_session_state (restart->web_view, restart->session_state);
+        item = webkit_back_forward_list_get_current_item (
+            webkit_web_view_get_back_forward_list (restart->web_view));
+    }
+
+    g_atomic_int_inc (&s_termination_stats.restarts);
+
+    if (item)
+        webkit_web_view_go_to_back_forward_list_item (restart->web_view, item);
+    else
+        webkit_web_view_reload (restart->web_view);
+
+    // Reset the count of attempts if the Web process does not crash again
+    // during the configure time window.
+    restart->tries_timeout_id = g_timeout_add (restart->policy.try_window_ms,
+                                               (GSourceFunc) reset_recovery_tries,
+                                               restart);
+    return G_SOURCE_REMOVE;
+}
+
+
+static unsigned
+get_restart_delay (const struct RestartData *restart)
+{
+    const CogWebProcessRecoveryPolicy *policy = &restart->policy;
+
+    if (!policy->backoff_initial_ms)
+        return 0;
+
+    /* Exponential backoff, doubling the delay after each attempt. */
+    guint64 delay = policy->backoff_initial_ms;
+    for (unsigned i = 1; i < restart->tries && delay < policy->backoff_max_ms; i++)
+        delay *= 2;
+    delay = MIN (delay, policy->backoff_max_ms);
+
+    /*
+     * Pick a random delay between half and the full value: when many
+     * devices lose their web process due to the same cause (e.g. a server
+     * sending them all the same bad content) this avoids having them all
+     * hitting the server again at the same time.
+     */
+    return (unsigned) g_random_double_range (delay / 2, delay + 1);
+}
+
+
 static gboolean
 on_web_process_terminated_restart (WebKitWebView                     *web_view,
                                    WebKitWebProcessTerminationReason  reason,
                                    struct RestartData                *restart)
 {
-#if GLIB_CHECK_VERSION(2, 56, 0)
-    g_clear_handle_id (&restart->tries_timeout_id, g_source_remove);
-#else
-    if (restart->tries_timeout_id) {
-        g_source_remove (restart->tries_timeout_id);
-        restart->tries_timeout_id = 0;
+    const char *reason_string = NULL;
+
+    switch (reason) {
+        case WEBKIT_WEB_PROCESS_CRASHED:
+            g_atomic_int_inc (&s_termination_stats.crashed);
+            reason_string = "crashed";
+            break;
+        case WEBKIT_WEB_PROCESS_EXCEEDED_MEMORY_LIMIT:
+            g_atomic_int_inc (&s_termination_stats.exceeded_memory_limit);
+            reason_string = "exceeded the memory limit";
+            break;
+#if WEBKIT_CHECK_VERSION(2, 34, 0)
+        case WEBKIT_WEB_PROCESS_TERMINATED_BY_API:
+            return FALSE;
+#endif /* WEBKIT_CHECK_VERSION */
+        default:
+            g_assert_not_reached ();
     }
-#endif // GLIB_CHECK_VERSION
 
-    if (++restart->tries >= restart->max_tries) {
-        g_critical ("Renderer process terminated and failed to recover within %ums",
-                    restart->try_window_ms);
+    remove_source (&restart->tries_timeout_id);
+    remove_source (&restart->restart_timeout_id);
+
+    if (++restart->tries >= restart->policy.max_tries) {
+        g_atomic_int_inc (&s_termination_stats.failures);
+        g_critical ("Renderer process %s and failed to recover within %ums",
+                    reason_string, restart->policy.try_window_ms);
         // Chain up to the handler that renders an error page.
         return cog_handle_web_view_web_process_terminated (web_view, reason, NULL);
     }
 
-    g_warning ("Renderer process terminated, restarting (attempt %u/%u).",
-               restart->tries, restart->max_tries);
-    webkit_web_view_reload (web_view);
+    unsigned delay = get_restart_delay (restart);
+    g_warning ("Renderer process %s, restarting in %ums (attempt %u/%u).",
+               reason_string, delay, restart->tries, restart->policy.max_tries);
+
+    if (delay)
+        restart->restart_timeout_id = g_timeout_add (delay, (GSourceFunc) restart_web_process, restart);
+    else
+        restart_web_process (restart);
 
-    // Reset the count of attempts if the Web process does not crash again
-    // during the configure time window.
-    restart->tries_timeout_id = g_timeout_add (restart->try_window_ms,
-                                               (GSourceFunc) reset_recovery_tries,
-                                               restart);
     return TRUE;
 }
 
 
 static void
-free_restart_data (void *restart, G_GNUC_UNUSED GClosure *closure)
+free_restart_data (void *data, G_GNUC_UNUSED GClosure *closure)
 {
+    struct RestartData *restart = data;
+
+    remove_source (&restart->tries_timeout_id);
+    remove_source (&restart->restart_timeout_id);
+    remove_source (&restart->snapshot_timeout_id);
+
+    /* Handlers may have been destroyed already if the view is being disposed. */
+    if (g_signal_handler_is_connected (restart->web_view, restart->load_changed_id))
+        g_signal_handler_disconnect (restart->web_view, restart->load_changed_id);
+
+    g_clear_pointer (&restart->session_state, webkit_web_view_session_state_unref);
     g_slice_free (struct RestartData, restart);
 }
 
+/**
+ * cog_web_process_recovery_policy_init:
+ * @policy: A recovery policy.
+ *
+ * Initializes a recovery policy with the default values.
+ *
+ * Since: 0.20
+ */
+void
+cog_web_process_recovery_policy_init (CogWebProcessRecoveryPolicy *policy)
+{
+    g_return_if_fail (policy);
+
+    *policy = (CogWebProcessRecoveryPolicy) {
+        .max_tries = 5,
+        .try_window_ms = 1000,
+        .backoff_initial_ms = 100,
+        .backoff_max_ms = 30000,
+        .snapshot_interval_ms = 5000,
+    };
+}
+
+/**
+ * cog_web_process_recovery_policy_set:
+ * @policy: A recovery policy.
+ * @key: Name of the setting.
+ * @value: Value for the setting.
+ * @error: Location where to store an error.
+ *
+ * Sets one of the fields of a recovery policy from its textual
+ * representation. The accepted keys are `max-tries`, `try-window`,
+ * `backoff`, `backoff-max`, and `snapshot-interval`; all of them take
+ * unsigned integers, and times are in milliseconds.
+ *
+ * This is meant to be used to parse policies from command line options
+ * and configuration files.
+ *
+ * Returns: Whether the setting was applied.
+ *
+ * Since: 0.20
+ */
+gboolean
+cog_web_process_recovery_policy_set (CogWebProcessRecoveryPolicy *policy,
+                                     const char                  *key,
+                                     const char                  *value,
+                                     GError                     **error)
+{
+    g_return_val_if_fail (policy, FALSE);
+    g_return_val_if_fail (key, FALSE);
+    g_return_val_if_fail (value, FALSE);
+
+    /* clang-format off */
+    static const struct {
+        const char *key;
+        size_t      offset;
+    } fields[] = {
+        { "max-tries",         G_STRUCT_OFFSET (CogWebProcessRecoveryPolicy, max_tries) },
+        { "try-window",        G_STRUCT_OFFSET (CogWebProcessRecoveryPolicy, try_window_ms) },
+        { "backoff",           G_STRUCT_OFFSET (CogWebProcessRecoveryPolicy, backoff_initial_ms) },
+        { "backoff-max",       G_STRUCT_OFFSET (CogWebProcessRecoveryPolicy, backoff_max_ms) },
+        { "snapshot-interval", G_STRUCT_OFFSET (CogWebProcessRecoveryPolicy, snapshot_interval_ms) },
+    };
+    /* clang-format on */
+
+    for (unsigned i = 0; i < G_N_ELEMENTS (fields); i++) {
+        if (strcmp (key, fields[i].key) != 0)
+            continue;
+
+        char   *end = NULL;
+        guint64 number = g_ascii_strtoull (value, &end, 10);
+        if (!g_ascii_isdigit (*value) || *end != '\0' || number > G_MAXUINT ||
+            (number == 0 && strcmp (key, "max-tries") == 0)) {
+            g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                         "Invalid value '%s' for '%s'", value, key);
+            return FALSE;
+        }
+        G_STRUCT_MEMBER (unsigned, policy, fields[i].offset) = (unsigned) number;
+        return TRUE;
+    }
+
+    g_set_error (error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND,
+                 "Unknown recovery setting '%s'", key);
+    return FALSE;
+}
+
+/**
+ * cog_web_process_get_termination_stats:
+ * @stats: (out): Location where to store the statistics.
+ *
+ * Retrieves process-wide counts of web process terminations, and of the
+ * recovery attempts made by handlers installed with
+ * [id@cog_web_view_connect_web_process_recovery_handler]. Terminations
+ * are only counted for web views which have such a handler.
+ *
+ * This function can be called from any thread.
+ *
+ * Since: 0.20
+ */
+void
+cog_web_process_get_termination_stats (CogWebProcessTerminationStats *stats)
+{
+    g_return_if_fail (stats);
+
+    stats->crashed = g_atomic_int_get (&s_termination_stats.crashed);
+    stats->exceeded_memory_limit = g_atomic_int_get (&s_termination_stats.exceeded_memory_limit);
+    stats->restarts = g_atomic_int_get (&s_termination_stats.restarts);
+    stats->failures = g_atomic_int_get (&s_termination_stats.failures);
+}
+
+/**
+ * cog_web_view_connect_web_process_recovery_handler:
+ * @web_view: A [class@WebKit.WebView].
+ * @policy: Recovery policy.
+ *
+ * Handles unexpected web process termination, trying to restart the web
+ * process and bring the page back to the state it was in.
+ *
+ * While the web process runs, the session state of the web view (see
+ * [method@WebKit.WebView.get_session_state]) is saved each time a page
+ * finishes loading, and every `snapshot_interval_ms` milliseconds if
+ * non-zero. On termination the last saved state is restored, which keeps
+ * the navigation history along with the scroll positions and form contents
+ * stored in it, before loading the current page again.
+ *
+ * Restarts are delayed using exponential backoff: the first one happens
+ * after `backoff_initial_ms` milliseconds, and the delay doubles with each
+ * subsequent attempt up to `backoff_max_ms`. A random jitter of up to
+ * half of the delay is applied. Setting `backoff_initial_ms` to zero
+ * restarts immediately.
+ *
+ * Once `max_tries` attempts have been made without the web process staying
+ * alive for `try_window_ms` milliseconds after a restart, an error page
+ * is displayed instead. The count of attempts is reset to zero when the
+ * web process survives for that long.
+ *
+ * Termination reasons are logged and accounted for; see
+ * [id@cog_web_process_get_termination_stats].
+ *
+ * This function will connect its own callback to the
+ * [signal@WebKit.WebView::web-process-terminated] signal. The identifier
+ * of the installed signal handler is returned, which allows to disconnect
+ * it if needed.
+ *
+ * Returns: Identifier of the installed signal handler.
+ *
+ * Since: 0.20
+ */
+gulong
+cog_web_view_connect_web_process_recovery_handler (WebKitWebView                     *web_view,
+                                                   const CogWebProcessRecoveryPolicy *policy)
+{
+    g_return_val_if_fail (WEBKIT_IS_WEB_VIEW (web_view), 0);
+    g_return_val_if_fail (policy, 0);
+    g_return_val_if_fail (policy->max_tries > 0, 0);
+
+    struct RestartData *restart = g_slice_new0 (struct RestartData);
+    restart->web_view = web_view;
+    restart->policy = *policy;
+    restart->policy.backoff_max_ms = MAX (policy->backoff_max_ms, policy->backoff_initial_ms);
+
+    restart->load_changed_id = g_signal_connect (web_view,
+                                                 "load-changed",
+                                                 G_CALLBACK (on_web_view_load_changed_snapshot),
+                                                 restart);
+    if (policy->snapshot_interval_ms) {
+        restart->snapshot_timeout_id = g_timeout_add (policy->snapshot_interval_ms,
+                                                      (GSourceFunc) on_session_snapshot_timeout,
+                                                      restart);
+    }
+
+    return g_signal_connect_data (web_view,
+                                  "web-process-terminated",
+                                  G_CALLBACK (on_web_process_terminated_restart),
+                                  restart,
+                                  free_restart_data,
+                                  0);
+}
+
 /**
  * cog_web_view_connect_web_process_terminated_restart_handler:
  * @web_view: A [class@WebKit.WebView].
@@ -332,6 +662,10 @@ free_restart_data (void *restart, G_GNUC_UNUSED GClosure *closure)
  * - If the retry window timer expires without the web process being
  *   terminated again, the count of attempts done is reset to zero.
  *
+ * Restarts happen immediately. This is equivalent to using
+ * [id@cog_web_view_connect_web_process_recovery_handler] with the default
+ * policy, the given retry settings, and no backoff.
+ *
  * This function will connect its own callback to the
  * [signal@WebKit.WebView::web-process-terminated] signal. The identifier
  * of the installed signal handler is returned, which allows to disconnect
@@ -347,16 +681,13 @@ cog_web_view_connect_web_process_terminated_restart_handler (WebKitWebView *web_
     g_return_val_if_fail (WEBKIT_IS_WEB_VIEW (web_view), 0);
     g_return_val_if_fail (max_tries > 0, 0);
 
-    struct RestartData *restart = g_slice_new0 (struct RestartData);
-    restart->max_tries = max_tries;
-    restart->try_window_ms = try_window_ms;
+    CogWebProcessRecoveryPolicy policy;
+    cog_web_process_recovery_policy_init (&policy);
+    policy.max_tries = max_tries;
+    policy.try_window_ms = try_window_ms;
+    policy.backoff_initial_ms = 0;
 
-    return g_signal_connect_data (web_view,
-                                  "web-process-terminated",
-                                  G_CALLBACK (on_web_process_terminated_restart),
-                                  restart,
-                                  free_restart_data,
-                                  0);
+    return cog_web_view_connect_web_process_recovery_handler (web_view, &policy);
 }
 
 /**
@@ -59,6 +59,65 @@ gulong cog_web_view_connect_web_process_terminated_restart_handler (WebKitWebVie
                                                                     unsigned       max_tries,
                                                                     unsigned       try_window_ms);
 
+/**
+ * CogWebProcessRecoveryPolicy:
+ * @max_tries: Maximum number of restart attempts within the retry window.
+ * @try_window_ms: Time the web process needs to survive after a restart
+ *    for the count of attempts to be reset, in milliseconds.
+ * @backoff_initial_ms: Delay before the first restart attempt, in
+ *    milliseconds. Zero restarts immediately, without backoff.
+ * @backoff_max_ms: Maximum delay between restart attempts, in milliseconds.
+ * @snapshot_interval_ms: Interval between periodic snapshots of the session
+ *    state, in milliseconds. Zero only takes snapshots after page loads.
+ *
+ * Policy used by [id@cog_web_view_connect_web_process_recovery_handler].
+ *
+ * Since: 0.20
+ */
+typedef struct {
+    unsigned max_tries;
+    unsigned try_window_ms;
+    unsigned backoff_initial_ms;
+    unsigned backoff_max_ms;
+    unsigned snapshot_interval_ms;
+} CogWebProcessRecoveryPolicy;
+
+/**
+ * CogWebProcessTerminationStats:
+ * @crashed: Number of times that the web process crashed.
+ * @exceeded_memory_limit: Number of times that the web process was
+ *    terminated for exceeding its memory limit.
+ * @restarts: Number of restart attempts made.
+ * @failures: Number of times that the web process could not be recovered
+ *    and an error page was shown instead.
+ *
+ * Counters retrieved with [id@cog_web_process_get_termination_stats].
+ *
+ * Since: 0.20
+ */
+typedef struct {
+    unsigned crashed;
+    unsigned exceeded_memory_limit;
+    unsigned restarts;
+    unsigned failures;
+} CogWebProcessTerminationStats;
+
+COG_API
+void cog_web_process_recovery_policy_init (CogWebProcessRecoveryPolicy *policy);
+
+COG_API
+gboolean cog_web_process_recovery_policy_set (CogWebProcessRecoveryPolicy *policy,
+                                              const char                  *key,
+                                              const char                  *value,
+                                              GError                     **error);
+
+COG_API
+gulong cog_web_view_connect_web_process_recovery_handler (WebKitWebView                     *web_view,
+                                                          const CogWebProcessRecoveryPolicy *policy);
+
+COG_API
+void cog_web_process_get_termination_stats (CogWebProcessTerminationStats *stats);
+
 COG_API
 void cog_web_view_connect_default_error_handlers (WebKitWebView *web_view);
 
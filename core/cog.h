@@ -14,13 +14,18 @@
 
 #include "cog-config.h"
 #include "cog-directory-files-handler.h"
+#include "cog-disk-cache.h"
 #include "cog-gamepad.h"
 #include "cog-host-routes-handler.h"
+#include "cog-metrics-exporter.h"
+#include "cog-metrics.h"
 #include "cog-modules.h"
 #include "cog-platform.h"
 #include "cog-prefix-routes-handler.h"
+#include "cog-profile.h"
 #include "cog-request-handler.h"
 #include "cog-shell.h"
+#include "cog-trace.h"
 #include "cog-utils.h"
 #include "cog-view.h"
 #include "cog-viewport.h"
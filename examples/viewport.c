@@ -46,6 +46,9 @@ main(int argc, char *argv[])
     g_autoptr(CogViewport) viewport = cog_viewport_new();
     g_autoptr(GMainLoop) loop = g_main_loop_new(NULL, FALSE);
 
+    /* Keep all hidden views rendered, so switching among them is instant. */
+    cog_viewport_set_prerender_limit(viewport, argc - 2);
+
     for (int i = 1; i < argc; i++) {
         g_autoptr(CogView) view = cog_view_new(NULL);
         cog_platform_init_web_view(platform, WEBKIT_WEB_VIEW(view));
@@ -11,9 +11,11 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define HAVE_WEBKIT_NETWORK_PROXY_API WEBKIT_CHECK_VERSION(2, 32, 0)
 #define HAVE_WEBKIT_AUTOPLAY          WEBKIT_CHECK_VERSION(2, 30, 0)
+#define HAVE_WEBKIT_EVALUATE_JS       WEBKIT_CHECK_VERSION(2, 40, 0)
 
 enum webprocess_fail_action {
     WEBPROCESS_FAIL_UNKNOWN = 0,
@@ -31,7 +33,11 @@ static struct {
     };
     gboolean version;
     gboolean print_appid;
-    gboolean doc_viewer;
+    gboolean         doc_viewer;
+    WebKitCacheModel cache_model;
+    char            *disk_cache_dir;
+    char            *disk_cache_seed;
+    int              disk_cache_max_size;
     gdouble  scale_factor;
     gdouble  device_scale_factor;
     union {
@@ -45,13 +51,15 @@ static struct {
         char *platform_name;
     };
     union {
-        char                    *filter_path;
-        WebKitUserContentFilter *filter;
+        char  *filter_path;
+        GFile *filter_file;
     };
     union {
         char                       *action_name;
         enum webprocess_fail_action action_id;
     } on_failure;
+    char                       *restart_params;
+    CogWebProcessRecoveryPolicy restart_policy;
     char    *web_extensions_dir;
     gboolean ignore_tls_errors;
 #if !COG_USE_WPE2
@@ -66,7 +74,13 @@ static struct {
 #if HAVE_WEBKIT_AUTOPLAY
     WebKitAutoplayPolicy autoplay_policy;
 #endif
+    int      prewarm_count;
+    gboolean startup_profile;
+    gboolean memory_monitor;
+    char    *metrics_exporter;
+    gboolean enable_script_evaluation;
 } s_options = {
+    .cache_model = WEBKIT_CACHE_MODEL_WEB_BROWSER,
     .scale_factor = 1.0,
     .device_scale_factor = 1.0,
 #if HAVE_WEBKIT_AUTOPLAY
@@ -96,9 +110,17 @@ g_clear_handle_id(guint *tag_ptr, GClearHandleFunc clear_func)
 #    define G_SOURCE_FUNC(f) ((GSourceFunc) (void (*)(void))(f))
 #endif
 
+enum {
+    DBUS_OBJECT_METRICS,
+    DBUS_OBJECT_SCRIPT,
+    DBUS_OBJECT_TRACE,
+    N_DBUS_OBJECTS,
+};
+
 enum {
     PROP_0,
     PROP_AUTOMATED,
+    PROP_DISK_CACHE_DIR,
 };
 
 /**
@@ -116,6 +138,7 @@ struct _CogLauncher {
     CogShell    *shell;
     gboolean     allow_all_requests;
     gboolean     automated;
+    char        *disk_cache_dir;
 
     WebKitSettings           *web_settings;
 #if COG_USE_WPE2
@@ -131,8 +154,20 @@ struct _CogLauncher {
 
     guint sigint_source;
     guint sigterm_source;
+    guint sigusr1_source;
 
     CogViewport *viewport;
+
+    gboolean      filter_pending;
+    GCancellable *filter_cancellable;
+    char         *pending_uri;
+
+    guint               dbus_registration_ids[N_DBUS_OBJECTS];
+    CogMetricsExporter *metrics_exporter;
+
+    unsigned scripts_running;
+    double   script_tokens;
+    int64_t  script_tokens_time;
 };
 
 G_DEFINE_TYPE(CogLauncher, cog_launcher, G_TYPE_APPLICATION)
@@ -175,6 +210,32 @@ on_action_open(G_GNUC_UNUSED GAction *action, GVariant *param, CogLauncher *laun
     webkit_web_view_load_uri(cog_launcher_get_visible_view(launcher), g_variant_get_string(param, NULL));
 }
 
+static void
+on_action_video_mode(G_GNUC_UNUSED GAction *action, GVariant *param, G_GNUC_UNUSED CogLauncher *launcher)
+{
+    g_return_if_fail(g_variant_is_of_type(param, G_VARIANT_TYPE_STRING));
+
+    CogPlatform *platform = cog_platform_get();
+    if (!g_object_class_find_property(G_OBJECT_GET_CLASS(platform), "video-mode")) {
+        g_warning("Platform '%s' does not support changing the video mode.", G_OBJECT_TYPE_NAME(platform));
+        return;
+    }
+    g_object_set(platform, "video-mode", g_variant_get_string(param, NULL), NULL);
+}
+
+static void
+on_action_save_splash(G_GNUC_UNUSED GAction *action, G_GNUC_UNUSED GVariant *param, G_GNUC_UNUSED CogLauncher *launcher)
+{
+    CogPlatform *platform = cog_platform_get();
+    if (!g_signal_lookup("save-splash", G_OBJECT_TYPE(platform))) {
+        g_warning("Platform '%s' does not support boot splashes.", G_OBJECT_TYPE_NAME(platform));
+        return;
+    }
+
+    gboolean saved = FALSE;
+    g_signal_emit_by_name(platform, "save-splash", &saved);
+}
+
 static gboolean
 on_signal_quit(CogLauncher *launcher)
 {
@@ -182,6 +243,20 @@ on_signal_quit(CogLauncher *launcher)
     return G_SOURCE_CONTINUE;
 }
 
+static gboolean
+on_signal_dump_trace(G_GNUC_UNUSED CogLauncher *launcher)
+{
+    g_autofree char *name = g_strdup_printf("cog-%d-trace.json", getpid());
+    g_autofree char *path = g_build_filename(g_get_tmp_dir(), name, NULL);
+
+    g_autoptr(GError) error = NULL;
+    if (cog_trace_dump(path, &error))
+        g_message("Trace written to %s", path);
+    else
+        g_warning("Cannot write trace: %s", error->message);
+    return G_SOURCE_CONTINUE;
+}
+
 static gboolean
 on_permission_request(G_GNUC_UNUSED WebKitWebView *web_view, WebKitPermissionRequest *request, CogLauncher *launcher)
 {
@@ -221,12 +296,413 @@ cog_launcher_open(GApplication *application, GFile **files, int n_files, const c
 }
 
 static void *
-on_web_view_create(WebKitWebView *web_view, WebKitNavigationAction *action)
+on_web_view_create(WebKitWebView *web_view, WebKitNavigationAction *action, CogLauncher *launcher)
 {
-    webkit_web_view_load_request(web_view, webkit_navigation_action_get_request(action));
+    WebKitURIRequest *request = webkit_navigation_action_get_request(action);
+
+    /*
+     * Views returned from here must be related to the opener, which prewarmed
+     * views are not: the new view is added to the viewport and loaded instead,
+     * without a window.opener, same as when reusing the current view.
+     */
+    g_autoptr(CogView) new_view = cog_shell_take_prewarmed_view(launcher->shell);
+    if (!new_view) {
+        webkit_web_view_load_request(web_view, request);
+        return NULL;
+    }
+
+    cog_platform_init_web_view(cog_platform_get(), WEBKIT_WEB_VIEW(new_view));
+    g_signal_connect(new_view, "permission-request", G_CALLBACK(on_permission_request), launcher);
+    g_signal_connect(new_view, "create", G_CALLBACK(on_web_view_create), launcher);
+
+    cog_viewport_add(launcher->viewport, new_view);
+    cog_viewport_set_visible_view(launcher->viewport, new_view);
+    webkit_web_view_load_request(WEBKIT_WEB_VIEW(new_view), request);
     return NULL;
 }
 
+#define METRICS_INTERFACE "com.igalia.Cog1.Metrics"
+#define SCRIPT_INTERFACE  "com.igalia.Cog1.Script"
+#define TRACE_INTERFACE   "com.igalia.Cog1.Trace"
+
+/* clang-format off */
+static const char s_introspection_xml[] =
+    "<node>"
+    "  <interface name='" METRICS_INTERFACE "'>"
+    "    <method name='GetStats'>"
+    "      <arg name='stats' type='a{sv}' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "  <interface name='" SCRIPT_INTERFACE "'>"
+    "    <method name='Evaluate'>"
+    "      <arg name='script' type='s' direction='in'/>"
+    "      <arg name='timeout' type='u' direction='in'/>"
+    "      <arg name='result' type='s' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "  <interface name='" TRACE_INTERFACE "'>"
+    "    <method name='GetEvents'>"
+    "      <arg name='trace' type='s' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+/* clang-format on */
+
+/* Limits for Evaluate, which may be reachable by other users through the system bus. */
+#define SCRIPT_MAX_SIZE           (64 * 1024)
+#define SCRIPT_RESULT_MAX_SIZE    (64 * 1024)
+#define SCRIPT_TIMEOUT_DEFAULT_MS 5000
+#define SCRIPT_TIMEOUT_MAX_MS     60000
+#define SCRIPT_MAX_RUNNING        4
+#define SCRIPT_RATE               10 /* Evaluations per second, and burst size. */
+
+static GDBusInterfaceInfo *
+dbus_interface_info(const char *name)
+{
+    static GDBusNodeInfo *node_info = NULL;
+    if (g_once_init_enter(&node_info)) {
+        GDBusNodeInfo *info = g_dbus_node_info_new_for_xml(s_introspection_xml, NULL);
+        g_assert(info);
+        g_once_init_leave(&node_info, info);
+    }
+    return g_dbus_node_info_lookup_interface(node_info, name);
+}
+
+static GVariant *
+metrics_get_stats(void)
+{
+    g_auto(GVariantBuilder) builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+
+    for (CogMetric metric = 0; metric < COG_METRIC_LAST; metric++)
+        g_variant_builder_add(&builder, "{sv}", cog_metrics_get_name(metric),
+                              g_variant_new_uint64(cog_metrics_get(metric)));
+
+    g_variant_builder_add(&builder, "{sv}", "frame-time-p50",
+                          g_variant_new_uint64(cog_metrics_get_frame_time_percentile(50)));
+    g_variant_builder_add(&builder, "{sv}", "frame-time-p90",
+                          g_variant_new_uint64(cog_metrics_get_frame_time_percentile(90)));
+    g_variant_builder_add(&builder, "{sv}", "frame-time-p99",
+                          g_variant_new_uint64(cog_metrics_get_frame_time_percentile(99)));
+
+    const uint64_t requests = cog_metrics_get(COG_METRIC_REQUESTS);
+    if (requests) {
+        const uint64_t errors = cog_metrics_get(COG_METRIC_REQUEST_ERRORS);
+        g_variant_builder_add(&builder, "{sv}", "request-hit-rate",
+                              g_variant_new_double((double) (requests - MIN(errors, requests)) / requests));
+    }
+
+    uint64_t rss_bytes, cpu_time_usec;
+    if (cog_metrics_get_web_process_usage(&rss_bytes, &cpu_time_usec)) {
+        g_variant_builder_add(&builder, "{sv}", "web-process-rss", g_variant_new_uint64(rss_bytes));
+        g_variant_builder_add(&builder, "{sv}", "web-process-cpu-time", g_variant_new_uint64(cpu_time_usec));
+    }
+
+    CogWebProcessTerminationStats termination;
+    cog_web_process_get_termination_stats(&termination);
+    g_variant_builder_add(&builder, "{sv}", "web-process-crashes", g_variant_new_uint32(termination.crashed));
+    g_variant_builder_add(&builder, "{sv}", "web-process-oom",
+                          g_variant_new_uint32(termination.exceeded_memory_limit));
+    g_variant_builder_add(&builder, "{sv}", "web-process-restarts", g_variant_new_uint32(termination.restarts));
+    g_variant_builder_add(&builder, "{sv}", "web-process-recovery-failures",
+                          g_variant_new_uint32(termination.failures));
+
+    return g_variant_builder_end(&builder);
+}
+
+static void
+on_metrics_method_call(G_GNUC_UNUSED GDBusConnection *connection,
+                       G_GNUC_UNUSED const char      *sender,
+                       G_GNUC_UNUSED const char      *object_path,
+                       G_GNUC_UNUSED const char      *interface_name,
+                       const char                    *method_name,
+                       G_GNUC_UNUSED GVariant        *parameters,
+                       GDBusMethodInvocation         *invocation,
+                       G_GNUC_UNUSED void            *userdata)
+{
+    /* Everything is computed here, so nothing is sampled unless someone asks. */
+    if (g_str_equal(method_name, "GetStats")) {
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(@a{sv})", metrics_get_stats()));
+    } else {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+                                              "Unknown method %s", method_name);
+    }
+}
+
+typedef struct {
+    CogLauncher           *launcher;
+    GDBusMethodInvocation *invocation;
+    unsigned               timeout_ms;
+    guint                  timeout_id;
+} ScriptData;
+
+static void
+script_data_free(ScriptData *data)
+{
+    g_clear_handle_id(&data->timeout_id, g_source_remove);
+    data->launcher->scripts_running--;
+
+    g_object_unref(data->launcher);
+    g_clear_object(&data->invocation);
+    g_free(data);
+}
+
+static gboolean
+on_script_timeout(ScriptData *data)
+{
+    /*
+     * A script which keeps running cannot be interrupted, but the caller
+     * gets a reply now. Its slot is released only when the evaluation does
+     * complete, for the result to be discarded; cancelling would complete it
+     * right away while the script still runs in the web process.
+     */
+    data->timeout_id = 0;
+    g_dbus_method_invocation_return_error(g_steal_pointer(&data->invocation), G_DBUS_ERROR, G_DBUS_ERROR_TIMEOUT,
+                                          "Script did not finish in %u ms", data->timeout_ms);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+script_return_result(ScriptData *data, JSCValue *value, GError *error)
+{
+    /* Returning a value or an error consumes the invocation. */
+    GDBusMethodInvocation *invocation = g_steal_pointer(&data->invocation);
+    if (!invocation)
+        return;
+
+    if (!value) {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_FAILED, "%s",
+                                              error->message);
+        return;
+    }
+
+    g_autofree char *json = jsc_value_to_json(value, 0);
+
+    /* Values which cannot be serialized, e.g. with cycles, raise an exception. */
+    JSCContext   *context = jsc_value_get_context(value);
+    JSCException *exception = jsc_context_get_exception(context);
+    if (exception) {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                              "Cannot serialize result: %s", jsc_exception_get_message(exception));
+        jsc_context_clear_exception(context);
+        return;
+    }
+
+    if (json && strlen(json) > SCRIPT_RESULT_MAX_SIZE) {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_LIMITS_EXCEEDED,
+                                              "Result is larger than %u bytes", SCRIPT_RESULT_MAX_SIZE);
+        return;
+    }
+
+    /* Values without a JSON representation, like undefined, are reported as null. */
+    g_dbus_method_invocation_return_value(invocation, g_variant_new("(s)", json ? json : "null"));
+}
+
+static void
+on_script_evaluated(GObject *object, GAsyncResult *result, void *userdata)
+{
+    ScriptData *data = userdata;
+
+    g_autoptr(GError) error = NULL;
+#if HAVE_WEBKIT_EVALUATE_JS
+    g_autoptr(JSCValue) value = webkit_web_view_evaluate_javascript_finish(WEBKIT_WEB_VIEW(object), result, &error);
+#else
+    g_autoptr(WebKitJavascriptResult) js_result =
+        webkit_web_view_run_javascript_finish(WEBKIT_WEB_VIEW(object), result, &error);
+    JSCValue *value = js_result ? webkit_javascript_result_get_js_value(js_result) : NULL;
+#endif
+
+    script_return_result(data, value, error);
+    script_data_free(data);
+}
+
+static gboolean
+script_rate_limit_take(CogLauncher *self)
+{
+    /* Token bucket, refilled continuously at SCRIPT_RATE tokens per second. */
+    const int64_t now = g_get_monotonic_time();
+    self->script_tokens =
+        MIN(SCRIPT_RATE, self->script_tokens + (now - self->script_tokens_time) * SCRIPT_RATE / (double) G_USEC_PER_SEC);
+    self->script_tokens_time = now;
+
+    if (self->script_tokens < 1.0)
+        return FALSE;
+
+    self->script_tokens -= 1.0;
+    return TRUE;
+}
+
+static void
+script_evaluate(CogLauncher *self, GVariant *parameters, GDBusMethodInvocation *invocation)
+{
+    const char *script;
+    unsigned    timeout_ms;
+    g_variant_get(parameters, "(&su)", &script, &timeout_ms);
+
+    const size_t length = strlen(script);
+    if (length > SCRIPT_MAX_SIZE) {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_LIMITS_EXCEEDED,
+                                              "Script is larger than %u bytes", SCRIPT_MAX_SIZE);
+        return;
+    }
+    if (self->scripts_running >= SCRIPT_MAX_RUNNING || !script_rate_limit_take(self)) {
+        g_dbus_method_invocation_return_error_literal(invocation, G_DBUS_ERROR, G_DBUS_ERROR_LIMITS_EXCEEDED,
+                                                      "Too many scripts, try again later");
+        return;
+    }
+
+    WebKitWebView *web_view = self->viewport ? cog_launcher_get_visible_view(self) : NULL;
+    if (!web_view) {
+        g_dbus_method_invocation_return_error_literal(invocation, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+                                                      "No web view to run the script in");
+        return;
+    }
+
+    ScriptData *data = g_new0(ScriptData, 1);
+    data->launcher = g_object_ref(self);
+    data->invocation = invocation;
+    data->timeout_ms = timeout_ms ? MIN(timeout_ms, SCRIPT_TIMEOUT_MAX_MS) : SCRIPT_TIMEOUT_DEFAULT_MS;
+    data->timeout_id = g_timeout_add(data->timeout_ms, G_SOURCE_FUNC(on_script_timeout), data);
+    self->scripts_running++;
+
+#if HAVE_WEBKIT_EVALUATE_JS
+    webkit_web_view_evaluate_javascript(web_view, script, length, NULL, NULL, NULL, on_script_evaluated, data);
+#else
+    webkit_web_view_run_javascript(web_view, script, NULL, on_script_evaluated, data);
+#endif
+}
+
+static void
+on_script_caller_user(GObject *object, GAsyncResult *result, void *userdata)
+{
+    GDBusMethodInvocation *invocation = userdata;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GVariant) reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object), result, &error);
+    if (!reply) {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        return;
+    }
+
+    guint32 uid;
+    g_variant_get(reply, "(u)", &uid);
+    if (uid != 0 && uid != getuid()) {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                                              "Scripts may only be evaluated by root or the user running Cog");
+        return;
+    }
+
+    script_evaluate(COG_LAUNCHER(g_dbus_method_invocation_get_user_data(invocation)),
+                    g_dbus_method_invocation_get_parameters(invocation), invocation);
+}
+
+static void
+on_script_method_call(GDBusConnection          *connection,
+                      const char               *sender,
+                      G_GNUC_UNUSED const char *object_path,
+                      G_GNUC_UNUSED const char *interface_name,
+                      const char               *method_name,
+                      GVariant                 *parameters,
+                      GDBusMethodInvocation    *invocation,
+                      void                     *userdata)
+{
+    if (g_str_equal(method_name, "Evaluate")) {
+        if (!sender) {
+            script_evaluate(COG_LAUNCHER(userdata), parameters, invocation);
+            return;
+        }
+
+        /* Any local user may be allowed to talk to Cog on the system bus, check who is asking. */
+        g_dbus_connection_call(connection, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                               "GetConnectionUnixUser", g_variant_new("(s)", sender), G_VARIANT_TYPE("(u)"),
+                               G_DBUS_CALL_FLAGS_NONE, -1, NULL, on_script_caller_user, invocation);
+    } else {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+                                              "Unknown method %s", method_name);
+    }
+}
+
+static void
+on_trace_method_call(G_GNUC_UNUSED GDBusConnection *connection,
+                     G_GNUC_UNUSED const char      *sender,
+                     G_GNUC_UNUSED const char      *object_path,
+                     G_GNUC_UNUSED const char      *interface_name,
+                     const char                    *method_name,
+                     G_GNUC_UNUSED GVariant        *parameters,
+                     GDBusMethodInvocation         *invocation,
+                     G_GNUC_UNUSED void            *userdata)
+{
+    if (g_str_equal(method_name, "GetEvents")) {
+        g_autofree char *json = cog_trace_to_json();
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(s)", json));
+    } else {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+                                              "Unknown method %s", method_name);
+    }
+}
+
+static gboolean
+dbus_register_objects(CogLauncher     *self,
+                      GDBusConnection *connection,
+                      const char      *object_path,
+                      guint            registration_ids[N_DBUS_OBJECTS],
+                      GError         **error)
+{
+    static const GDBusInterfaceVTable metrics_vtable = {
+        .method_call = on_metrics_method_call,
+    };
+    static const GDBusInterfaceVTable script_vtable = {
+        .method_call = on_script_method_call,
+    };
+    static const GDBusInterfaceVTable trace_vtable = {
+        .method_call = on_trace_method_call,
+    };
+
+    registration_ids[DBUS_OBJECT_METRICS] = g_dbus_connection_register_object(
+        connection, object_path, dbus_interface_info(METRICS_INTERFACE), &metrics_vtable, NULL, NULL, error);
+    if (!registration_ids[DBUS_OBJECT_METRICS])
+        return FALSE;
+
+    /* Running arbitrary scripts is only allowed when explicitly enabled. */
+    if (s_options.enable_script_evaluation) {
+        registration_ids[DBUS_OBJECT_SCRIPT] = g_dbus_connection_register_object(
+            connection, object_path, dbus_interface_info(SCRIPT_INTERFACE), &script_vtable, self, NULL, error);
+        if (!registration_ids[DBUS_OBJECT_SCRIPT])
+            return FALSE;
+    }
+
+    registration_ids[DBUS_OBJECT_TRACE] = g_dbus_connection_register_object(
+        connection, object_path, dbus_interface_info(TRACE_INTERFACE), &trace_vtable, NULL, NULL, error);
+    return registration_ids[DBUS_OBJECT_TRACE] != 0;
+}
+
+static gboolean
+cog_launcher_dbus_register(GApplication    *application,
+                           GDBusConnection *connection,
+                           const char      *object_path,
+                           GError         **error)
+{
+    if (!G_APPLICATION_CLASS(cog_launcher_parent_class)->dbus_register(application, connection, object_path, error))
+        return FALSE;
+
+    CogLauncher *self = COG_LAUNCHER(application);
+    return dbus_register_objects(self, connection, object_path, self->dbus_registration_ids, error);
+}
+
+static void
+cog_launcher_dbus_unregister(GApplication *application, GDBusConnection *connection, const char *object_path)
+{
+    CogLauncher *self = COG_LAUNCHER(application);
+    for (unsigned i = 0; i < N_DBUS_OBJECTS; i++) {
+        if (self->dbus_registration_ids[i]) {
+            g_dbus_connection_unregister_object(connection, self->dbus_registration_ids[i]);
+            self->dbus_registration_ids[i] = 0;
+        }
+    }
+
+    G_APPLICATION_CLASS(cog_launcher_parent_class)->dbus_unregister(application, connection, object_path);
+}
+
 #if COG_DBUS_SYSTEM_BUS
 static void
 on_system_bus_acquired(GDBusConnection *connection, const char *name, void *userdata)
@@ -236,6 +712,11 @@ on_system_bus_acquired(GDBusConnection *connection, const char *name, void *user
     g_autoptr(GError) error = NULL;
     if (!g_dbus_connection_export_action_group(connection, object_path, G_ACTION_GROUP(userdata), &error))
         g_warning("Cannot expose remote control interface to system bus: %s", error->message);
+
+    g_clear_error(&error);
+    guint registration_ids[N_DBUS_OBJECTS] = {0};
+    if (!dbus_register_objects(COG_LAUNCHER(userdata), connection, object_path, registration_ids, &error))
+        g_warning("Cannot expose launcher interfaces to system bus: %s", error->message);
 }
 
 static void
@@ -255,36 +736,67 @@ on_system_bus_name_lost(GDBusConnection *connection, const char *name, G_GNUC_UN
 }
 #endif // COG_DBUS_SYSTEM_BUS
 
-static WebKitWebView *
-on_automation_session_create_web_view(WebKitAutomationSession *session, CogLauncher *launcher)
+static CogView *
+on_shell_create_view(CogShell *shell, CogLauncher *launcher)
 {
-    static bool first_time = true;
-    if (first_time) {
-        first_time = false;
-        return (WebKitWebView *) cog_viewport_get_visible_view(launcher->viewport);
-    }
 #if HAVE_WEBKIT_AUTOPLAY
     g_autoptr(WebKitWebsitePolicies) website_policies =
         webkit_website_policies_new_with_policies("autoplay", s_options.autoplay_policy, NULL);
 #endif /* HAVE_WEBKIT_AUTOPLAY */
 
-    g_autoptr(WebKitWebView) new_view =
-        (WebKitWebView *) cog_view_new("settings", cog_shell_get_web_settings(launcher->shell), "web-context",
-                                       cog_shell_get_web_context(launcher->shell), "is-controlled-by-automation", TRUE,
-                                       "zoom-level", s_options.scale_factor, "use-key-bindings", FALSE,
+    return cog_view_new("settings", cog_shell_get_web_settings(shell), "web-context", cog_shell_get_web_context(shell),
+                        "is-controlled-by-automation", launcher->automated, "zoom-level", s_options.scale_factor,
+                        "use-key-bindings", FALSE,
 #if COG_USE_WPE2
-                                       "network-session", launcher->network_session,
+                        "network-session", launcher->network_session,
 #endif /* COG_USE_WPE2 */
 #if HAVE_WEBKIT_AUTOPLAY
-                                       "website-policies", website_policies,
+                        "website-policies", website_policies,
 #endif /* HAVE_WEBKIT_AUTOPLAY */
-                                       NULL);
+                        NULL);
+}
+
+static WebKitWebView *
+on_automation_session_create_web_view(WebKitAutomationSession *session, CogLauncher *launcher)
+{
+    static bool first_time = true;
+    if (first_time) {
+        first_time = false;
+        return (WebKitWebView *) cog_viewport_get_visible_view(launcher->viewport);
+    }
+
+    g_autoptr(WebKitWebView) new_view = (WebKitWebView *) cog_shell_take_prewarmed_view(launcher->shell);
+    if (new_view)
+        cog_platform_init_web_view(cog_platform_get(), new_view);
+    else
+        new_view = (WebKitWebView *) on_shell_create_view(launcher->shell, launcher);
+
     // FIXME New window should be new viewport
     cog_viewport_add(launcher->viewport, (CogView *) new_view);
 
     return new_view;
 }
 
+static void
+on_startup_profile_load_changed(WebKitWebView *web_view, WebKitLoadEvent load_event)
+{
+    switch (load_event) {
+    case WEBKIT_LOAD_STARTED:
+        cog_profile_mark("load: started");
+        break;
+    case WEBKIT_LOAD_REDIRECTED:
+        cog_profile_mark("load: redirected");
+        break;
+    case WEBKIT_LOAD_COMMITTED:
+        cog_profile_mark("load: committed");
+        break;
+    case WEBKIT_LOAD_FINISHED:
+        g_signal_handlers_disconnect_by_func(web_view, on_startup_profile_load_changed, NULL);
+        cog_profile_finish();
+        break;
+    }
+}
+
 static void
 on_automation_started(WebKitWebContext *context, WebKitAutomationSession *session, CogLauncher *launcher)
 {
@@ -295,6 +807,178 @@ on_automation_started(WebKitWebContext *context, WebKitAutomationSession *sessio
     g_signal_connect(session, "create-web-view", G_CALLBACK(on_automation_session_create_web_view), launcher);
 }
 
+#if COG_USE_WPE2
+static void
+on_shell_memory_pressure(CogShell *shell, GParamSpec *pspec G_GNUC_UNUSED, CogLauncher *launcher)
+{
+    /* The shell cannot reach the memory cache, which belongs to the network session. */
+    if (cog_shell_get_memory_pressure(shell) == COG_MEMORY_PRESSURE_CRITICAL)
+        webkit_website_data_manager_clear(webkit_network_session_get_website_data_manager(launcher->network_session),
+                                          WEBKIT_WEBSITE_DATA_MEMORY_CACHE, 0, NULL, NULL, NULL);
+}
+#endif
+
+/*
+ * Compiled content filters are kept in a store on disk, under an identifier
+ * derived from a hash of the rules. The rules only get compiled again when
+ * they change, and loading happens asynchronously while the rest of the
+ * startup sequence proceeds; only the first page load waits for it.
+ */
+#define CONTENT_FILTER_ID_PREFIX "cog-"
+
+typedef struct {
+    CogLauncher                  *launcher;
+    WebKitWebView                *web_view;
+    WebKitUserContentFilterStore *store;
+    GBytes                       *rules;
+    char                         *identifier;
+    int64_t                       start;
+} ContentFilterLoad;
+
+static void
+content_filter_load_free(ContentFilterLoad *load)
+{
+    g_clear_object(&load->web_view);
+    g_clear_object(&load->store);
+    g_clear_pointer(&load->rules, g_bytes_unref);
+    g_clear_pointer(&load->identifier, g_free);
+    g_slice_free(ContentFilterLoad, load);
+}
+
+static void
+content_filter_load_apply(ContentFilterLoad *load, WebKitUserContentFilter *filter)
+{
+    if (filter)
+        webkit_user_content_manager_add_filter(webkit_web_view_get_user_content_manager(load->web_view), filter);
+
+    CogLauncher *launcher = load->launcher;
+    launcher->filter_pending = FALSE;
+    cog_profile_end("launcher: content filter");
+
+    if (launcher->pending_uri) {
+        webkit_web_view_load_uri(load->web_view, launcher->pending_uri);
+        g_clear_pointer(&launcher->pending_uri, g_free);
+    }
+}
+
+static void
+on_content_filter_identifiers_fetched(WebKitUserContentFilterStore *store,
+                                      GAsyncResult                 *result,
+                                      ContentFilterLoad            *load)
+{
+    g_auto(GStrv) identifiers = webkit_user_content_filter_store_fetch_identifiers_finish(store, result);
+
+    /* Filters compiled from previous versions of the rules will not be used again. */
+    for (unsigned i = 0; identifiers && identifiers[i]; i++) {
+        if (g_str_equal(identifiers[i], load->identifier))
+            continue;
+        if (g_str_has_prefix(identifiers[i], CONTENT_FILTER_ID_PREFIX) || g_str_equal(identifiers[i], "CogFilter")) {
+            g_debug("%s: Removing stale filter %s.", G_STRFUNC, identifiers[i]);
+            webkit_user_content_filter_store_remove(store, identifiers[i], NULL, NULL, NULL);
+        }
+    }
+
+    content_filter_load_free(load);
+}
+
+static void
+on_content_filter_saved(WebKitUserContentFilterStore *store, GAsyncResult *result, ContentFilterLoad *load)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(WebKitUserContentFilter) filter =
+        webkit_user_content_filter_store_save_finish(store, result, &error);
+
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        content_filter_load_free(load);
+        return;
+    }
+
+    if (!filter) {
+        g_warning("Cannot compile filter: %s", error->message);
+        content_filter_load_apply(load, NULL);
+        content_filter_load_free(load);
+        return;
+    }
+
+    g_info("Compiled content filter in %.1f ms.", (g_get_monotonic_time() - load->start) / 1000.0);
+    content_filter_load_apply(load, filter);
+
+    webkit_user_content_filter_store_fetch_identifiers(store, NULL,
+                                                       (GAsyncReadyCallback) on_content_filter_identifiers_fetched,
+                                                       load);
+}
+
+static void
+on_content_filter_loaded(WebKitUserContentFilterStore *store, GAsyncResult *result, ContentFilterLoad *load)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(WebKitUserContentFilter) filter =
+        webkit_user_content_filter_store_load_finish(store, result, &error);
+
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        content_filter_load_free(load);
+        return;
+    }
+
+    if (filter) {
+        g_info("Loaded compiled content filter in %.1f ms.", (g_get_monotonic_time() - load->start) / 1000.0);
+        content_filter_load_apply(load, filter);
+        content_filter_load_free(load);
+        return;
+    }
+
+    /* Not found, or compiled by a different WebKit version. */
+    g_debug("%s: %s", G_STRFUNC, error->message);
+
+    load->start = g_get_monotonic_time();
+    webkit_user_content_filter_store_save(store, load->identifier, load->rules, load->launcher->filter_cancellable,
+                                          (GAsyncReadyCallback) on_content_filter_saved, load);
+}
+
+static void
+on_content_filter_rules_read(GFile *file, GAsyncResult *result, ContentFilterLoad *load)
+{
+    g_autoptr(GError) error = NULL;
+    char             *contents = NULL;
+    gsize             length = 0;
+
+    if (!g_file_load_contents_finish(file, result, &contents, &length, NULL, &error)) {
+        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_warning("Cannot read filter: %s", error->message);
+            content_filter_load_apply(load, NULL);
+        }
+        content_filter_load_free(load);
+        return;
+    }
+
+    load->rules = g_bytes_new_take(contents, length);
+
+    g_autofree char *checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, load->rules);
+    load->identifier = g_strconcat(CONTENT_FILTER_ID_PREFIX, checksum, NULL);
+
+    load->start = g_get_monotonic_time();
+    webkit_user_content_filter_store_load(load->store, load->identifier, load->launcher->filter_cancellable,
+                                          (GAsyncReadyCallback) on_content_filter_loaded, load);
+}
+
+static void
+cog_launcher_load_content_filter(CogLauncher *self, WebKitWebView *web_view, GFile *file)
+{
+    g_autofree char *store_path = g_build_filename(g_get_user_cache_dir(), g_get_prgname(), "filters", NULL);
+
+    ContentFilterLoad *load = g_slice_new0(ContentFilterLoad);
+    load->launcher = self;
+    load->web_view = g_object_ref(web_view);
+    load->store = webkit_user_content_filter_store_new(store_path);
+
+    cog_profile_begin("launcher: content filter");
+    self->filter_pending = TRUE;
+    self->filter_cancellable = g_cancellable_new();
+
+    g_file_load_contents_async(file, self->filter_cancellable, (GAsyncReadyCallback) on_content_filter_rules_read,
+                               load);
+}
+
 static void
 cog_launcher_startup(GApplication *application)
 {
@@ -306,6 +990,7 @@ cog_launcher_startup(GApplication *application)
      */
     g_application_hold(application);
 
+    cog_profile_begin("launcher: startup");
     cog_init(s_options.platform_name, NULL);
 
     CogLauncher *self = COG_LAUNCHER(application);
@@ -331,8 +1016,7 @@ cog_launcher_startup(GApplication *application)
     WebKitWebContext *web_context = cog_shell_get_web_context(self->shell);
     g_signal_connect(web_context, "automation-started", G_CALLBACK(on_automation_started), self);
 
-    if (s_options.doc_viewer)
-        webkit_web_context_set_cache_model(web_context, WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER);
+    webkit_web_context_set_cache_model(web_context, s_options.cache_model);
 
 #if COG_USE_WPE2
     if (s_options.web_extensions_dir)
@@ -346,6 +1030,25 @@ cog_launcher_startup(GApplication *application)
 
     g_object_set(self->shell, "device-scale-factor", s_options.device_scale_factor, NULL);
 
+    if (s_options.prewarm_count > 0) {
+        g_signal_connect(self->shell, "create-view", G_CALLBACK(on_shell_create_view), self);
+        cog_shell_set_prewarm_count(self->shell, MIN(s_options.prewarm_count, COG_SHELL_PREWARM_COUNT_MAX));
+    }
+
+    if (s_options.memory_monitor) {
+#if COG_USE_WPE2
+        g_signal_connect(self->shell, "notify::memory-pressure", G_CALLBACK(on_shell_memory_pressure), self);
+#endif
+        cog_shell_set_memory_monitor(self->shell, TRUE);
+    }
+
+    if (s_options.metrics_exporter) {
+        g_autoptr(GError) error = NULL;
+        if (!(self->metrics_exporter = cog_metrics_exporter_new(s_options.metrics_exporter, &error)))
+            g_warning("Cannot start metrics exporter: %s", error->message);
+        g_clear_pointer(&s_options.metrics_exporter, g_free);
+    }
+
     if (s_options.handler_map) {
         GHashTableIter i;
         void          *key, *value;
@@ -378,6 +1081,7 @@ cog_launcher_startup(GApplication *application)
         webkit_website_policies_new_with_policies("autoplay", s_options.autoplay_policy, NULL);
 #endif
 
+    cog_profile_begin("launcher: view");
     g_autoptr(CogView) view =
         cog_view_new("settings", cog_shell_get_web_settings(self->shell), "web-context",
                      cog_shell_get_web_context(self->shell), "is-controlled-by-automation", self->automated,
@@ -391,14 +1095,14 @@ cog_launcher_startup(GApplication *application)
                      NULL);
 
     cog_platform_init_web_view(cog_platform_get(), WEBKIT_WEB_VIEW(view));
+    cog_profile_end("launcher: view");
 
     g_signal_connect(view, "permission-request", G_CALLBACK(on_permission_request), self);
-    g_signal_connect(view, "create", G_CALLBACK(on_web_view_create), NULL);
+    g_signal_connect(view, "create", G_CALLBACK(on_web_view_create), self);
 
-    if (s_options.filter) {
-        WebKitUserContentManager *manager = webkit_web_view_get_user_content_manager(WEBKIT_WEB_VIEW(view));
-        webkit_user_content_manager_add_filter(manager, s_options.filter);
-        g_clear_pointer(&s_options.filter, webkit_user_content_filter_unref);
+    if (s_options.filter_file) {
+        cog_launcher_load_content_filter(self, WEBKIT_WEB_VIEW(view), s_options.filter_file);
+        g_clear_object(&s_options.filter_file);
     }
 
     if (s_options.background_color != NULL) {
@@ -427,8 +1131,7 @@ cog_launcher_startup(GApplication *application)
         break;
 
     case WEBPROCESS_FAIL_RESTART:
-        // TODO: Un-hardcode the 5 retries per second.
-        cog_web_view_connect_web_process_terminated_restart_handler(WEBKIT_WEB_VIEW(view), 5, 1000);
+        cog_web_view_connect_web_process_recovery_handler(WEBKIT_WEB_VIEW(view), &s_options.restart_policy);
         break;
 
     default:
@@ -438,7 +1141,14 @@ cog_launcher_startup(GApplication *application)
     cog_web_view_connect_default_progress_handlers(WEBKIT_WEB_VIEW(view));
     cog_web_view_connect_default_error_handlers(WEBKIT_WEB_VIEW(view));
 
-    webkit_web_view_load_uri(WEBKIT_WEB_VIEW(view), s_options.home_uri);
+    if (cog_profile_is_enabled())
+        g_signal_connect(view, "load-changed", G_CALLBACK(on_startup_profile_load_changed), NULL);
+
+    /* Wait for the content filter, so it applies to the first page as well. */
+    if (self->filter_pending)
+        self->pending_uri = g_steal_pointer(&s_options.home_uri);
+    else
+        webkit_web_view_load_uri(WEBKIT_WEB_VIEW(view), s_options.home_uri);
     g_clear_pointer(&s_options.home_uri, g_free);
 
     self->viewport = cog_viewport_new();
@@ -455,6 +1165,8 @@ cog_launcher_startup(GApplication *application)
                    self,
                    NULL);
 #endif
+
+    cog_profile_end("launcher: startup");
 }
 
 static void
@@ -470,13 +1182,22 @@ cog_launcher_dispose(GObject *object)
 {
     CogLauncher *launcher = COG_LAUNCHER(object);
 
+    if (launcher->filter_cancellable)
+        g_cancellable_cancel(launcher->filter_cancellable);
+    g_clear_object(&launcher->filter_cancellable);
+    g_clear_pointer(&launcher->pending_uri, g_free);
+
+    g_clear_pointer(&launcher->metrics_exporter, cog_metrics_exporter_free);
+
     g_clear_object(&launcher->shell);
     g_clear_object(&launcher->viewport);
 
     g_clear_handle_id(&launcher->sigint_source, g_source_remove);
     g_clear_handle_id(&launcher->sigterm_source, g_source_remove);
+    g_clear_handle_id(&launcher->sigusr1_source, g_source_remove);
 
     g_clear_object(&launcher->web_settings);
+    g_clear_pointer(&launcher->disk_cache_dir, g_free);
 
 #if COG_USE_WPE2
     g_clear_object(&launcher->network_session);
@@ -1184,6 +1905,22 @@ option_entry_parse_autoplay(const char *option_name, const char *value, void *da
 }
 #endif
 
+static gboolean
+option_entry_parse_cache_model(const char *option_name G_GNUC_UNUSED,
+                               const char *value,
+                               void       *data G_GNUC_UNUSED,
+                               GError    **error)
+{
+    const GEnumValue *enum_value = cog_g_enum_get_value(WEBKIT_TYPE_CACHE_MODEL, value);
+    if (!enum_value) {
+        g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE, "Invalid cache model '%s'", value);
+        return FALSE;
+    }
+
+    s_options.cache_model = enum_value->value;
+    return TRUE;
+}
+
 static GOptionEntry s_cli_options[] = {
     {"version", '\0', 0, G_OPTION_ARG_NONE, &s_options.version, "Print version and exit", NULL},
     {"print-appid", '\0', 0, G_OPTION_ARG_NONE, &s_options.print_appid, "Print application ID and exit", NULL},
@@ -1196,10 +1933,25 @@ static GOptionEntry s_cli_options[] = {
      "This reduces memory usage at the cost of reducing caching of "
      "resources loaded from the network.",
      NULL},
+    {"cache-model", '\0', 0, G_OPTION_ARG_CALLBACK, option_entry_parse_cache_model,
+     "Cache model: web-browser (default), document-browser, document-viewer. Sets how much memory and disk "
+     "space WebKit uses for caching.",
+     "MODEL"},
+    {"disk-cache-dir", '\0', 0, G_OPTION_ARG_FILENAME, &s_options.disk_cache_dir,
+     "Base directory for the disk cache (default: in $XDG_CACHE_HOME).", "PATH"},
+    {"disk-cache-max-size", '\0', 0, G_OPTION_ARG_INT, &s_options.disk_cache_max_size,
+     "Trim the disk cache to this size at startup, least recently used entries first (default: 0, unlimited).",
+     "MIB"},
+    {"disk-cache-seed", '\0', 0, G_OPTION_ARG_FILENAME, &s_options.disk_cache_seed,
+     "Preload the disk cache from a copy of its WebKitCache directory, if the cache lacks it.", "PATH"},
     {"dir-handler", 'd', 0, G_OPTION_ARG_STRING_ARRAY, &s_options.dir_handlers,
      "Add a URI scheme handler for a directory", "SCHEME:PATH"},
     {"webprocess-failure", '\0', 0, G_OPTION_ARG_STRING, &s_options.on_failure.action_name,
      "Action on WebProcess failures: error-page (default), exit, exit-ok, restart.", "ACTION"},
+    {"webprocess-restart", '\0', 0, G_OPTION_ARG_STRING, &s_options.restart_params,
+     "Policy for --webprocess-failure=restart, as comma-separated KEY=VALUE pairs: max-tries, try-window, "
+     "backoff, backoff-max, snapshot-interval (times in milliseconds).",
+     "PARAMS"},
     {"config", 'C', 0, G_OPTION_ARG_FILENAME, &s_options.config_file, "Path to a configuration file", "PATH"},
     {"bg-color", 'b', 0, G_OPTION_ARG_STRING, &s_options.background_color,
      "Background color, as a CSS name or in #RRGGBBAA hex syntax (default: white)", "BG_COLOR"},
@@ -1229,6 +1981,20 @@ static GOptionEntry s_cli_options[] = {
     {"autoplay-policy", 0, 0, G_OPTION_ARG_CALLBACK, option_entry_parse_autoplay,
      "Autoplay policy. Valid options are: allow, allow-without-sound, and deny", NULL},
 #endif
+    {"startup-profile", '\0', 0, G_OPTION_ARG_NONE, &s_options.startup_profile,
+     "Print how long each startup phase took, up to the first page load (default: disabled).", NULL},
+    {"prewarm", '\0', 0, G_OPTION_ARG_INT, &s_options.prewarm_count,
+     "Number of views kept with their WebProcess launched ahead of time, used for new windows "
+     "and views created by automation sessions (default: 0, disabled).",
+     "COUNT"},
+    {"memory-monitor", '\0', 0, G_OPTION_ARG_NONE, &s_options.memory_monitor,
+     "Give memory back when the system is under memory pressure (default: disabled).", NULL},
+    {"metrics-exporter", '\0', 0, G_OPTION_ARG_STRING, &s_options.metrics_exporter,
+     "Serve metrics in OpenMetrics format on a Unix socket PATH, or a localhost PORT (default: disabled).",
+     "PATH|PORT"},
+    {"enable-script-evaluation", '\0', 0, G_OPTION_ARG_NONE, &s_options.enable_script_evaluation,
+     "Allow running JavaScript in the page over D-Bus, for root and the user running Cog (default: disabled).",
+     NULL},
     {G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &s_options.arguments, "", "[URL]"},
     {NULL}};
 
@@ -1239,13 +2005,15 @@ cog_launcher_constructed(GObject *object)
 
     CogLauncher *launcher = COG_LAUNCHER(object);
 
+    g_autofree char *cache_dir = launcher->disk_cache_dir
+                                     ? g_strdup(launcher->disk_cache_dir)
+                                     : g_build_filename(g_get_user_cache_dir(), g_get_prgname(), NULL);
+
 #if COG_USE_WPE2
     if (!launcher->automated)
-        launcher->network_session = webkit_network_session_new(NULL, NULL);
+        launcher->network_session = webkit_network_session_new(NULL, cache_dir);
 #else
-
     g_autofree char *data_dir = g_build_filename(g_get_user_data_dir(), g_get_prgname(), NULL);
-    g_autofree char *cache_dir = g_build_filename(g_get_user_cache_dir(), g_get_prgname(), NULL);
 
     launcher->web_data_manager = g_object_new(WEBKIT_TYPE_WEBSITE_DATA_MANAGER, "is-ephemeral", launcher->automated,
                                               "base-data-directory", data_dir, "base-cache-directory", cache_dir, NULL);
@@ -1256,6 +2024,8 @@ cog_launcher_constructed(GObject *object)
     cog_launcher_add_action(launcher, "next", on_action_next, NULL);
     cog_launcher_add_action(launcher, "reload", on_action_reload, NULL);
     cog_launcher_add_action(launcher, "open", on_action_open, G_VARIANT_TYPE_STRING);
+    cog_launcher_add_action(launcher, "video-mode", on_action_video_mode, G_VARIANT_TYPE_STRING);
+    cog_launcher_add_action(launcher, "save-splash", on_action_save_splash, NULL);
 
     g_application_add_main_option_entries(G_APPLICATION(object), s_cli_options);
     cog_launcher_add_web_settings_option_entries(launcher);
@@ -1270,6 +2040,7 @@ cog_launcher_constructed(GObject *object)
 
     launcher->sigint_source = g_unix_signal_add(SIGINT, G_SOURCE_FUNC(on_signal_quit), launcher);
     launcher->sigterm_source = g_unix_signal_add(SIGTERM, G_SOURCE_FUNC(on_signal_quit), launcher);
+    launcher->sigusr1_source = g_unix_signal_add(SIGUSR1, G_SOURCE_FUNC(on_signal_dump_trace), launcher);
 }
 
 static int
@@ -1295,14 +2066,41 @@ string_to_webprocess_fail_action(const char *action)
     return WEBPROCESS_FAIL_UNKNOWN;
 }
 
-static void
-on_filter_saved(WebKitUserContentFilterStore *store, GAsyncResult *result, GMainLoop *loop)
+static gboolean
+load_restart_policy(GKeyFile *key_file, GError **error)
 {
-    g_autoptr(GError) error = NULL;
-    s_options.filter = webkit_user_content_filter_store_save_from_file_finish(store, result, &error);
-    if (!s_options.filter)
-        g_warning("Cannot compile filter: %s", error->message);
-    g_main_loop_quit(loop);
+    cog_web_process_recovery_policy_init(&s_options.restart_policy);
+
+    if (key_file && g_key_file_has_group(key_file, "webprocess-restart")) {
+        g_auto(GStrv) keys = g_key_file_get_keys(key_file, "webprocess-restart", NULL, NULL);
+        for (unsigned i = 0; keys && keys[i]; i++) {
+            g_autofree char *value = g_key_file_get_string(key_file, "webprocess-restart", keys[i], error);
+            if (!value || !cog_web_process_recovery_policy_set(&s_options.restart_policy, keys[i], value, error))
+                return FALSE;
+        }
+    }
+
+    /* Command line parameters take precedence over the configuration file. */
+    if (s_options.restart_params) {
+        g_auto(GStrv) params = g_strsplit(s_options.restart_params, ",", -1);
+        for (unsigned i = 0; params[i]; i++) {
+            if (!*params[i])
+                continue;
+
+            char *value = strchr(params[i], '=');
+            if (!value) {
+                g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE, "Missing value for '%s'", params[i]);
+                return FALSE;
+            }
+            *value++ = '\0';
+            if (!cog_web_process_recovery_policy_set(&s_options.restart_policy, g_strstrip(params[i]),
+                                                     g_strstrip(value), error))
+                return FALSE;
+        }
+        g_clear_pointer(&s_options.restart_params, g_free);
+    }
+
+    return TRUE;
 }
 
 static gboolean
@@ -1434,21 +2232,52 @@ cog_launcher_handle_local_options(GApplication *application, GVariantDict *optio
         s_options.key_file = g_steal_pointer(&key_file);
     }
 
-    if (s_options.filter_path) {
-        g_autofree char *filters_path = g_build_filename(g_get_user_cache_dir(), g_get_prgname(), "filters", NULL);
-        g_autoptr(WebKitUserContentFilterStore) store = webkit_user_content_filter_store_new(filters_path);
+    {
+        g_autoptr(GError) error = NULL;
+        if (!load_restart_policy(s_options.key_file, &error)) {
+            g_printerr("%s: Invalid WebProcess restart policy: %s\n", g_get_prgname(), error->message);
+            return EXIT_FAILURE;
+        }
+    }
 
-        g_autoptr(GFile) file = g_file_new_for_commandline_arg(s_options.filter_path);
-        g_clear_pointer(&s_options.filter_path, g_free);
+    if (s_options.doc_viewer)
+        s_options.cache_model = WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER;
 
-        g_autoptr(GMainLoop) loop = g_main_loop_new(NULL, FALSE);
-        webkit_user_content_filter_store_save_from_file(store,
-                                                        "CogFilter",
-                                                        file,
-                                                        NULL,
-                                                        (GAsyncReadyCallback) on_filter_saved,
-                                                        loop);
-        g_main_loop_run(loop);
+    /* The directory was already used when creating the launcher, see main(). */
+    g_clear_pointer(&s_options.disk_cache_dir, g_free);
+
+    if (s_options.disk_cache_max_size < 0) {
+        g_printerr("%s: Invalid disk cache size: %d\n", g_get_prgname(), s_options.disk_cache_max_size);
+        return EXIT_FAILURE;
+    }
+
+    /* Done before anything starts the network process, which indexes the cache once when it opens it. */
+    WebKitWebsiteDataManager *data_manager = cog_launcher_get_web_data_manager(launcher);
+    if (data_manager && !launcher->automated && (s_options.disk_cache_seed || s_options.disk_cache_max_size)) {
+        const char *cache_dir = webkit_website_data_manager_get_base_cache_directory(data_manager);
+        g_autoptr(GError) error = NULL;
+
+        cog_profile_begin("launcher: disk cache");
+        if (!cache_dir) {
+            g_warning("Cache directory unknown, the disk cache will not be seeded nor trimmed.");
+        } else {
+            if (s_options.disk_cache_seed && !cog_disk_cache_seed(cache_dir, s_options.disk_cache_seed, &error)) {
+                g_warning("Cannot seed disk cache: %s", error->message);
+                g_clear_error(&error);
+            }
+            if (s_options.disk_cache_max_size &&
+                !cog_disk_cache_trim(cache_dir, (guint64) s_options.disk_cache_max_size * 1024 * 1024, &error))
+                g_warning("Cannot trim disk cache: %s", error->message);
+        }
+        cog_profile_end("launcher: disk cache");
+    }
+    g_clear_pointer(&s_options.disk_cache_seed, g_free);
+
+    /* Loaded once the main loop is running, see cog_launcher_load_content_filter(). */
+    if (s_options.filter_path) {
+        GFile *file = g_file_new_for_commandline_arg(s_options.filter_path);
+        g_clear_pointer(&s_options.filter_path, g_free);
+        s_options.filter_file = file;
     }
 
 #if HAVE_WEBKIT_NETWORK_PROXY_API
@@ -1486,6 +2315,9 @@ cog_launcher_set_property(GObject *object, guint propId, const GValue *value, GP
     case PROP_AUTOMATED:
         launcher->automated = g_value_get_boolean(value);
         break;
+    case PROP_DISK_CACHE_DIR:
+        launcher->disk_cache_dir = g_value_dup_string(value);
+        break;
     default:
         break;
     }
@@ -1504,6 +2336,8 @@ cog_launcher_class_init(CogLauncherClass *klass)
     application_class->startup = cog_launcher_startup;
     application_class->handle_local_options = cog_launcher_handle_local_options;
     application_class->activate = cog_launcher_activate;
+    application_class->dbus_register = cog_launcher_dbus_register;
+    application_class->dbus_unregister = cog_launcher_dbus_unregister;
 
     g_object_class_install_property(object_class,
                                     PROP_AUTOMATED,
@@ -1512,6 +2346,13 @@ cog_launcher_class_init(CogLauncherClass *klass)
                                                          "Whether this launcher is automated",
                                                          FALSE,
                                                          G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
+    g_object_class_install_property(object_class,
+                                    PROP_DISK_CACHE_DIR,
+                                    g_param_spec_string("disk-cache-dir",
+                                                        "Disk cache directory",
+                                                        "Base directory for the disk cache",
+                                                        NULL,
+                                                        G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
@@ -1526,7 +2367,7 @@ cog_launcher_init(CogLauncher *self)
 }
 
 CogLauncher *
-cog_launcher_new(CogSessionType session_type)
+cog_launcher_new(CogSessionType session_type, const char *disk_cache_dir)
 {
     /* Global singleton */
     const GApplicationFlags app_flags =
@@ -1535,7 +2376,7 @@ cog_launcher_new(CogSessionType session_type)
 #endif // GLIB_CHECK_VERSION
         G_APPLICATION_HANDLES_OPEN;
     return g_object_new(COG_TYPE_LAUNCHER, "application-id", COG_DEFAULT_APPID, "flags", app_flags, "automated",
-                        (session_type == COG_SESSION_AUTOMATED), NULL);
+                        (session_type == COG_SESSION_AUTOMATED), "disk-cache-dir", disk_cache_dir, NULL);
 }
 
 /**
@@ -25,10 +25,14 @@ typedef enum {
     COG_SESSION_AUTOMATED,
 } CogSessionType;
 
-CogLauncher              *cog_launcher_new(CogSessionType session_type);
+CogLauncher              *cog_launcher_new(CogSessionType session_type, const char *disk_cache_dir);
 CogShell                 *cog_launcher_get_shell(CogLauncher *launcher);
 gboolean                  cog_launcher_is_automated(CogLauncher *launcher);
 WebKitSettings           *cog_launcher_get_webkit_settings(CogLauncher *launcher);
 WebKitWebsiteDataManager *cog_launcher_get_web_data_manager(CogLauncher *launcher);
 
+#if COG_HAVE_STATIC_PLATFORMS
+void cog_launcher_add_static_platforms(void);
+#endif
+
 G_END_DECLS
@@ -9,6 +9,8 @@
 
 #include "cog-launcher.h"
 
+#include <string.h>
+
 static void
 print_module_info(GIOExtension *extension, void *userdata G_GNUC_UNUSED)
 {
@@ -23,8 +25,26 @@ main(int argc, char *argv[])
 {
     g_set_application_name("Cog");
 
-    g_info("%s:", COG_MODULES_PLATFORM_EXTENSION_POINT);
-    cog_modules_foreach(COG_MODULES_PLATFORM, print_module_info, NULL);
+    // Profiling has to be enabled before platform modules are scanned below.
+    for (int i = 1; i < argc; i++) {
+        if (g_str_equal("--startup-profile", argv[i])) {
+            cog_profile_enable();
+            break;
+        }
+    }
+
+#if COG_HAVE_STATIC_PLATFORMS
+    cog_launcher_add_static_platforms();
+#endif
+
+    // Listing modules needs scanning all of them, skip it unless it would be shown.
+#if GLIB_CHECK_VERSION(2, 68, 0)
+    if (!g_log_writer_default_would_drop(G_LOG_LEVEL_INFO, G_LOG_DOMAIN))
+#endif
+    {
+        g_info("%s:", COG_MODULES_PLATFORM_EXTENSION_POINT);
+        cog_modules_foreach(COG_MODULES_PLATFORM, print_module_info, NULL);
+    }
 
     // We need to check whether we'll use automation mode before creating the launcher
     gboolean automated = FALSE;
@@ -35,7 +55,16 @@ main(int argc, char *argv[])
         }
     }
 
+    // Same for the disk cache location, which cannot be changed once the launcher exists
+    const char *disk_cache_dir = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (g_str_has_prefix(argv[i], "--disk-cache-dir="))
+            disk_cache_dir = argv[i] + strlen("--disk-cache-dir=");
+        else if (g_str_equal("--disk-cache-dir", argv[i]) && i + 1 < argc)
+            disk_cache_dir = argv[++i];
+    }
+
     CogSessionType          sessionType = automated ? COG_SESSION_AUTOMATED : COG_SESSION_REGULAR;
-    g_autoptr(GApplication) app = G_APPLICATION(cog_launcher_new(sessionType));
+    g_autoptr(GApplication) app = G_APPLICATION(cog_launcher_new(sessionType, disk_cache_dir));
     return g_application_run(app, argc, argv);
 }
@@ -12,8 +12,10 @@
 #include "cog-config.h"
 
 #include <gio/gio.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #ifndef COG_DEFAULT_APPID
 #define COG_DEFAULT_APPID    "com.igalia.Cog"
@@ -21,17 +23,51 @@
 
 #define GTK_ACTIONS_ACTIVATE "org.gtk.Actions", "Activate"
 #define FDO_DBUS_PEER_PING   "org.freedesktop.DBus.Peer", "Ping"
+#define COG_METRICS_GET_STATS "com.igalia.Cog1.Metrics", "GetStats"
+#define COG_SCRIPT_EVALUATE  "com.igalia.Cog1.Script", "Evaluate"
+#define COG_TRACE_GET_EVENTS "com.igalia.Cog1.Trace", "GetEvents"
 
 
 static struct {
     char    *appid;
     char    *objpath;
     gboolean system_bus;
+    char    *batch_file;
 } s_options = {
     .appid = COG_DEFAULT_APPID,
 };
 
 
+/*
+ * In batch mode method calls are issued asynchronously over a single
+ * connection, and their replies are reported as they arrive. Messages
+ * sent over a connection are delivered in order, so commands still take
+ * effect in the order in which they are read.
+ */
+static struct {
+    gboolean   active;
+    GMainLoop *loop;
+    unsigned   command;  /* Line number of the command being run. */
+    unsigned   pending;  /* Calls waiting for a reply. */
+    unsigned   issued;   /* Calls issued so far. */
+    unsigned   failed;
+    gboolean   eof;
+    GString   *errors;   /* Output of g_printerr() for the command being run. */
+} s_batch;
+
+
+static gboolean
+option_entry_parse_batch (G_GNUC_UNUSED const char *option,
+                          const char               *value,
+                          G_GNUC_UNUSED void       *data,
+                          G_GNUC_UNUSED GError    **error)
+{
+    g_free (s_options.batch_file);
+    s_options.batch_file = g_strdup (value ? value : "-");
+    return TRUE;
+}
+
+
 static GOptionEntry s_cli_options[] = {
     { "appid", 'A', 0, G_OPTION_ARG_STRING, &s_options.appid,
         "Application identifier of the Cog instance to control",
@@ -42,22 +78,99 @@ static GOptionEntry s_cli_options[] = {
     { "system", 'y', 0, G_OPTION_ARG_NONE, &s_options.system_bus,
         "Use the system bus instead of the session bus",
         NULL },
+    { "batch", 'b', G_OPTION_FLAG_OPTIONAL_ARG, G_OPTION_ARG_CALLBACK,
+        option_entry_parse_batch,
+        "Run commands read from FILE, or the standard input, one per line",
+        "FILE" },
     { NULL, }
 };
 
 
+static GDBusConnection*
+get_connection (GError **error)
+{
+    static GDBusConnection *connection = NULL;
+
+    if (!connection) {
+        const GBusType bus_type =
+            s_options.system_bus ? G_BUS_TYPE_SYSTEM : G_BUS_TYPE_SESSION;
+        connection = g_bus_get_sync (bus_type, NULL, error);
+    }
+    return connection;
+}
+
+
+static void
+batch_report (unsigned    command,
+              const char *output,
+              const char *error_message)
+{
+    if (error_message) {
+        g_print ("%u ERROR %s\n", command, error_message);
+        s_batch.failed++;
+    } else if (output) {
+        g_print ("%u OK %s\n", command, output);
+    } else {
+        g_print ("%u OK\n", command);
+    }
+    /* Scripts may be waiting for each result before sending more commands. */
+    fflush (stdout);
+}
+
+
+static void
+on_batch_call_finished (GObject      *source_object,
+                        GAsyncResult *result,
+                        void         *userdata)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GVariant) reply =
+        g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object),
+                                       result,
+                                       &error);
+
+    /* Replies carrying a string, like script results, are printed along. */
+    const char *output = NULL;
+    if (reply && g_variant_is_of_type (reply, G_VARIANT_TYPE ("(s)")))
+        g_variant_get (reply, "(&s)", &output);
+
+    batch_report (GPOINTER_TO_UINT (userdata), output, reply ? NULL : error->message);
+
+    if (--s_batch.pending == 0 && s_batch.eof)
+        g_main_loop_quit (s_batch.loop);
+}
+
+
 static gboolean
-call_method (const char *iface,
-             const char *method,
-             GVariant   *params,
-             GError    **error)
+call_method_full (const char *iface,
+                  const char *method,
+                  GVariant   *params,
+                  int         timeout_msec,
+                  GVariant  **reply,
+                  GError    **error)
 {
-    const GBusType bus_type =
-        s_options.system_bus ? G_BUS_TYPE_SYSTEM : G_BUS_TYPE_SESSION;
-    g_autoptr(GDBusConnection) conn = g_bus_get_sync (bus_type, NULL, error);
-    if (!error)
+    GDBusConnection *conn = get_connection (error);
+    if (!conn)
         return FALSE;
 
+    if (s_batch.active) {
+        g_dbus_connection_call (conn,
+                                s_options.appid,
+                                s_options.objpath,
+                                iface,
+                                method,
+                                params,
+                                NULL,
+                                G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                                timeout_msec,
+                                NULL,
+                                on_batch_call_finished,
+                                GUINT_TO_POINTER (s_batch.command));
+        s_batch.pending++;
+        s_batch.issued++;
+        return TRUE;
+    }
+
     g_autoptr(GVariant) result =
         g_dbus_connection_call_sync (conn,
                                      s_options.appid,
@@ -67,10 +180,25 @@ call_method (const char *iface,
                                      params,
                                      NULL,
                                      G_DBUS_CALL_FLAGS_NO_AUTO_START,
-                                     -1,
+                                     timeout_msec,
                                      NULL,
                                      error);
-    return !!result;
+    if (!result)
+        return FALSE;
+
+    if (reply)
+        *reply = g_steal_pointer (&result);
+    return TRUE;
+}
+
+
+static gboolean
+call_method (const char *iface,
+             const char *method,
+             GVariant   *params,
+             GError    **error)
+{
+    return call_method_full (iface, method, params, -1, NULL, error);
 }
 
 
@@ -84,7 +212,7 @@ struct cmd {
 static const struct cmd* cmd_find_by_name (const char *name);
 
 
-static void
+static gboolean
 cmd_check_simple_help (const char *name, int needed_argc, int *argc, char ***argv)
 {
     const char *space = strchr (name, ' ');
@@ -98,12 +226,15 @@ cmd_check_simple_help (const char *name, int needed_argc, int *argc, char ***arg
     g_option_context_add_main_entries (option_context,
                                        &((GOptionEntry) { NULL, }),
                                        NULL);
+    /* Printing help exits, which would cut a batch short. */
+    g_option_context_set_help_enabled (option_context, !s_batch.active);
 
     g_autoptr(GError) error = NULL;
     if (!g_option_context_parse (option_context, argc, argv, &error) || *argc > (1 + needed_argc)) {
         g_printerr ("%s: %s\n", name, error ? error->message : "No arguments expected");
-        exit (EXIT_FAILURE);
+        return FALSE;
     }
+    return TRUE;
 }
 
 
@@ -123,7 +254,8 @@ cmd_generic_no_args (const char               *name,
                      int                       argc,
                      char                    **argv)
 {
-    cmd_check_simple_help (name, 0, &argc, &argv);
+    if (!cmd_check_simple_help (name, 0, &argc, &argv))
+        return EXIT_FAILURE;
 
     GVariant *params = g_variant_new ("(sava{sv})", name, NULL, NULL);
 
@@ -141,7 +273,8 @@ cmd_appid (const char               *name,
            int                       argc,
            char                    **argv)
 {
-    cmd_check_simple_help (name, 0, &argc, &argv);
+    if (!cmd_check_simple_help (name, 0, &argc, &argv))
+        return EXIT_FAILURE;
     g_print ("%s\n", s_options.appid);
     return EXIT_SUCCESS;
 }
@@ -153,7 +286,8 @@ cmd_objpath (const char               *name,
              int                       argc,
              char                    **argv)
 {
-    cmd_check_simple_help (name, 0, &argc, &argv);
+    if (!cmd_check_simple_help (name, 0, &argc, &argv))
+        return EXIT_FAILURE;
     g_print ("%s\n", s_options.objpath);
     return EXIT_SUCCESS;
 }
@@ -165,7 +299,13 @@ cmd_open (const char               *name,
           int                       argc,
           char                    **argv)
 {
-    cmd_check_simple_help ("open URL", 1, &argc, &argv);
+    if (!cmd_check_simple_help ("open URL", 1, &argc, &argv))
+        return EXIT_FAILURE;
+
+    if (argc < 2) {
+        g_printerr ("%s: No URL specified\n", name);
+        return EXIT_FAILURE;
+    }
 
     g_autoptr(GError) error = NULL;
     g_autofree char *utf8_uri =
@@ -188,19 +328,257 @@ cmd_open (const char               *name,
 }
 
 
+static int
+cmd_mode (const char               *name,
+          G_GNUC_UNUSED const void *data,
+          int                       argc,
+          char                    **argv)
+{
+    if (!cmd_check_simple_help ("mode WxH[@R]", 1, &argc, &argv))
+        return EXIT_FAILURE;
+
+    if (argc < 2) {
+        g_printerr ("%s: No video mode specified\n", name);
+        return EXIT_FAILURE;
+    }
+
+    g_autoptr(GVariantBuilder) param_mode =
+        g_variant_builder_new (G_VARIANT_TYPE ("av"));
+    g_variant_builder_add (param_mode, "v", g_variant_new_string (argv[1]));
+    GVariant *params = g_variant_new ("(sava{sv})", "video-mode", param_mode, NULL);
+
+    g_autoptr(GError) error = NULL;
+    if (!call_method (GTK_ACTIONS_ACTIVATE, params, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
+static int
+cmd_exec_js (const char               *name,
+             G_GNUC_UNUSED const void *data,
+             int                       argc,
+             char                    **argv)
+{
+    int timeout = 0;
+
+    GOptionEntry entries[] = {
+        { "timeout", 't', 0, G_OPTION_ARG_INT, &timeout,
+            "Milliseconds to wait for the result (default: 5000)", "MS" },
+        { NULL, }
+    };
+
+    g_autoptr(GOptionContext) option_context = g_option_context_new ("exec-js SCRIPT");
+    g_option_context_set_description (option_context,
+                                      cmd_find_by_name (name)->desc);
+    g_option_context_add_main_entries (option_context, entries, NULL);
+    g_option_context_set_help_enabled (option_context, !s_batch.active);
+
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (option_context, &argc, &argv, &error) || argc > 2) {
+        g_printerr ("%s: %s\n", name, error ? error->message : "Too many arguments");
+        return EXIT_FAILURE;
+    }
+    if (argc < 2) {
+        g_printerr ("%s: No script specified\n", name);
+        return EXIT_FAILURE;
+    }
+    if (timeout < 0) {
+        g_printerr ("%s: Invalid timeout %d\n", name, timeout);
+        return EXIT_FAILURE;
+    }
+
+    /* The reply arrives by the time the script times out, leave a margin for the bus. */
+    const int call_timeout = (timeout ? timeout : 5000) + 5000;
+
+    g_autoptr(GVariant) reply = NULL;
+    if (!call_method_full (COG_SCRIPT_EVALUATE,
+                           g_variant_new ("(su)", argv[1], (guint32) timeout),
+                           call_timeout,
+                           &reply,
+                           &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    if (reply) {
+        const char *result;
+        g_variant_get (reply, "(&s)", &result);
+        g_print ("%s\n", result);
+    }
+    return EXIT_SUCCESS;
+}
+
+
 static int
 cmd_ping (const char               *name,
           G_GNUC_UNUSED const void *data,
           int                       argc,
           char                    **argv)
 {
-    cmd_check_simple_help (name, 0, &argc, &argv);
+    if (!cmd_check_simple_help (name, 0, &argc, &argv))
+        return EXIT_FAILURE;
     return call_method (FDO_DBUS_PEER_PING, NULL, NULL)
         ? EXIT_SUCCESS
         : EXIT_FAILURE;
 }
 
 
+static int
+compare_strings (const void *a, const void *b)
+{
+    return strcmp (*(const char* const*) a, *(const char* const*) b);
+}
+
+
+static void
+print_stats (GVariant *stats)
+{
+    g_autoptr(GPtrArray) keys = g_ptr_array_new ();
+
+    GVariantIter iter;
+    const char *key;
+    g_variant_iter_init (&iter, stats);
+    while (g_variant_iter_next (&iter, "{&sv}", &key, NULL))
+        g_ptr_array_add (keys, (char*) key);
+    g_ptr_array_sort (keys, compare_strings);
+
+    for (unsigned i = 0; i < keys->len; i++) {
+        const char *name = g_ptr_array_index (keys, i);
+        g_autoptr(GVariant) value = g_variant_lookup_value (stats, name, NULL);
+        g_autofree char *text = g_variant_print (value, FALSE);
+        g_print ("%s: %s\n", name, text);
+    }
+}
+
+
+static int
+cmd_stats (const char               *name,
+           G_GNUC_UNUSED const void *data,
+           int                       argc,
+           char                    **argv)
+{
+    gboolean watch = FALSE;
+    int interval = 1;
+
+    GOptionEntry entries[] = {
+        { "watch", 'w', 0, G_OPTION_ARG_NONE, &watch,
+            "Keep printing the values periodically", NULL },
+        { "interval", 'i', 0, G_OPTION_ARG_INT, &interval,
+            "Seconds between updates in watch mode (default: 1)", "SECONDS" },
+        { NULL, }
+    };
+
+    g_autoptr(GOptionContext) option_context = g_option_context_new (name);
+    g_option_context_set_description (option_context,
+                                      cmd_find_by_name (name)->desc);
+    g_option_context_add_main_entries (option_context, entries, NULL);
+    g_option_context_set_help_enabled (option_context, !s_batch.active);
+
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (option_context, &argc, &argv, &error) || argc > 1) {
+        g_printerr ("%s: %s\n", name, error ? error->message : "No arguments expected");
+        return EXIT_FAILURE;
+    }
+    if (interval < 1) {
+        g_printerr ("%s: Invalid interval %d\n", name, interval);
+        return EXIT_FAILURE;
+    }
+    /* Batch replies are one line each, and the values span many. */
+    if (s_batch.active) {
+        g_printerr ("%s: Statistics cannot be retrieved in a batch\n", name);
+        return EXIT_FAILURE;
+    }
+
+    GDBusConnection *conn = get_connection (&error);
+    if (!conn) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    const gboolean clear_screen = watch && isatty (STDOUT_FILENO);
+    do {
+        g_autoptr(GVariant) result =
+            g_dbus_connection_call_sync (conn,
+                                         s_options.appid,
+                                         s_options.objpath,
+                                         COG_METRICS_GET_STATS,
+                                         NULL,
+                                         G_VARIANT_TYPE ("(a{sv})"),
+                                         G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                                         -1,
+                                         NULL,
+                                         &error);
+        if (!result) {
+            g_printerr ("%s\n", error->message);
+            return EXIT_FAILURE;
+        }
+
+        g_autoptr(GVariant) stats = g_variant_get_child_value (result, 0);
+        if (clear_screen)
+            g_print ("\033[H\033[2J");
+        print_stats (stats);
+
+        if (watch)
+            g_usleep (interval * G_USEC_PER_SEC);
+    } while (watch);
+
+    return EXIT_SUCCESS;
+}
+
+
+static int
+cmd_trace (const char               *name,
+           G_GNUC_UNUSED const void *data,
+           int                       argc,
+           char                    **argv)
+{
+    g_autofree char *output = NULL;
+
+    GOptionEntry entries[] = {
+        { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+            "Write the trace to a file instead of the standard output", "FILE" },
+        { NULL, }
+    };
+
+    g_autoptr(GOptionContext) option_context = g_option_context_new (name);
+    g_option_context_set_description (option_context,
+                                      cmd_find_by_name (name)->desc);
+    g_option_context_add_main_entries (option_context, entries, NULL);
+    g_option_context_set_help_enabled (option_context, !s_batch.active);
+
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (option_context, &argc, &argv, &error) || argc > 1) {
+        g_printerr ("%s: %s\n", name, error ? error->message : "No arguments expected");
+        return EXIT_FAILURE;
+    }
+    /* Batch replies are one line each, and a trace spans many. */
+    if (s_batch.active) {
+        g_printerr ("%s: Traces cannot be retrieved in a batch\n", name);
+        return EXIT_FAILURE;
+    }
+
+    g_autoptr(GVariant) reply = NULL;
+    if (!call_method_full (COG_TRACE_GET_EVENTS, NULL, -1, &reply, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    const char *trace;
+    g_variant_get (reply, "(&s)", &trace);
+
+    if (!output) {
+        g_print ("%s", trace);
+    } else if (!g_file_set_contents (output, trace, -1, &error)) {
+        g_printerr ("%s: %s\n", name, error->message);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+
 static int
 cmd_help (const char *name,
           const void *data,
@@ -274,6 +652,21 @@ cmd_find_by_name (const char *name)
             .desc = "Open a URL",
             .handler = cmd_open,
         },
+        {
+            .name = "mode",
+            .desc = "Switch the video mode of the output",
+            .handler = cmd_mode,
+        },
+        {
+            .name = "exec-js",
+            .desc = "Run JavaScript code in the current page and print the result",
+            .handler = cmd_exec_js,
+        },
+        {
+            .name = "save-splash",
+            .desc = "Save the output as the boot splash",
+            .handler = cmd_generic_no_args,
+        },
         {
             .name = "previous",
             .desc = "Navigate backward in the page view history",
@@ -294,6 +687,16 @@ cmd_find_by_name (const char *name)
             .desc = "Check whether Cog is running",
             .handler = cmd_ping,
         },
+        {
+            .name = "stats",
+            .desc = "Display performance counters",
+            .handler = cmd_stats,
+        },
+        {
+            .name = "trace",
+            .desc = "Save recent events in the Chrome trace format",
+            .handler = cmd_trace,
+        },
         {
             .name = "quit",
             .desc = "Exit the application",
@@ -317,13 +720,133 @@ cmd_find_by_name (const char *name)
 }
 
 
+static void
+batch_printerr (const char *message)
+{
+    g_string_append (s_batch.errors, message);
+}
+
+
+static void
+batch_run_command (const char *line)
+{
+    g_autoptr(GError) error = NULL;
+    g_auto(GStrv) argv = NULL;
+    int argc = 0;
+    if (!g_shell_parse_argv (line, &argc, &argv, &error)) {
+        batch_report (s_batch.command, NULL, error->message);
+        return;
+    }
+
+    const struct cmd *cmd = cmd_find_by_name (argv[0]);
+    if (!cmd) {
+        g_autofree char *message = g_strdup_printf ("Unrecognized command: %s", argv[0]);
+        batch_report (s_batch.command, NULL, message);
+        return;
+    }
+
+    /* Option parsing rearranges the array, keep the original to free the strings. */
+    g_autofree char **args = g_new (char*, argc + 1);
+    memcpy (args, argv, (argc + 1) * sizeof (char*));
+
+    const unsigned issued = s_batch.issued;
+    g_string_truncate (s_batch.errors, 0);
+    GPrintFunc printerr_func = g_set_printerr_handler (batch_printerr);
+    int status = (*cmd->handler) (cmd->name, cmd->data, argc, args);
+    g_set_printerr_handler (printerr_func);
+
+    /* Commands which issued a call get reported once the reply arrives. */
+    if (s_batch.issued != issued)
+        return;
+
+    if (status == EXIT_SUCCESS) {
+        batch_report (s_batch.command, NULL, NULL);
+    } else {
+        g_strchomp (s_batch.errors->str);
+        batch_report (s_batch.command, NULL, s_batch.errors->str[0] ? s_batch.errors->str : "Failed");
+    }
+}
+
+
+static gboolean
+on_batch_input (GIOChannel                *channel,
+                G_GNUC_UNUSED GIOCondition condition,
+                G_GNUC_UNUSED void        *userdata)
+{
+    g_autoptr(GError) error = NULL;
+    g_autofree char *line = NULL;
+
+    switch (g_io_channel_read_line (channel, &line, NULL, NULL, &error)) {
+        case G_IO_STATUS_NORMAL:
+            s_batch.command++;
+            g_strstrip (line);
+            if (line[0] != '\0' && line[0] != '#')
+                batch_run_command (line);
+            return G_SOURCE_CONTINUE;
+
+        case G_IO_STATUS_AGAIN:
+            return G_SOURCE_CONTINUE;
+
+        case G_IO_STATUS_ERROR:
+            g_printerr ("Cannot read commands: %s\n", error->message);
+            s_batch.failed++;
+            break;
+
+        case G_IO_STATUS_EOF:
+            break;
+    }
+
+    s_batch.eof = TRUE;
+    if (s_batch.pending == 0)
+        g_main_loop_quit (s_batch.loop);
+    return G_SOURCE_REMOVE;
+}
+
+
+static int
+run_batch (const char *path)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GIOChannel) channel = strcmp (path, "-") == 0
+        ? g_io_channel_unix_new (STDIN_FILENO)
+        : g_io_channel_new_file (path, "r", &error);
+    if (!channel) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_io_channel_set_encoding (channel, NULL, NULL);
+
+    if (!get_connection (&error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    s_batch.active = TRUE;
+    s_batch.loop = g_main_loop_new (NULL, FALSE);
+    s_batch.errors = g_string_new (NULL);
+
+    g_io_add_watch (channel, G_IO_IN | G_IO_HUP | G_IO_ERR, on_batch_input, NULL);
+    g_main_loop_run (s_batch.loop);
+
+    g_clear_pointer (&s_batch.loop, g_main_loop_unref);
+    g_string_free (s_batch.errors, TRUE);
+    s_batch.active = FALSE;
+
+    return s_batch.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
 static const char s_extended_help_text[] =
     "For a list of commands use:\n"
     "  cogctl help\n"
     "\n"
     "Help on each command can be obtained with one of:\n"
     "  cogctl help <command>\n"
-    "  cogctl <command> --help\n";
+    "  cogctl <command> --help\n"
+    "\n"
+    "With --batch, each line read is a command with its arguments, and\n"
+    "a result line with the line number followed by OK or ERROR and an\n"
+    "error message is printed for each of them.\n";
 
 
 int
@@ -354,6 +877,14 @@ main (int argc, char **argv)
         return EXIT_FAILURE;
     }
 
+    if (s_options.batch_file) {
+        if (argc > 1) {
+            g_printerr ("Subcommands cannot be used with --batch\n");
+            return EXIT_FAILURE;
+        }
+        return run_batch (s_options.batch_file);
+    }
+
     if (argc < 2) {
         g_printerr ("Missing subcommand\n");
         return EXIT_FAILURE;
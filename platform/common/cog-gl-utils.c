@@ -8,6 +8,7 @@
 #include "cog-gl-utils.h"
 
 #include "../../core/cog.h"
+#include <string.h>
 
 void
 cog_gl_shader_id_destroy(CogGLShaderId *shader_id)
@@ -79,6 +80,145 @@ cog_gl_link_program(GLuint program, GError **error)
     return false;
 }
 
+/*
+ * UV coordinates for each of the four vertices of a quad, in the same order
+ * used for the positions: top-left, top-right, bottom-left, bottom-right.
+ */
+/* clang-format off */
+static const GLfloat s_rotation_uv[][8] = {
+    [COG_GL_RENDERER_ROTATION_0] = {
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 1.0f, 1.0f, 1.0f,
+    },
+    [COG_GL_RENDERER_ROTATION_90] = {
+        1.0f, 0.0f, 1.0f, 1.0f,
+        0.0f, 0.0f, 0.0f, 1.0f,
+    },
+    [COG_GL_RENDERER_ROTATION_180] = {
+        1.0f, 1.0f, 0.0f, 1.0f,
+        1.0f, 0.0f, 0.0f, 0.0f,
+    },
+    [COG_GL_RENDERER_ROTATION_270] = {
+        0.0f, 1.0f, 0.0f, 0.0f,
+        1.0f, 1.0f, 1.0f, 0.0f,
+    },
+};
+/* clang-format on */
+
+/* Each vertex has two position coordinates followed by two UV coordinates. */
+#define VERTEX_COMPONENTS  4
+#define VERTICES_PER_LAYER 4
+
+static void
+texture_cache_reset(CogGLRenderer *self)
+{
+    for (unsigned i = 0; i < G_N_ELEMENTS(self->texture_cache); i++) {
+        CogGLRendererTexture *entry = &self->texture_cache[i];
+
+        /*
+         * Deleting the texture instead of only forgetting the image also
+         * drops the reference it holds on the buffer backing the image.
+         */
+        if (entry->texture)
+            glDeleteTextures(1, &entry->texture);
+
+        glGenTextures(1, &entry->texture);
+        glBindTexture(GL_TEXTURE_2D, entry->texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        entry->image = EGL_NO_IMAGE;
+        entry->filter = GL_NEAREST;
+        entry->last_used = 0;
+        entry->needs_import = false;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    self->textures_invalid = false;
+}
+
+/*
+ * Binds the texture associated with an image, importing the image into the
+ * least recently used texture when it is not already in the cache. Texture
+ * objects are never recreated here: re-targeting an existing one is enough.
+ */
+static CogGLRendererTexture *
+texture_cache_bind(CogGLRenderer *self, EGLImage image)
+{
+    CogGLRendererTexture *entry = NULL;
+    CogGLRendererTexture *oldest = &self->texture_cache[0];
+
+    for (unsigned i = 0; i < G_N_ELEMENTS(self->texture_cache); i++) {
+        if (self->texture_cache[i].image == image) {
+            entry = &self->texture_cache[i];
+            break;
+        }
+        if (self->texture_cache[i].last_used < oldest->last_used)
+            oldest = &self->texture_cache[i];
+    }
+
+    if (!entry) {
+        entry = oldest;
+        entry->image = image;
+        entry->needs_import = true;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, entry->texture);
+    if (entry->needs_import) {
+        glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, image);
+        entry->needs_import = false;
+    }
+
+    entry->last_used = self->paint_serial;
+    return entry;
+}
+
+/*
+ * Creates a program using the vertex shader shared by all the programs used
+ * to paint layers. Attribute locations are fixed, so the same vertex array
+ * state can be used with any of them.
+ */
+static GLuint
+create_layer_program(const char *fragment_shader_source, GError **error)
+{
+    static const char vertex_shader_source[] = "#version 100\n"
+                                               "attribute vec2 position;\n"
+                                               "attribute vec2 texture;\n"
+                                               "varying vec2 v_texture;\n"
+                                               "void main() {\n"
+                                               "  v_texture = texture;\n"
+                                               "  gl_Position = vec4(position, 0, 1);\n"
+                                               "}\n";
+
+    g_auto(CogGLShaderId) vertex_shader = cog_gl_load_shader(vertex_shader_source, GL_VERTEX_SHADER, error);
+    if (!vertex_shader)
+        return 0;
+
+    g_auto(CogGLShaderId) fragment_shader = cog_gl_load_shader(fragment_shader_source, GL_FRAGMENT_SHADER, error);
+    if (!fragment_shader)
+        return 0;
+
+    GLuint program = glCreateProgram();
+    if (!program) {
+        g_set_error_literal(error, COG_PLATFORM_EGL_ERROR, glGetError(), "Cannot create shader program");
+        return 0;
+    }
+
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glBindAttribLocation(program, 0, "position");
+    glBindAttribLocation(program, 1, "texture");
+
+    if (!cog_gl_link_program(program, error)) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
 bool
 cog_gl_renderer_initialize(CogGLRenderer *self, GError **error)
 {
@@ -97,96 +237,62 @@ cog_gl_renderer_initialize(CogGLRenderer *self, GError **error)
         }
     }
 
-    static const char vertex_shader_source[] = "#version 100\n"
-                                               "attribute vec2 position;\n"
-                                               "attribute vec2 texture;\n"
-                                               "varying vec2 v_texture;\n"
-                                               "void main() {\n"
-                                               "  v_texture = texture;\n"
-                                               "  gl_Position = vec4(position, 0, 1);\n"
-                                               "}\n";
     static const char fragment_shader_source[] = "#version 100\n"
                                                  "precision mediump float;\n"
                                                  "uniform sampler2D u_texture;\n"
+                                                 "uniform float u_opacity;\n"
                                                  "varying vec2 v_texture;\n"
                                                  "void main() {\n"
-                                                 "  gl_FragColor = texture2D(u_texture, v_texture);\n"
+                                                 "  gl_FragColor = texture2D(u_texture, v_texture) * u_opacity;\n"
                                                  "}\n";
 
-    g_auto(CogGLShaderId) vertex_shader = cog_gl_load_shader(vertex_shader_source, GL_VERTEX_SHADER, error);
-    if (!vertex_shader)
-        return false;
-
-    g_auto(CogGLShaderId) fragment_shader = cog_gl_load_shader(fragment_shader_source, GL_FRAGMENT_SHADER, error);
-    if (!fragment_shader)
-        return false;
-
-    if (!(self->program = glCreateProgram())) {
-        g_set_error_literal(error, COG_PLATFORM_EGL_ERROR, glGetError(), "Cannot create shader program");
-        return false;
-    }
-
-    glAttachShader(self->program, vertex_shader);
-    glAttachShader(self->program, fragment_shader);
-    glBindAttribLocation(self->program, 0, "position");
-    glBindAttribLocation(self->program, 1, "texture");
-
-    if (!cog_gl_link_program(self->program, error)) {
-        glDeleteProgram(self->program);
-        self->program = 0;
+    if (!(self->program = create_layer_program(fragment_shader_source, error)))
         return false;
-    }
 
     self->attrib_position = glGetAttribLocation(self->program, "position");
     self->attrib_texture = glGetAttribLocation(self->program, "texture");
+    self->uniform_texture = glGetUniformLocation(self->program, "u_texture");
+    self->uniform_opacity = glGetUniformLocation(self->program, "u_opacity");
 
-    g_assert(self->attrib_position >= 0 && self->attrib_texture >= 0 && self->uniform_texture >= 0);
+    g_assert(self->attrib_position >= 0 && self->attrib_texture >= 0 && self->uniform_texture >= 0 &&
+             self->uniform_opacity >= 0);
 
-    /* Create texture. */
-    glGenTextures(1, &self->texture);
-    glBindTexture(GL_TEXTURE_2D, self->texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    texture_cache_reset(self);
+    self->paint_serial = 0;
 
     /* Create vertex buffer */
-    if (epoxy_is_desktop_gl() || epoxy_gl_version() >= 30) {
+    if (epoxy_is_desktop_gl() || epoxy_gl_version() >= 30 || epoxy_has_gl_extension("GL_OES_vertex_array_object")) {
         glGenVertexArrays(1, &self->vao);
         glBindVertexArray(self->vao);
     } else {
         self->vao = 0;
     }
 
-    /* clang-format off */
-    static const GLfloat vertices[] = {
-        /* position */
-        -1.0f,  1.0f, 1.0f,  1.0f,
-        -1.0f, -1.0f, 1.0f, -1.0f,
-        /* texture */
-        /* COG_GL_RENDERER_ROTATION_0 */
-        0.0f, 0.0f, 1.0f, 0.0f,
-        0.0f, 1.0f, 1.0f, 1.0f,
-        /* COG_GL_RENDERER_ROTATION_90 */
-        1.0f, 0.0f, 1.0f, 1.0f,
-        0.0f, 0.0f, 0.0f, 1.0f,
-        /* COG_GL_RENDERER_ROTATION_180 */
-        1.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, 0.0f, 0.0f, 0.0f,
-        /* COG_GL_RENDERER_ROTATION_270 */
-        0.0f, 1.0f, 0.0f, 0.0f,
-        1.0f, 1.0f, 1.0f, 0.0f,
-    };
-    /* clang-format on */
-
+    /*
+     * The buffer is big enough for the maximum amount of layers, and its
+     * contents get updated on each paint.
+     */
     glGenBuffers(1, &self->buffer_vertex);
     glBindBuffer(GL_ARRAY_BUFFER, self->buffer_vertex);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    if (self->vao > 0)
+    glBufferData(GL_ARRAY_BUFFER,
+                 COG_GL_RENDERER_MAX_LAYERS * VERTICES_PER_LAYER * VERTEX_COMPONENTS * sizeof(GLfloat),
+                 NULL,
+                 GL_DYNAMIC_DRAW);
+
+    /*
+     * When vertex array objects are available the attribute layout is
+     * recorded once here, and painting only needs to bind the VAO.
+     */
+    if (self->vao > 0) {
+        const GLsizei stride = VERTEX_COMPONENTS * sizeof(GLfloat);
+        glVertexAttribPointer(self->attrib_position, 2, GL_FLOAT, GL_FALSE, stride, (void *) 0);
+        glVertexAttribPointer(self->attrib_texture, 2, GL_FLOAT, GL_FALSE, stride, (void *) (2 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(self->attrib_position);
+        glEnableVertexAttribArray(self->attrib_texture);
         glBindVertexArray(0);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     return true;
 }
@@ -196,9 +302,13 @@ cog_gl_renderer_finalize(CogGLRenderer *self)
 {
     g_assert(self);
 
-    if (self->texture) {
-        glDeleteTextures(1, &self->texture);
-        self->texture = 0;
+    for (unsigned i = 0; i < G_N_ELEMENTS(self->texture_cache); i++) {
+        CogGLRendererTexture *entry = &self->texture_cache[i];
+        if (entry->texture) {
+            glDeleteTextures(1, &entry->texture);
+            entry->texture = 0;
+        }
+        entry->image = EGL_NO_IMAGE;
     }
 
     if (self->program) {
@@ -206,6 +316,17 @@ cog_gl_renderer_finalize(CogGLRenderer *self)
         self->program = 0;
     }
 
+    if (self->color_program) {
+        glDeleteProgram(self->color_program);
+        self->color_program = 0;
+    }
+
+    if (self->color_lut_texture) {
+        glDeleteTextures(1, &self->color_lut_texture);
+        self->color_lut_texture = 0;
+    }
+    self->color_enabled = false;
+
     if (self->vao > 0) {
         glDeleteVertexArrays(1, &self->vao);
         self->vao = 0;
@@ -219,42 +340,373 @@ cog_gl_renderer_finalize(CogGLRenderer *self)
     self->attrib_position = 0;
     self->attrib_texture = 0;
     self->uniform_texture = 0;
+    self->uniform_opacity = 0;
+}
+
+void
+cog_gl_renderer_invalidate_textures(CogGLRenderer *self)
+{
+    g_assert(self);
+
+    /* Actual cleanup is deferred to the next paint, with a context active. */
+    self->textures_invalid = true;
+}
+
+void
+cog_gl_renderer_import_image(CogGLRenderer *self, EGLImage image)
+{
+    g_assert(self);
+
+    /*
+     * The exporter may have destroyed the image previously known by this
+     * handle and created a new one which got the same handle, so a cached
+     * texture has to be re-targeted before it gets sampled again. This
+     * needs no active context, the import happens on the next paint.
+     */
+    for (unsigned i = 0; i < G_N_ELEMENTS(self->texture_cache); i++) {
+        if (self->texture_cache[i].image == image)
+            self->texture_cache[i].needs_import = true;
+    }
+}
+
+static bool
+color_program_initialize(CogGLRenderer *self, GError **error)
+{
+    /*
+     * Colors are un-premultiplied before applying the transform. The lookup
+     * coordinates are adjusted to sample at the center of the first and last
+     * texels for the extreme values, with linear interpolation in between.
+     */
+    static const char fragment_shader_source[] =
+        "#version 100\n"
+        "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+        "precision highp float;\n"
+        "#else\n"
+        "precision mediump float;\n"
+        "#endif\n"
+        "uniform sampler2D u_texture;\n"
+        "uniform sampler2D u_lut;\n"
+        "uniform vec2 u_lut_coords;\n"
+        "uniform mat3 u_ctm;\n"
+        "uniform float u_opacity;\n"
+        "varying vec2 v_texture;\n"
+        "void main() {\n"
+        "  vec4 color = texture2D(u_texture, v_texture);\n"
+        "  vec3 rgb = (color.a > 0.0) ? color.rgb / color.a : vec3(0.0);\n"
+        "  rgb = clamp(u_ctm * rgb, 0.0, 1.0) * u_lut_coords.x + u_lut_coords.y;\n"
+        "  rgb = vec3(texture2D(u_lut, vec2(rgb.r, 0.5)).r,\n"
+        "             texture2D(u_lut, vec2(rgb.g, 0.5)).g,\n"
+        "             texture2D(u_lut, vec2(rgb.b, 0.5)).b);\n"
+        "  gl_FragColor = vec4(rgb * color.a, color.a) * u_opacity;\n"
+        "}\n";
+
+    if (!(self->color_program = create_layer_program(fragment_shader_source, error)))
+        return false;
+
+    self->color_uniform_texture = glGetUniformLocation(self->color_program, "u_texture");
+    self->color_uniform_opacity = glGetUniformLocation(self->color_program, "u_opacity");
+    self->color_uniform_lut = glGetUniformLocation(self->color_program, "u_lut");
+    self->color_uniform_lut_coords = glGetUniformLocation(self->color_program, "u_lut_coords");
+    self->color_uniform_ctm = glGetUniformLocation(self->color_program, "u_ctm");
+
+    glGenTextures(1, &self->color_lut_texture);
+    glBindTexture(GL_TEXTURE_2D, self->color_lut_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
+/*
+ * Configures the color transform applied when painting. The lookup table
+ * has lut_size entries with interleaved red, green, and blue values using
+ * the whole 16-bit range, and the matrix is given in row-major order. Each
+ * of them may be NULL to skip the corresponding step, and passing NULL for
+ * both disables the transform altogether.
+ */
+bool
+cog_gl_renderer_set_color_transform(CogGLRenderer  *self,
+                                    const uint16_t *lut,
+                                    unsigned        lut_size,
+                                    const float    *ctm,
+                                    GError        **error)
+{
+    g_assert(self);
+    g_assert(!lut || lut_size >= 2);
+    g_assert(eglGetCurrentContext() != EGL_NO_CONTEXT);
+
+    if (!lut && !ctm) {
+        self->color_enabled = false;
+        return true;
+    }
+
+    GLint max_texture_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    if (lut && lut_size > (unsigned) max_texture_size) {
+        g_set_error(error, COG_PLATFORM_EGL_ERROR, 0, "Color lookup table size %u exceeds maximum texture size %d",
+                    lut_size, max_texture_size);
+        return false;
+    }
+
+    if (!self->color_program && !color_program_initialize(self, error))
+        return false;
+
+    /* Without a lookup table, use an identity one with two entries. */
+    static const uint16_t identity_lut[] = {0, 0, 0, UINT16_MAX, UINT16_MAX, UINT16_MAX};
+    if (!lut) {
+        lut = identity_lut;
+        lut_size = 2;
+    }
+
+    g_autofree GLubyte *texels = g_new(GLubyte, lut_size * 4);
+    for (unsigned i = 0; i < lut_size; i++) {
+        texels[i * 4 + 0] = lut[i * 3 + 0] >> 8;
+        texels[i * 4 + 1] = lut[i * 3 + 1] >> 8;
+        texels[i * 4 + 2] = lut[i * 3 + 2] >> 8;
+        texels[i * 4 + 3] = UINT8_MAX;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, self->color_lut_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, lut_size, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    self->color_lut_size = lut_size;
+
+    /* GLES requires column-major matrices. */
+    static const float identity_ctm[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    if (!ctm)
+        ctm = identity_ctm;
+    for (unsigned row = 0; row < 3; row++) {
+        for (unsigned col = 0; col < 3; col++)
+            self->color_ctm[col * 3 + row] = ctm[row * 3 + col];
+    }
+
+    self->color_enabled = true;
+    return true;
 }
 
 void
 cog_gl_renderer_paint(CogGLRenderer *self, EGLImage *image, CogGLRendererRotation rotation)
+{
+    /*
+     * Using an output size of 1x1 and a destination rectangle of the same
+     * size makes the quad cover the whole viewport, whatever its size.
+     */
+    const CogGLRendererLayer layer = {
+        .image = image,
+        .dst = {0, 0, 1, 1},
+        .opacity = 1.0f,
+        .rotation = rotation,
+        .filter = COG_GL_RENDERER_FILTER_NEAREST,
+    };
+    cog_gl_renderer_paint_layers(self, &layer, 1, 1, 1);
+}
+
+static inline GLfloat *
+layer_fill_vertices(const CogGLRendererLayer *layer, uint32_t output_width, uint32_t output_height, GLfloat *v)
+{
+    const GLfloat x0 = 2.0f * layer->dst.x / output_width - 1.0f;
+    const GLfloat x1 = 2.0f * (layer->dst.x + (int64_t) layer->dst.width) / output_width - 1.0f;
+    const GLfloat y0 = 1.0f - 2.0f * layer->dst.y / output_height;
+    const GLfloat y1 = 1.0f - 2.0f * (layer->dst.y + (int64_t) layer->dst.height) / output_height;
+
+    const GLfloat *uv = s_rotation_uv[layer->rotation];
+
+    /* clang-format off */
+    const GLfloat vertices[VERTICES_PER_LAYER * VERTEX_COMPONENTS] = {
+        x0, y0, uv[0], uv[1],
+        x1, y0, uv[2], uv[3],
+        x0, y1, uv[4], uv[5],
+        x1, y1, uv[6], uv[7],
+    };
+    /* clang-format on */
+
+    memcpy(v, vertices, sizeof(vertices));
+    return v + G_N_ELEMENTS(vertices);
+}
+
+void
+cog_gl_renderer_paint_layers(CogGLRenderer            *self,
+                             const CogGLRendererLayer *layers,
+                             unsigned                  n_layers,
+                             uint32_t                  output_width,
+                             uint32_t                  output_height)
 {
     g_assert(self);
-    g_assert(image != EGL_NO_IMAGE);
+    g_assert(layers || !n_layers);
+    g_assert(n_layers <= COG_GL_RENDERER_MAX_LAYERS);
+    g_assert(output_width > 0 && output_height > 0);
     g_assert(eglGetCurrentContext() != EGL_NO_CONTEXT);
-    g_assert(rotation == COG_GL_RENDERER_ROTATION_0 || rotation == COG_GL_RENDERER_ROTATION_90 ||
-             rotation == COG_GL_RENDERER_ROTATION_180 || rotation <= COG_GL_RENDERER_ROTATION_270);
 
-    glUseProgram(self->program);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, self->texture);
-    glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, image);
-    glUniform1i(self->uniform_texture, 0);
+    if (!n_layers)
+        return;
 
-    if (self->vao > 0)
-        glBindVertexArray(self->vao);
+    GLfloat  vertices[COG_GL_RENDERER_MAX_LAYERS * VERTICES_PER_LAYER * VERTEX_COMPONENTS];
+    GLfloat *v = vertices;
+    bool     needs_blending = false;
+
+    for (unsigned i = 0; i < n_layers; i++) {
+        const CogGLRendererLayer *layer = &layers[i];
+        g_assert(layer->image != EGL_NO_IMAGE);
+        g_assert(layer->rotation >= COG_GL_RENDERER_ROTATION_0 && layer->rotation <= COG_GL_RENDERER_ROTATION_270);
+
+        v = layer_fill_vertices(layer, output_width, output_height, v);
+
+        /* The bottom layer is painted opaque unless explicitly requested. */
+        if (i > 0 || layer->opacity < 1.0f)
+            needs_blending = true;
+    }
+
+    if (G_UNLIKELY(self->textures_invalid))
+        texture_cache_reset(self);
+    self->paint_serial++;
+
+    GLint uniform_opacity;
+    if (self->color_enabled) {
+        glUseProgram(self->color_program);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, self->color_lut_texture);
+        glUniform1i(self->color_uniform_lut, 1);
+        glUniform2f(self->color_uniform_lut_coords, (self->color_lut_size - 1.0f) / self->color_lut_size,
+                    0.5f / self->color_lut_size);
+        glUniformMatrix3fv(self->color_uniform_ctm, 1, GL_FALSE, self->color_ctm);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(self->color_uniform_texture, 0);
+        uniform_opacity = self->color_uniform_opacity;
+    } else {
+        glUseProgram(self->program);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(self->uniform_texture, 0);
+        uniform_opacity = self->uniform_opacity;
+    }
 
     glBindBuffer(GL_ARRAY_BUFFER, self->buffer_vertex);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (v - vertices) * sizeof(GLfloat), vertices);
 
-    glVertexAttribPointer(self->attrib_position, 2, GL_FLOAT, GL_FALSE, 0, (void *) 0);
-    glVertexAttribPointer(self->attrib_texture, 2, GL_FLOAT, GL_FALSE, 0,
-                          (void *) ((rotation + 1) * 2 * 4 * sizeof(GLfloat)));
+    if (self->vao > 0) {
+        glBindVertexArray(self->vao);
+    } else {
+        const GLsizei stride = VERTEX_COMPONENTS * sizeof(GLfloat);
+        glVertexAttribPointer(self->attrib_position, 2, GL_FLOAT, GL_FALSE, stride, (void *) 0);
+        glVertexAttribPointer(self->attrib_texture, 2, GL_FLOAT, GL_FALSE, stride, (void *) (2 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(self->attrib_position);
+        glEnableVertexAttribArray(self->attrib_texture);
+    }
 
-    glEnableVertexAttribArray(self->attrib_position);
-    glEnableVertexAttribArray(self->attrib_texture);
+    /* Content is expected to have premultiplied alpha. */
+    if (needs_blending) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    }
 
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    for (unsigned i = 0; i < n_layers; i++) {
+        const CogGLRendererLayer *layer = &layers[i];
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+        CogGLRendererTexture *texture = texture_cache_bind(self, layer->image);
+
+        const GLenum filter = (layer->filter == COG_GL_RENDERER_FILTER_LINEAR) ? GL_LINEAR : GL_NEAREST;
+        if (texture->filter != filter) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+            texture->filter = filter;
+        }
+
+        glUniform1f(uniform_opacity, layer->opacity);
+        glDrawArrays(GL_TRIANGLE_STRIP, i * VERTICES_PER_LAYER, VERTICES_PER_LAYER);
+    }
+
+    if (needs_blending)
+        glDisable(GL_BLEND);
 
-    glDisableVertexAttribArray(self->attrib_position);
-    glDisableVertexAttribArray(self->attrib_texture);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (self->color_enabled) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    if (self->vao > 0)
+    if (self->vao > 0) {
         glBindVertexArray(0);
+    } else {
+        glDisableVertexAttribArray(self->attrib_position);
+        glDisableVertexAttribArray(self->attrib_texture);
+    }
+}
+
+void
+cog_gl_renderer_fit_rect(CogGLRendererScaling scaling,
+                         uint32_t             src_width,
+                         uint32_t             src_height,
+                         uint32_t             dst_width,
+                         uint32_t             dst_height,
+                         CogGLRendererRect   *rect)
+{
+    g_assert(rect);
+
+    if (!src_width || !src_height) {
+        *rect = (CogGLRendererRect){0, 0, dst_width, dst_height};
+        return;
+    }
+
+    switch (scaling) {
+    case COG_GL_RENDERER_SCALING_NONE:
+        rect->width = src_width;
+        rect->height = src_height;
+        break;
+    case COG_GL_RENDERER_SCALING_STRETCH:
+        rect->width = dst_width;
+        rect->height = dst_height;
+        break;
+    case COG_GL_RENDERER_SCALING_FIT:
+        /* Compare dst_w/src_w with dst_h/src_h, without divisions. */
+        if ((uint64_t) dst_width * src_height <= (uint64_t) dst_height * src_width) {
+            rect->width = dst_width;
+            rect->height = ((uint64_t) src_height * dst_width + src_width / 2) / src_width;
+        } else {
+            rect->width = ((uint64_t) src_width * dst_height + src_height / 2) / src_height;
+            rect->height = dst_height;
+        }
+        break;
+    default:
+        g_assert_not_reached();
+    }
+
+    /* Center, which letterboxes the content if needed. */
+    rect->x = ((int64_t) dst_width - rect->width) / 2;
+    rect->y = ((int64_t) dst_height - rect->height) / 2;
+}
+
+bool
+cog_gl_renderer_scaling_from_string(const char *name, CogGLRendererScaling *scaling)
+{
+    g_assert(scaling);
+
+    if (g_strcmp0(name, "none") == 0)
+        *scaling = COG_GL_RENDERER_SCALING_NONE;
+    else if (g_strcmp0(name, "stretch") == 0)
+        *scaling = COG_GL_RENDERER_SCALING_STRETCH;
+    else if (g_strcmp0(name, "fit") == 0)
+        *scaling = COG_GL_RENDERER_SCALING_FIT;
+    else
+        return false;
+
+    return true;
+}
+
+bool
+cog_gl_renderer_filter_from_string(const char *name, CogGLRendererFilter *filter)
+{
+    g_assert(filter);
+
+    if (g_strcmp0(name, "nearest") == 0)
+        *filter = COG_GL_RENDERER_FILTER_NEAREST;
+    else if (g_strcmp0(name, "linear") == 0)
+        *filter = COG_GL_RENDERER_FILTER_LINEAR;
+    else
+        return false;
+
+    return true;
 }
@@ -10,6 +10,7 @@
 #include <epoxy/egl.h>
 #include <epoxy/gl.h>
 #include <glib.h>
+#include <stdint.h>
 
 G_BEGIN_DECLS
 
@@ -25,19 +26,30 @@ CogGLShaderId cog_gl_load_shader(const char *source, GLenum kind, GError **) G_G
 bool cog_gl_link_program(GLuint program, GError **);
 
 /*
- * CogGLRenderer wraps an EGLImage (for example provided by wpebackend-fdo)
- * into a texture, then paints a quad which covers the current viewport and
- * samples said texture.
+ * CogGLRenderer is a small compositor which wraps EGLImages (for example
+ * provided by wpebackend-fdo) into textures, then paints a list of layers,
+ * each one of them a quad which samples one of the images.
  *
  * A simple GLSL shader program uses the "position" attribute to fetch the
- * coordinates of the quad, and the "texture" attribute the UV mapping
- * coordinates for the texture. Rotation is achieved by changing the UV
- * mapping. The "texture" uniform is used to reference the texture unit
- * where the frame textures get loaded.
+ * coordinates of each quad, and the "texture" attribute the UV mapping
+ * coordinates for its texture. Rotation is achieved by changing the UV
+ * mapping. The "u_texture" uniform is used to reference the texture unit
+ * where the frame textures get loaded, and "u_opacity" to modulate the
+ * (premultiplied) color of each layer.
+ *
+ * Each layer (CogGLRendererLayer) has a destination rectangle expressed in
+ * output pixels, with the origin at the top-left corner, plus opacity,
+ * rotation, and the filter used to sample the image when scaled. The
+ * vertices for all the layers are uploaded at once, and then the layers
+ * are drawn in order (the first one at the bottom) within a single pass
+ * which sets up the shader program state only once. The
+ * cog_gl_renderer_fit_rect() helper can be used to calculate destination
+ * rectangles which scale content to an output of arbitrary size, with
+ * or without letterboxing.
  *
  * By itself the renderer only knows how to prepare the shader program
- * and how to use it to paint a textured quad with the given EGLImage as
- * its texture. The rest of EGL/GL/GLES handling is left out intentionally.
+ * and how to use it to paint textured quads with the given EGLImages as
+ * their textures. The rest of EGL/GL/GLES handling is left out intentionally.
  *
  * To use the renderer:
  *
@@ -53,35 +65,129 @@ bool cog_gl_link_program(GLuint program, GError **);
  *   - Optionally, paint before using the renderer (e.g. some solid color
  *     background below the image, shows if the web view and its content
  *     have transparency).
- *   - Use glViewport() to set the region to be painted on, then
- *     call cog_gl_renderer_paint() to cover the region with the image.
+ *   - Use glViewport() to set the region to be painted on, then call
+ *     cog_gl_renderer_paint_layers() passing the size of the region, or
+ *     cog_gl_renderer_paint() to cover the whole region with one image.
  *   - Optionally, paint afterwards (e.g. some user interface shown over
  *     or around the image).
  *
+ * - Caching:
+ *   - Textures are kept in a small cache keyed by EGLImage, because WebKit
+ *     cycles through a handful of buffers. The texture objects live as
+ *     long as the renderer, and repainting an image which is already in
+ *     the cache only needs a glBindTexture() call.
+ *   - Call cog_gl_renderer_import_image() each time the exporter hands
+ *     over an image: its handle may be one of a destroyed image, and the
+ *     cached texture gets re-targeted to the new image on the next paint.
+ *   - Call cog_gl_renderer_invalidate_textures() when all the buffers are
+ *     going to be replaced, typically after a resize or a mode change, to
+ *     release the references the textures hold on the old ones.
+ *
+ * - Color transform:
+ *   - Optionally, cog_gl_renderer_set_color_transform() enables a second
+ *     shader program which applies a 3x3 color matrix followed by a lookup
+ *     table to every painted pixel. It is meant as a fallback for outputs
+ *     without hardware color management, and costs one additional texture
+ *     lookup per color channel.
+ *
  * - Shutdown:
  *   - Call cog_gl_renderer_finalize() to dispose of the shader program
- *     and texture used for painting.
+ *     and textures used for painting.
  */
 
+#define COG_GL_RENDERER_MAX_LAYERS         8
+#define COG_GL_RENDERER_TEXTURE_CACHE_SIZE 4
+
+typedef enum {
+    COG_GL_RENDERER_ROTATION_0 = 0,
+    COG_GL_RENDERER_ROTATION_90 = 1,
+    COG_GL_RENDERER_ROTATION_180 = 2,
+    COG_GL_RENDERER_ROTATION_270 = 3,
+} CogGLRendererRotation;
+
+typedef enum {
+    COG_GL_RENDERER_FILTER_NEAREST = 0,
+    COG_GL_RENDERER_FILTER_LINEAR = 1,
+} CogGLRendererFilter;
+
+typedef enum {
+    COG_GL_RENDERER_SCALING_NONE = 0,
+    COG_GL_RENDERER_SCALING_STRETCH = 1,
+    COG_GL_RENDERER_SCALING_FIT = 2,
+} CogGLRendererScaling;
+
+typedef struct {
+    int32_t  x, y;
+    uint32_t width, height;
+} CogGLRendererRect;
+
+typedef struct {
+    EGLImage image;
+    GLuint   texture;
+    GLenum   filter;
+    unsigned last_used;
+    bool     needs_import;
+} CogGLRendererTexture;
+
 typedef struct {
     GLuint vao;
     GLuint program;
-    GLuint texture;
     GLuint buffer_vertex;
     GLint  attrib_position;
     GLint  attrib_texture;
     GLint  uniform_texture;
+    GLint  uniform_opacity;
+
+    /* Optional color transform stage, used only when enabled. */
+    GLuint  color_program;
+    GLint   color_uniform_texture;
+    GLint   color_uniform_opacity;
+    GLint   color_uniform_lut;
+    GLint   color_uniform_lut_coords;
+    GLint   color_uniform_ctm;
+    GLuint  color_lut_texture;
+    GLint   color_lut_size;
+    GLfloat color_ctm[9];
+    bool    color_enabled;
+
+    CogGLRendererTexture texture_cache[COG_GL_RENDERER_TEXTURE_CACHE_SIZE];
+    unsigned             paint_serial;
+    bool                 textures_invalid;
 } CogGLRenderer;
 
-typedef enum {
-    COG_GL_RENDERER_ROTATION_0 = 0,
-    COG_GL_RENDERER_ROTATION_90 = 1,
-    COG_GL_RENDERER_ROTATION_180 = 2,
-    COG_GL_RENDERER_ROTATION_270 = 3,
-} CogGLRendererRotation;
+typedef struct {
+    EGLImage              image;
+    CogGLRendererRect     dst;
+    float                 opacity;
+    CogGLRendererRotation rotation;
+    CogGLRendererFilter   filter;
+} CogGLRendererLayer;
 
 bool cog_gl_renderer_initialize(CogGLRenderer *self, GError **error);
 void cog_gl_renderer_finalize(CogGLRenderer *self);
+void cog_gl_renderer_invalidate_textures(CogGLRenderer *self);
+void cog_gl_renderer_import_image(CogGLRenderer *self, EGLImage image);
 void cog_gl_renderer_paint(CogGLRenderer *self, EGLImage *image, CogGLRendererRotation rotation);
+void cog_gl_renderer_paint_layers(CogGLRenderer            *self,
+                                  const CogGLRendererLayer *layers,
+                                  unsigned                  n_layers,
+                                  uint32_t                  output_width,
+                                  uint32_t                  output_height);
+
+bool cog_gl_renderer_set_color_transform(CogGLRenderer  *self,
+                                         const uint16_t *lut,
+                                         unsigned        lut_size,
+                                         const float    *ctm,
+                                         GError        **error);
+
+void cog_gl_renderer_fit_rect(CogGLRendererScaling scaling,
+                              uint32_t             src_width,
+                              uint32_t             src_height,
+                              uint32_t             dst_width,
+                              uint32_t             dst_height,
+                              CogGLRendererRect   *rect);
+
+bool cog_gl_renderer_scaling_from_string(const char *name, CogGLRendererScaling *scaling);
+bool cog_gl_renderer_filter_from_string(const char *name, CogGLRendererFilter *filter);
 
 G_END_DECLS
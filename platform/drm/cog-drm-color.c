@@ -0,0 +1,264 @@
+/*
+ * cog-drm-color.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-drm-color.h"
+
+#include <math.h>
+
+/* Luminance range where the DICOM GSDF is defined, in cd/m². */
+#define GSDF_MIN_LUMINANCE 0.05
+#define GSDF_MAX_LUMINANCE 4000.0
+
+const char *const cog_drm_color_config_keys[] = {
+    "color-pipeline", "brightness", "gamma", "gsdf-luminance", "panel-gamma", "color-curve", "ctm", NULL,
+};
+
+void
+cog_drm_color_config_init(CogDrmColorConfig *config)
+{
+    *config = (CogDrmColorConfig){
+        .pipeline = COG_DRM_COLOR_PIPELINE_AUTO,
+        .brightness = 1.0,
+        .gamma = 1.0,
+        .panel_gamma = 2.2,
+    };
+}
+
+void
+cog_drm_color_config_clear(CogDrmColorConfig *config)
+{
+    g_clear_pointer(&config->curve, g_free);
+    config->curve_size = 0;
+}
+
+static bool
+parse_double(const char *value, double min, double max, double *result)
+{
+    char  *endp = NULL;
+    double d = g_ascii_strtod(value, &endp);
+    if (endp == value || *endp != '\0' || !isfinite(d) || d < min || d > max)
+        return false;
+
+    *result = d;
+    return true;
+}
+
+/* Parses a list of numbers separated by spaces, commas, colons or semicolons. */
+static unsigned
+parse_numbers(const char *value, double *numbers, unsigned max_numbers)
+{
+    g_auto(GStrv) items = g_strsplit_set(value, " \t,:;", -1);
+    unsigned      n = 0;
+
+    for (unsigned i = 0; items[i]; i++) {
+        if (items[i][0] == '\0')
+            continue;
+        if (n == max_numbers || !parse_double(items[i], -G_MAXDOUBLE, G_MAXDOUBLE, &numbers[n]))
+            return 0;
+        n++;
+    }
+    return n;
+}
+
+/*
+ * Loads a transfer curve from a text file. Each line contains either one
+ * value used for all channels, or three values for the red, green, and
+ * blue channels, all of them in the [0, 1] range. Empty lines and those
+ * starting with '#' are ignored.
+ */
+static bool
+load_curve(CogDrmColorConfig *config, const char *path, GError **error)
+{
+    g_autofree char *contents = NULL;
+    if (!g_file_get_contents(path, &contents, NULL, error))
+        return false;
+
+    g_auto(GStrv)     lines = g_strsplit(contents, "\n", -1);
+    g_autoptr(GArray) curve = g_array_new(FALSE, FALSE, sizeof(double));
+
+    for (unsigned i = 0; lines[i]; i++) {
+        const char *line = g_strstrip(lines[i]);
+        if (line[0] == '\0' || line[0] == '#')
+            continue;
+
+        double   values[3];
+        unsigned n = parse_numbers(line, values, G_N_ELEMENTS(values));
+        if (n == 1) {
+            values[1] = values[2] = values[0];
+        } else if (n != 3) {
+            g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE, "%s:%u: Expected 1 or 3 values",
+                        path, i + 1);
+            return false;
+        }
+
+        for (unsigned j = 0; j < G_N_ELEMENTS(values); j++) {
+            if (values[j] < 0.0 || values[j] > 1.0) {
+                g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE,
+                            "%s:%u: Values must be in the [0, 1] range", path, i + 1);
+                return false;
+            }
+        }
+        g_array_append_vals(curve, values, G_N_ELEMENTS(values));
+    }
+
+    if (curve->len < 2 * 3) {
+        g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE, "%s: At least two entries are needed",
+                    path);
+        return false;
+    }
+
+    cog_drm_color_config_clear(config);
+    config->curve_size = curve->len / 3;
+    config->curve = (double *) g_array_free(g_steal_pointer(&curve), FALSE);
+    return true;
+}
+
+bool
+cog_drm_color_config_set(CogDrmColorConfig *config, const char *key, const char *value, GError **error)
+{
+    g_assert(config);
+    g_assert(key);
+    g_assert(value);
+
+    if (g_str_equal(key, "color-pipeline")) {
+        if (g_str_equal(value, "auto"))
+            config->pipeline = COG_DRM_COLOR_PIPELINE_AUTO;
+        else if (g_str_equal(value, "kms"))
+            config->pipeline = COG_DRM_COLOR_PIPELINE_KMS;
+        else if (g_str_equal(value, "shader"))
+            config->pipeline = COG_DRM_COLOR_PIPELINE_SHADER;
+        else
+            goto invalid_value;
+    } else if (g_str_equal(key, "brightness")) {
+        if (!parse_double(value, 0.0, 1.0, &config->brightness))
+            goto invalid_value;
+    } else if (g_str_equal(key, "gamma")) {
+        if (!parse_double(value, 0.1, 10.0, &config->gamma))
+            goto invalid_value;
+    } else if (g_str_equal(key, "panel-gamma")) {
+        if (!parse_double(value, 0.1, 10.0, &config->panel_gamma))
+            goto invalid_value;
+    } else if (g_str_equal(key, "gsdf-luminance")) {
+        double range[2];
+        if (parse_numbers(value, range, G_N_ELEMENTS(range)) != 2 || range[0] < GSDF_MIN_LUMINANCE ||
+            range[1] > GSDF_MAX_LUMINANCE || range[0] >= range[1])
+            goto invalid_value;
+        config->gsdf_min_luminance = range[0];
+        config->gsdf_max_luminance = range[1];
+    } else if (g_str_equal(key, "color-curve")) {
+        return load_curve(config, value, error);
+    } else if (g_str_equal(key, "ctm")) {
+        if (parse_numbers(value, config->ctm, G_N_ELEMENTS(config->ctm)) != G_N_ELEMENTS(config->ctm))
+            goto invalid_value;
+        config->has_ctm = true;
+    } else {
+        g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND, "Unknown color setting '%s'", key);
+        return false;
+    }
+
+    return true;
+
+invalid_value:
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE, "Invalid value '%s' for '%s'", value, key);
+    return false;
+}
+
+bool
+cog_drm_color_config_has_curve(const CogDrmColorConfig *config)
+{
+    return config->curve || config->gsdf_min_luminance > 0.0 || config->gamma != 1.0 || config->brightness != 1.0;
+}
+
+bool
+cog_drm_color_config_is_identity(const CogDrmColorConfig *config)
+{
+    return !config->has_ctm && !cog_drm_color_config_has_curve(config);
+}
+
+/*
+ * Grayscale Standard Display Function, from DICOM PS3.14: luminance for a
+ * given just-noticeable difference index, and its inverse.
+ */
+static double
+gsdf_luminance(double j)
+{
+    const double x = log(j);
+    const double num = -1.3011877 + x * (8.0242636e-2 + x * (1.3646699e-1 + x * (-2.5468404e-2 + x * 1.3635334e-3)));
+    const double den =
+        1.0 + x * (-2.5840191e-2 + x * (-1.0320229e-1 + x * (2.8745620e-2 + x * (-3.1978977e-3 + x * 1.2992634e-4))));
+    return pow(10.0, num / den);
+}
+
+static double
+gsdf_jnd_index(double luminance)
+{
+    static const double coeffs[] = {
+        71.498068,  94.593053,   41.912053,  9.8247004,    0.28175407,
+        -1.1878455, -0.18014349, 0.14710899, -0.017046845,
+    };
+
+    const double x = log10(luminance);
+    double       j = 0.0;
+    for (unsigned i = G_N_ELEMENTS(coeffs); i > 0; i--)
+        j = j * x + coeffs[i - 1];
+    return j;
+}
+
+/*
+ * Maps input values to drive levels which make the luminance of the panel
+ * follow the GSDF between its minimum and maximum luminance, assuming the
+ * native response of the panel is a power function.
+ */
+static double
+gsdf_curve(const CogDrmColorConfig *config, double x)
+{
+    const double l_min = config->gsdf_min_luminance;
+    const double l_max = config->gsdf_max_luminance;
+    const double j_min = gsdf_jnd_index(l_min);
+    const double j_max = gsdf_jnd_index(l_max);
+
+    const double l = gsdf_luminance(j_min + x * (j_max - j_min));
+    return pow(CLAMP((l - l_min) / (l_max - l_min), 0.0, 1.0), 1.0 / config->panel_gamma);
+}
+
+static double
+sample_curve(const CogDrmColorConfig *config, unsigned channel, double x)
+{
+    const double   pos = x * (config->curve_size - 1);
+    const unsigned i = MIN((unsigned) pos, config->curve_size - 2);
+    const double   t = pos - i;
+    return config->curve[i * 3 + channel] * (1.0 - t) + config->curve[(i + 1) * 3 + channel] * t;
+}
+
+/*
+ * Fills a lookup table of the given size, with interleaved red, green, and
+ * blue values using the whole 16-bit range.
+ */
+void
+cog_drm_color_config_build_lut(const CogDrmColorConfig *config, unsigned size, uint16_t *lut)
+{
+    g_assert(config);
+    g_assert(size >= 2);
+    g_assert(lut);
+
+    for (unsigned i = 0; i < size; i++) {
+        const double x = (double) i / (size - 1);
+
+        for (unsigned channel = 0; channel < 3; channel++) {
+            double y;
+            if (config->curve)
+                y = sample_curve(config, channel, x);
+            else if (config->gsdf_min_luminance > 0.0)
+                y = gsdf_curve(config, x);
+            else
+                y = pow(x, config->gamma);
+
+            y = CLAMP(y * config->brightness, 0.0, 1.0);
+            lut[i * 3 + channel] = (uint16_t) lround(y * UINT16_MAX);
+        }
+    }
+}
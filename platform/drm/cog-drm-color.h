@@ -0,0 +1,57 @@
+/*
+ * cog-drm-color.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+    COG_DRM_COLOR_PIPELINE_AUTO = 0,
+    COG_DRM_COLOR_PIPELINE_KMS,
+    COG_DRM_COLOR_PIPELINE_SHADER,
+} CogDrmColorPipeline;
+
+/*
+ * Output color configuration. Values are transformed by the color matrix
+ * first, and then by a per-channel transfer curve, mirroring the order of
+ * the CTM and GAMMA_LUT stages of the KMS color pipeline. The curve is
+ * either loaded from a file, or computed from the rest of the settings.
+ */
+typedef struct {
+    CogDrmColorPipeline pipeline;
+
+    double brightness;  /* Scale applied to output values. */
+    double gamma;       /* Exponent of the transfer curve. */
+
+    /* Calibration to the DICOM Grayscale Standard Display Function. */
+    double gsdf_min_luminance; /* In cd/m², GSDF is disabled when zero. */
+    double gsdf_max_luminance;
+    double panel_gamma; /* Native response of the panel. */
+
+    /* Curve loaded from a file, with interleaved RGB values. */
+    double  *curve;
+    unsigned curve_size;
+
+    bool   has_ctm;
+    double ctm[9]; /* Row-major. */
+} CogDrmColorConfig;
+
+extern const char *const cog_drm_color_config_keys[];
+
+void cog_drm_color_config_init(CogDrmColorConfig *config);
+void cog_drm_color_config_clear(CogDrmColorConfig *config);
+bool cog_drm_color_config_set(CogDrmColorConfig *config, const char *key, const char *value, GError **error);
+
+bool cog_drm_color_config_has_curve(const CogDrmColorConfig *config);
+bool cog_drm_color_config_is_identity(const CogDrmColorConfig *config);
+void cog_drm_color_config_build_lut(const CogDrmColorConfig *config, unsigned size, uint16_t *lut);
+
+G_END_DECLS
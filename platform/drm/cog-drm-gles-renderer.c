@@ -14,6 +14,7 @@
 #include <errno.h>
 #include <gbm.h>
 #include <glib-unix.h>
+#include <string.h>
 #include <wayland-util.h>
 #include <wpe/fdo-egl.h>
 #include <wpe/fdo.h>
@@ -40,6 +41,8 @@ typedef struct {
     uint32_t width, height;
 
     CogGLRendererRotation rotation;
+    CogGLRendererScaling  scaling;
+    CogGLRendererFilter   filter;
 
     EGLDisplay egl_display;
     EGLConfig  egl_config;
@@ -48,6 +51,15 @@ typedef struct {
 
     CogGLRenderer gl_render;
 
+    /* Color transform to apply once the EGL context is active. */
+    struct {
+        uint16_t *lut;
+        unsigned  lut_size;
+        float     ctm[9];
+        bool      has_ctm;
+        bool      pending;
+    } color;
+
     struct wpe_view_backend_exportable_fdo *exportable;
 
     drmEventContext drm_context;
@@ -59,34 +71,230 @@ typedef struct {
     bool            mode_set;
     bool            atomic_modesetting;
 
+    /* Mode with a different size, applied once the pending flip is done. */
+    drmModeModeInfo pending_mode;
+    bool            has_pending_mode;
+
+    /* Framebuffer from before a mode switch, still shown until replaced. */
+    uint32_t retired_fb_id;
+
+    /* Completes dropped frames at the refresh rate, see drop_frame below. */
+    guint dropped_frame_source;
+
+    /* Boot splash which the first frames fade in over, see paint below. */
+    struct {
+        EGLImage                           image;
+        int64_t                            start_time;
+        struct wpe_fdo_egl_exported_image *frame;
+    } splash;
+
     struct {
         drmModeObjectProperties *props;
         drmModePropertyRes     **props_info;
     } connector_props, crtc_props, plane_props;
 } CogDrmGlesRenderer;
 
+#define SPLASH_FADE_DURATION (250 * G_TIME_SPAN_MILLISECOND)
+
+/* Creates the GBM and EGL surfaces used for output, sized after the mode. */
+static bool
+cog_drm_gles_renderer_create_surface(CogDrmGlesRenderer *self, GError **error)
+{
+    if (!(self->gbm_surface = gbm_surface_create(self->gbm_device, self->mode.hdisplay, self->mode.vdisplay,
+                                                 self->gbm_format, GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING))) {
+        g_set_error(error, COG_PLATFORM_WPE_ERROR, COG_PLATFORM_WPE_ERROR_INIT,
+                    "Cannot create GBM surface for output rendering (%s)", g_strerror(errno));
+        return false;
+    }
+
+    if (epoxy_has_egl_extension(self->egl_display, "EGL_MESA_platform_gbm")) {
+        self->egl_surface =
+            eglCreatePlatformWindowSurfaceEXT(self->egl_display, self->egl_config, self->gbm_surface, NULL);
+    } else {
+        self->egl_surface =
+            eglCreateWindowSurface(self->egl_display, self->egl_config, (EGLNativeWindowType) self->gbm_surface, NULL);
+    }
+    if (!self->egl_surface) {
+        g_set_error(error, COG_PLATFORM_EGL_ERROR, eglGetError(), "Cannot create EGL window surface");
+        return false;
+    }
+
+    return true;
+}
+
 static void
-cog_drm_gles_renderer_handle_egl_image(void *data, struct wpe_fdo_egl_exported_image *image)
+cog_drm_gles_renderer_release_bo(CogDrmGlesRenderer *self, struct gbm_bo **bo)
+{
+    if (*bo) {
+        uint32_t fb_id = GPOINTER_TO_INT(gbm_bo_get_user_data(*bo));
+        drmModeRmFB(gbm_device_get_fd(self->gbm_device), fb_id);
+        gbm_surface_release_buffer(self->gbm_surface, *bo);
+        *bo = NULL;
+    }
+}
+
+static void
+cog_drm_gles_renderer_remove_retired_fb(CogDrmGlesRenderer *self)
+{
+    if (self->retired_fb_id) {
+        drmModeRmFB(gbm_device_get_fd(self->gbm_device), self->retired_fb_id);
+        self->retired_fb_id = 0;
+    }
+}
+
+static void
+cog_drm_gles_renderer_clear_splash(CogDrmGlesRenderer *self)
+{
+    if (self->splash.image == EGL_NO_IMAGE)
+        return;
+
+    eglDestroyImageKHR(self->egl_display, self->splash.image);
+    self->splash.image = EGL_NO_IMAGE;
+
+    /* The texture cache would otherwise keep the splash buffer alive. */
+    cog_gl_renderer_invalidate_textures(&self->gl_render);
+
+    if (self->splash.frame) {
+        wpe_view_backend_exportable_fdo_egl_dispatch_release_exported_image(self->exportable, self->splash.frame);
+        self->splash.frame = NULL;
+    }
+}
+
+/*
+ * Switches to a mode with a different size, which needs new output surfaces.
+ * Must not be called while a page flip is pending.
+ */
+static void
+cog_drm_gles_renderer_apply_pending_mode(CogDrmGlesRenderer *self)
+{
+    g_assert(self->has_pending_mode);
+    g_assert(!self->next_bo);
+
+    self->has_pending_mode = false;
+    self->mode = self->pending_mode;
+    self->mode_set = false;
+
+    /* The splash matched the previous mode, it would be shown scaled now. */
+    cog_drm_gles_renderer_clear_splash(self);
+
+    eglMakeCurrent(self->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    /*
+     * The frame being shown goes away along with the surface, but removing
+     * its framebuffer would blank the output until the first frame in the
+     * new mode is shown. The framebuffer keeps the memory alive meanwhile.
+     */
+    if (self->current_bo) {
+        cog_drm_gles_renderer_remove_retired_fb(self);
+        self->retired_fb_id = GPOINTER_TO_INT(gbm_bo_get_user_data(self->current_bo));
+        gbm_surface_release_buffer(self->gbm_surface, self->current_bo);
+        self->current_bo = NULL;
+    }
+
+    if (self->egl_surface != EGL_NO_SURFACE) {
+        eglDestroySurface(self->egl_display, self->egl_surface);
+        self->egl_surface = EGL_NO_SURFACE;
+    }
+    g_clear_pointer(&self->gbm_surface, gbm_surface_destroy);
+
+    g_autoptr(GError) error = NULL;
+    if (!cog_drm_gles_renderer_create_surface(self, &error))
+        g_critical("%s: %s", __func__, error->message);
+
+    /* The web process reallocates its buffers for the new output size. */
+    cog_gl_renderer_invalidate_textures(&self->gl_render);
+}
+
+static gboolean
+cog_drm_gles_renderer_complete_dropped_frame(void *data)
 {
     CogDrmGlesRenderer *self = data;
+    self->dropped_frame_source = 0;
+    wpe_view_backend_exportable_fdo_dispatch_frame_complete(self->exportable);
+    return G_SOURCE_REMOVE;
+}
 
+static void
+cog_drm_gles_renderer_paint(CogDrmGlesRenderer *self, struct wpe_fdo_egl_exported_image *image)
+{
     if (!eglMakeCurrent(self->egl_display, self->egl_surface, self->egl_surface, self->egl_context)) {
         g_critical("%s: Cannot activate EGL context for rendering (%#04x)", __func__, eglGetError());
         return;
     }
 
+    if (G_UNLIKELY(self->color.pending)) {
+        g_autoptr(GError) error = NULL;
+        if (!cog_gl_renderer_set_color_transform(&self->gl_render, self->color.lut, self->color.lut_size,
+                                                 self->color.has_ctm ? self->color.ctm : NULL, &error))
+            g_warning("%s: Cannot apply color transform: %s", __func__, error->message);
+        self->color.pending = false;
+    }
+
+    /* Size of the image once rotated, as it will be shown on the output. */
+    uint32_t image_width = wpe_fdo_egl_exported_image_get_width(image);
+    uint32_t image_height = wpe_fdo_egl_exported_image_get_height(image);
+    if (self->rotation == COG_GL_RENDERER_ROTATION_90 || self->rotation == COG_GL_RENDERER_ROTATION_270) {
+        uint32_t tmp = image_width;
+        image_width = image_height;
+        image_height = tmp;
+    }
+
+    CogGLRendererLayer layers[2];
+    unsigned           n_layers = 0;
+    float              opacity = 1.0f;
+
+    /*
+     * The splash already matches the output (rotation and scaling included)
+     * and goes below the frame, which becomes opaque as the fade progresses.
+     */
+    if (G_UNLIKELY(self->splash.image != EGL_NO_IMAGE)) {
+        const int64_t now = g_get_monotonic_time();
+        if (!self->splash.start_time)
+            self->splash.start_time = now;
+        opacity = MIN((float) (now - self->splash.start_time) / SPLASH_FADE_DURATION, 1.0f);
+
+        layers[n_layers++] = (CogGLRendererLayer){
+            .image = self->splash.image,
+            .dst = {0, 0, self->mode.hdisplay, self->mode.vdisplay},
+            .opacity = 1.0f,
+            .rotation = COG_GL_RENDERER_ROTATION_0,
+            .filter = COG_GL_RENDERER_FILTER_NEAREST,
+        };
+    }
+
+    EGLImage egl_image = wpe_fdo_egl_exported_image_get_egl_image(image);
+    cog_gl_renderer_import_image(&self->gl_render, egl_image);
+
+    CogGLRendererLayer *layer = &layers[n_layers++];
+    *layer = (CogGLRendererLayer){
+        .image = egl_image,
+        .opacity = opacity,
+        .rotation = self->rotation,
+        .filter = self->filter,
+    };
+    cog_gl_renderer_fit_rect(self->scaling, image_width, image_height, self->mode.hdisplay, self->mode.vdisplay,
+                             &layer->dst);
+
+    /* Sampling is pixel-exact when there is no scaling involved. */
+    if (layer->dst.width == image_width && layer->dst.height == image_height)
+        layer->filter = COG_GL_RENDERER_FILTER_NEAREST;
+
     glViewport(0, 0, self->mode.hdisplay, self->mode.vdisplay);
     glClearColor(0, 0, 0, 0);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    cog_gl_renderer_paint(&self->gl_render, wpe_fdo_egl_exported_image_get_egl_image(image), self->rotation);
+    cog_gl_renderer_paint_layers(&self->gl_render, layers, n_layers, self->mode.hdisplay, self->mode.vdisplay);
 
     if (G_UNLIKELY(!eglSwapBuffers(self->egl_display, self->egl_surface))) {
         g_critical("%s: eglSwapBuffers failed (%#04x)", __func__, eglGetError());
         return;
     }
 
-    wpe_view_backend_exportable_fdo_egl_dispatch_release_exported_image(self->exportable, image);
+    /* While fading the frame is kept, to be painted again on the next flip. */
+    if (G_LIKELY(self->splash.image == EGL_NO_IMAGE))
+        wpe_view_backend_exportable_fdo_egl_dispatch_release_exported_image(self->exportable, image);
+    else if (opacity >= 1.0f)
+        cog_drm_gles_renderer_clear_splash(self);
 
     int drm_fd = gbm_device_get_fd(self->gbm_device);
 
@@ -134,7 +342,7 @@ cog_drm_gles_renderer_handle_egl_image(void *data, struct wpe_fdo_egl_exported_i
         int ret = drmModeSetCrtc(drm_fd, self->crtc_id, fb_id, 0, 0, &self->connector_id, 1, &self->mode);
         if (ret) {
             g_warning("%s: Cannot set mode (%s)", __func__, g_strerror(errno));
-            return;
+            goto drop_frame;
         }
         self->mode_set = true;
     }
@@ -143,22 +351,65 @@ cog_drm_gles_renderer_handle_egl_image(void *data, struct wpe_fdo_egl_exported_i
 
     if (drmModePageFlip(drm_fd, self->crtc_id, fb_id, DRM_MODE_PAGE_FLIP_EVENT, self)) {
         g_warning("%s: Cannot schedule page flip (%s)", __func__, g_strerror(errno));
-        return;
+        self->next_bo = NULL;
+        goto drop_frame;
+    }
+    return;
+
+drop_frame:
+    /*
+     * Typically the output went away. Drop the frame instead of stalling
+     * the web view, and redo the modeset along the next one. Completing the
+     * frame right away would make WebKit render the next one immediately,
+     * so it is delayed by a refresh period to keep the usual pace.
+     */
+    self->mode_set = false;
+    cog_drm_gles_renderer_release_bo(self, &bo);
+    if (G_UNLIKELY(self->has_pending_mode))
+        cog_drm_gles_renderer_apply_pending_mode(self);
+    if (!self->dropped_frame_source) {
+        const unsigned refresh = self->mode.vrefresh ? self->mode.vrefresh : 60;
+        self->dropped_frame_source =
+            g_timeout_add(MAX(1000 / refresh, 1), cog_drm_gles_renderer_complete_dropped_frame, self);
     }
 }
 
 static void
-cog_drm_gles_renderer_handle_page_flip(int fd, unsigned frame, unsigned sec, unsigned usec, void *data)
+cog_drm_gles_renderer_handle_egl_image(void *data, struct wpe_fdo_egl_exported_image *image)
 {
     CogDrmGlesRenderer *self = data;
 
-    if (self->current_bo) {
-        uint32_t fb_id = GPOINTER_TO_INT(gbm_bo_get_user_data(self->current_bo));
-        drmModeRmFB(gbm_device_get_fd(self->gbm_device), fb_id);
-        gbm_surface_release_buffer(self->gbm_surface, self->current_bo);
+    cog_trace_record(COG_TRACE_FRAME_EXPORT, 0);
+
+    if (G_UNLIKELY(self->splash.image != EGL_NO_IMAGE)) {
+        /* Only the latest frame is kept; it gets painted when the pending flip is done. */
+        if (self->splash.frame)
+            wpe_view_backend_exportable_fdo_egl_dispatch_release_exported_image(self->exportable, self->splash.frame);
+        self->splash.frame = image;
+        if (self->next_bo)
+            return;
     }
+
+    cog_drm_gles_renderer_paint(self, image);
+}
+
+static void
+cog_drm_gles_renderer_handle_page_flip(int fd, unsigned frame, unsigned sec, unsigned usec, void *data)
+{
+    CogDrmGlesRenderer *self = data;
+
+    cog_drm_gles_renderer_release_bo(self, &self->current_bo);
+    cog_drm_gles_renderer_remove_retired_fb(self);
     self->current_bo = g_steal_pointer(&self->next_bo);
 
+    if (G_UNLIKELY(self->has_pending_mode))
+        cog_drm_gles_renderer_apply_pending_mode(self);
+
+    /* Keep fading at the refresh rate, even if WebKit does not produce new frames. */
+    if (G_UNLIKELY(self->splash.frame))
+        cog_drm_gles_renderer_paint(self, self->splash.frame);
+
+    cog_drm_renderer_notify_presented(&self->base, sec, usec);
     wpe_view_backend_exportable_fdo_dispatch_frame_complete(self->exportable);
 }
 
@@ -275,24 +526,8 @@ cog_drm_gles_renderer_initialize(CogDrmRenderer *renderer, GError **error)
         return false;
     }
 
-    if (!(self->gbm_surface = gbm_surface_create(self->gbm_device, self->mode.hdisplay, self->mode.vdisplay,
-                                                 self->gbm_format, GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING))) {
-        g_set_error(error, COG_PLATFORM_WPE_ERROR, COG_PLATFORM_WPE_ERROR_INIT,
-                    "Cannot create GBM surface for output rendering (%s)", g_strerror(errno));
+    if (!cog_drm_gles_renderer_create_surface(self, error))
         return false;
-    }
-
-    if (epoxy_has_egl_extension(self->egl_display, "EGL_MESA_platform_gbm")) {
-        self->egl_surface =
-            eglCreatePlatformWindowSurfaceEXT(self->egl_display, self->egl_config, self->gbm_surface, NULL);
-    } else {
-        self->egl_surface =
-            eglCreateWindowSurface(self->egl_display, self->egl_config, (EGLNativeWindowType) self->gbm_surface, NULL);
-    }
-    if (!self->egl_surface) {
-        g_set_error(error, COG_PLATFORM_EGL_ERROR, eglGetError(), "Cannot create EGL window surface");
-        return false;
-    }
 
     /* An active context is needed in order to initialize the renderer. */
     if (!eglMakeCurrent(self->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, self->egl_context)) {
@@ -317,6 +552,9 @@ cog_drm_gles_renderer_destroy(CogDrmRenderer *renderer)
     CogDrmGlesRenderer *self = wl_container_of(renderer, self, base);
 
     g_clear_handle_id(&self->drm_fd_source, g_source_remove);
+    g_clear_handle_id(&self->dropped_frame_source, g_source_remove);
+    cog_drm_gles_renderer_remove_retired_fb(self);
+    cog_drm_gles_renderer_clear_splash(self);
 
     if (self->egl_surface != EGL_NO_SURFACE) {
         eglDestroySurface(self->egl_display, self->egl_surface);
@@ -324,6 +562,7 @@ cog_drm_gles_renderer_destroy(CogDrmRenderer *renderer)
     }
 
     cog_gl_renderer_finalize(&self->gl_render);
+    g_clear_pointer(&self->color.lut, g_free);
 
     g_clear_pointer(&self->gbm_surface, gbm_surface_destroy);
 
@@ -368,6 +607,9 @@ cog_drm_gles_renderer_set_rotation(CogDrmRenderer *renderer, CogGLRendererRotati
     self->rotation = rotation;
 
     if (self->exportable) {
+        /* Buffers will be reallocated with the new size. */
+        cog_gl_renderer_invalidate_textures(&self->gl_render);
+
         uint32_t width, height;
         cog_drm_gles_renderer_transformed_logical_size(self, &width, &height);
         wpe_view_backend_dispatch_set_size(wpe_view_backend_exportable_fdo_get_view_backend(self->exportable), width,
@@ -376,6 +618,99 @@ cog_drm_gles_renderer_set_rotation(CogDrmRenderer *renderer, CogGLRendererRotati
     return true;
 }
 
+static bool
+cog_drm_gles_renderer_set_scaling(CogDrmRenderer      *renderer,
+                                  CogGLRendererScaling scaling,
+                                  CogGLRendererFilter  filter,
+                                  bool                 apply)
+{
+    const bool supported = (scaling == COG_GL_RENDERER_SCALING_NONE || scaling == COG_GL_RENDERER_SCALING_STRETCH ||
+                            scaling == COG_GL_RENDERER_SCALING_FIT) &&
+                           (filter == COG_GL_RENDERER_FILTER_NEAREST || filter == COG_GL_RENDERER_FILTER_LINEAR);
+
+    if (!apply || !supported)
+        return supported;
+
+    CogDrmGlesRenderer *self = wl_container_of(renderer, self, base);
+    self->scaling = scaling;
+    self->filter = filter;
+    return true;
+}
+
+static bool
+cog_drm_gles_renderer_set_color_transform(CogDrmRenderer *renderer,
+                                          const uint16_t *lut,
+                                          unsigned        lut_size,
+                                          const float    *ctm,
+                                          bool            apply)
+{
+    if (!apply)
+        return true;
+
+    CogDrmGlesRenderer *self = wl_container_of(renderer, self, base);
+
+    g_clear_pointer(&self->color.lut, g_free);
+    if (lut) {
+        self->color.lut = g_new(uint16_t, lut_size * 3);
+        memcpy(self->color.lut, lut, lut_size * 3 * sizeof(uint16_t));
+        self->color.lut_size = lut_size;
+    }
+
+    if ((self->color.has_ctm = !!ctm))
+        memcpy(self->color.ctm, ctm, sizeof(self->color.ctm));
+
+    self->color.pending = true;
+    return true;
+}
+
+static bool
+cog_drm_gles_renderer_set_mode(CogDrmRenderer        *renderer,
+                               const drmModeModeInfo *mode,
+                               uint32_t               width,
+                               uint32_t               height,
+                               bool                   apply)
+{
+    if (!apply)
+        return true;
+
+    CogDrmGlesRenderer *self = wl_container_of(renderer, self, base);
+
+    if (mode->hdisplay == self->mode.hdisplay && mode->vdisplay == self->mode.vdisplay) {
+        /* Same size: reuse the frame being shown, if any, to switch right away. */
+        self->has_pending_mode = false;
+        self->mode = *mode;
+        self->mode_set = false;
+        if (self->current_bo && !self->next_bo) {
+            uint32_t fb_id = GPOINTER_TO_INT(gbm_bo_get_user_data(self->current_bo));
+            if (drmModeSetCrtc(gbm_device_get_fd(self->gbm_device), self->crtc_id, fb_id, 0, 0, &self->connector_id,
+                               1, &self->mode)) {
+                g_warning("%s: Cannot set mode (%s)", __func__, g_strerror(errno));
+                return false;
+            }
+            self->mode_set = true;
+        }
+    } else {
+        self->pending_mode = *mode;
+        self->has_pending_mode = true;
+        if (!self->next_bo)
+            cog_drm_gles_renderer_apply_pending_mode(self);
+    }
+
+    if (width == self->width && height == self->height)
+        return true;
+
+    self->width = width;
+    self->height = height;
+
+    if (self->exportable) {
+        cog_gl_renderer_invalidate_textures(&self->gl_render);
+        cog_drm_gles_renderer_transformed_logical_size(self, &width, &height);
+        wpe_view_backend_dispatch_set_size(wpe_view_backend_exportable_fdo_get_view_backend(self->exportable), width,
+                                           height);
+    }
+    return true;
+}
+
 static struct wpe_view_backend_exportable_fdo *
 cog_drm_gles_renderer_create_exportable(CogDrmRenderer *renderer, uint32_t width, uint32_t height)
 {
@@ -391,6 +726,49 @@ cog_drm_gles_renderer_create_exportable(CogDrmRenderer *renderer, uint32_t width
     return (self->exportable = wpe_view_backend_exportable_fdo_egl_create(&client, renderer, width, height));
 }
 
+static bool
+cog_drm_gles_renderer_set_splash(CogDrmRenderer *renderer,
+                                 int             dmabuf_fd,
+                                 uint32_t        width,
+                                 uint32_t        height,
+                                 uint32_t        stride,
+                                 uint32_t        format)
+{
+    CogDrmGlesRenderer *self = wl_container_of(renderer, self, base);
+
+    if (width != self->mode.hdisplay || height != self->mode.vdisplay ||
+        !epoxy_has_egl_extension(self->egl_display, "EGL_EXT_image_dma_buf_import"))
+        return false;
+
+    /* clang-format off */
+    const EGLint attribs[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_LINUX_DRM_FOURCC_EXT, format,
+        EGL_DMA_BUF_PLANE0_FD_EXT, dmabuf_fd,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT, 0,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, stride,
+        EGL_NONE,
+    };
+    /* clang-format on */
+
+    cog_drm_gles_renderer_clear_splash(self);
+    self->splash.image = eglCreateImageKHR(self->egl_display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+    if (self->splash.image == EGL_NO_IMAGE) {
+        g_warning("%s: Cannot import splash buffer (%#04x)", __func__, eglGetError());
+        return false;
+    }
+    self->splash.start_time = 0;
+    return true;
+}
+
+static struct gbm_bo *
+cog_drm_gles_renderer_get_front_buffer(CogDrmRenderer *renderer)
+{
+    CogDrmGlesRenderer *self = wl_container_of(renderer, self, base);
+    return self->current_bo;
+}
+
 CogDrmRenderer *
 cog_drm_gles_renderer_new(struct gbm_device     *gbm_device,
                           EGLDisplay             egl_display,
@@ -409,14 +787,22 @@ cog_drm_gles_renderer_new(struct gbm_device     *gbm_device,
         .base.initialize = cog_drm_gles_renderer_initialize,
         .base.destroy = cog_drm_gles_renderer_destroy,
         .base.set_rotation = cog_drm_gles_renderer_set_rotation,
+        .base.set_scaling = cog_drm_gles_renderer_set_scaling,
+        .base.set_color_transform = cog_drm_gles_renderer_set_color_transform,
+        .base.set_mode = cog_drm_gles_renderer_set_mode,
+        .base.set_splash = cog_drm_gles_renderer_set_splash,
         .base.create_exportable = cog_drm_gles_renderer_create_exportable,
+        .base.get_front_buffer = cog_drm_gles_renderer_get_front_buffer,
 
         .rotation = COG_GL_RENDERER_ROTATION_0,
+        .scaling = COG_GL_RENDERER_SCALING_FIT,
+        .filter = COG_GL_RENDERER_FILTER_LINEAR,
 
         .gbm_device = gbm_device,
         .egl_display = egl_display,
         .egl_context = EGL_NO_CONTEXT,
         .egl_surface = EGL_NO_SURFACE,
+        .splash.image = EGL_NO_IMAGE,
 
         .drm_context.version = DRM_EVENT_CONTEXT_VERSION,
         .drm_context.page_flip_handler = cog_drm_gles_renderer_handle_page_flip,
@@ -0,0 +1,213 @@
+/*
+ * cog-drm-mode.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-drm-mode.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+const char *const cog_drm_mode_config_keys[] = {
+    "connector",
+    "mode",
+    "mode-policy",
+    "mode-max",
+    NULL,
+};
+
+/* clang-format off */
+static const struct {
+    CogDrmModePolicy policy;
+    const char      *name;
+} s_policies[] = {
+    { COG_DRM_MODE_POLICY_PREFERRED,       "preferred"       },
+    { COG_DRM_MODE_POLICY_HIGHEST_REFRESH, "highest-refresh" },
+    { COG_DRM_MODE_POLICY_LARGEST,         "largest"         },
+};
+
+/* Same names as used by the kernel, indexed by DRM_MODE_CONNECTOR_*. */
+static const char *const s_connector_types[] = {
+    "Unknown", "VGA", "DVI-I", "DVI-D", "DVI-A", "Composite", "SVIDEO",
+    "LVDS", "Component", "DIN", "DP", "HDMI-A", "HDMI-B", "TV", "eDP",
+    "Virtual", "DSI", "DPI", "Writeback", "SPI", "USB",
+};
+/* clang-format on */
+
+void
+cog_drm_mode_config_init(CogDrmModeConfig *config)
+{
+    *config = (CogDrmModeConfig){
+        .policy = COG_DRM_MODE_POLICY_PREFERRED,
+    };
+
+    /* Kept for backwards compatibility. */
+    config->mode_name = g_strdup(g_getenv("COG_PLATFORM_DRM_VIDEO_MODE"));
+
+    const char *mode_max = g_getenv("COG_PLATFORM_DRM_MODE_MAX");
+    if (mode_max && !cog_drm_mode_spec_parse(mode_max, &config->max))
+        g_warning("Invalid value '%s' for COG_PLATFORM_DRM_MODE_MAX.", mode_max);
+}
+
+void
+cog_drm_mode_config_clear(CogDrmModeConfig *config)
+{
+    g_clear_pointer(&config->connector, g_free);
+    g_clear_pointer(&config->mode_name, g_free);
+}
+
+bool
+cog_drm_mode_config_set(CogDrmModeConfig *config, const char *key, const char *value, GError **error)
+{
+    g_assert(config);
+    g_assert(key);
+    g_assert(value);
+
+    if (g_str_equal(key, "connector")) {
+        g_free(config->connector);
+        config->connector = g_strdup(value);
+    } else if (g_str_equal(key, "mode")) {
+        if (!cog_drm_mode_spec_parse(value, &config->mode))
+            goto invalid_value;
+        g_clear_pointer(&config->mode_name, g_free);
+    } else if (g_str_equal(key, "mode-max")) {
+        if (!cog_drm_mode_spec_parse(value, &config->max))
+            goto invalid_value;
+    } else if (g_str_equal(key, "mode-policy")) {
+        unsigned i;
+        for (i = 0; i < G_N_ELEMENTS(s_policies); i++) {
+            if (g_str_equal(value, s_policies[i].name)) {
+                config->policy = s_policies[i].policy;
+                break;
+            }
+        }
+        if (i == G_N_ELEMENTS(s_policies))
+            goto invalid_value;
+    } else {
+        g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND, "Unknown mode setting '%s'", key);
+        return false;
+    }
+
+    return true;
+
+invalid_value:
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE, "Invalid value '%s' for '%s'", value, key);
+    return false;
+}
+
+bool
+cog_drm_mode_spec_parse(const char *str, CogDrmModeSpec *spec)
+{
+    unsigned w = 0, h = 0, r = 0;
+    char     tail;
+
+    if (!str)
+        return false;
+
+    int n = sscanf(str, "%ux%u@%u%c", &w, &h, &r, &tail);
+    if (n != 3 && (n != 2 || strchr(str, '@') || sscanf(str, "%ux%u%c", &w, &h, &tail) != 2))
+        return false;
+    if (!w || !h)
+        return false;
+
+    *spec = (CogDrmModeSpec){w, h, r};
+    return true;
+}
+
+char *
+cog_drm_mode_connector_name(const drmModeConnector *connector)
+{
+    const char *type = (connector->connector_type < G_N_ELEMENTS(s_connector_types))
+                           ? s_connector_types[connector->connector_type]
+                           : s_connector_types[0];
+    return g_strdup_printf("%s-%" PRIu32, type, connector->connector_type_id);
+}
+
+static inline bool
+mode_matches(const drmModeModeInfo *mode, const CogDrmModeSpec *spec)
+{
+    return mode->hdisplay == spec->width && mode->vdisplay == spec->height &&
+           (!spec->refresh || mode->vrefresh == spec->refresh);
+}
+
+static inline bool
+mode_within(const drmModeModeInfo *mode, const CogDrmModeSpec *max)
+{
+    return (!max->width || mode->hdisplay <= max->width) && (!max->height || mode->vdisplay <= max->height) &&
+           (!max->refresh || mode->vrefresh <= max->refresh);
+}
+
+/* Whether the policy ranks mode "a" above mode "b". */
+static bool
+mode_is_better(CogDrmModePolicy policy, const drmModeModeInfo *a, const drmModeModeInfo *b)
+{
+    if (!b)
+        return true;
+
+    const uint32_t area_a = (uint32_t) a->hdisplay * a->vdisplay;
+    const uint32_t area_b = (uint32_t) b->hdisplay * b->vdisplay;
+
+    switch (policy) {
+    case COG_DRM_MODE_POLICY_PREFERRED:
+        if ((a->type & DRM_MODE_TYPE_PREFERRED) != (b->type & DRM_MODE_TYPE_PREFERRED))
+            return a->type & DRM_MODE_TYPE_PREFERRED;
+        if (area_a != area_b)
+            return area_a > area_b;
+        return a->vrefresh > b->vrefresh;
+    case COG_DRM_MODE_POLICY_HIGHEST_REFRESH:
+        if (a->vrefresh != b->vrefresh)
+            return a->vrefresh > b->vrefresh;
+        return area_a > area_b;
+    case COG_DRM_MODE_POLICY_LARGEST:
+        if (area_a != area_b)
+            return area_a > area_b;
+        return a->vrefresh > b->vrefresh;
+    }
+
+    g_assert_not_reached();
+}
+
+/*
+ * Finds the mode matching the size, and refresh rate if given, of a mode
+ * specification. Ties are broken according to the policy.
+ */
+drmModeModeInfo *
+cog_drm_mode_find(const drmModeConnector *connector, CogDrmModePolicy policy, const CogDrmModeSpec *spec)
+{
+    drmModeModeInfo *best = NULL;
+    for (int i = 0; i < connector->count_modes; i++) {
+        drmModeModeInfo *mode = &connector->modes[i];
+        if (mode_matches(mode, spec) && mode_is_better(policy, mode, best))
+            best = mode;
+    }
+    return best;
+}
+
+drmModeModeInfo *
+cog_drm_mode_select(const CogDrmModeConfig *config, const drmModeConnector *connector)
+{
+    drmModeModeInfo *best = NULL;
+
+    if (config->mode_name) {
+        for (int i = 0; i < connector->count_modes; i++) {
+            if (strcmp(config->mode_name, connector->modes[i].name) == 0)
+                return &connector->modes[i];
+        }
+        g_warning("No video mode named '%s', ignoring.", config->mode_name);
+    } else if (config->mode.width) {
+        if ((best = cog_drm_mode_find(connector, config->policy, &config->mode)))
+            return best;
+        g_warning("No video mode matches %" PRIu32 "x%" PRIu32 "@%" PRIu32 ", ignoring.", config->mode.width,
+                  config->mode.height, config->mode.refresh);
+    }
+
+    for (int i = 0; i < connector->count_modes; i++) {
+        drmModeModeInfo *mode = &connector->modes[i];
+        if (mode_within(mode, &config->max) && mode_is_better(config->policy, mode, best))
+            best = mode;
+    }
+    return best;
+}
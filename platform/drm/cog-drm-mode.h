@@ -0,0 +1,57 @@
+/*
+ * cog-drm-mode.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xf86drmMode.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+    COG_DRM_MODE_POLICY_PREFERRED = 0,
+    COG_DRM_MODE_POLICY_HIGHEST_REFRESH,
+    COG_DRM_MODE_POLICY_LARGEST,
+} CogDrmModePolicy;
+
+/* Mode in "WxH" or "WxH@R" format, with zero meaning "any". */
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t refresh;
+} CogDrmModeSpec;
+
+/*
+ * Video mode selection. An explicit mode takes precedence, and otherwise the
+ * policy picks among the modes within the limits. When no mode matches the
+ * explicit mode, selection falls back to the policy.
+ */
+typedef struct {
+    CogDrmModePolicy policy;
+    char            *connector; /* Connector name (e.g. "HDMI-A-1"). */
+    char            *mode_name; /* Exact mode name, from the environment. */
+    CogDrmModeSpec   mode;
+    CogDrmModeSpec   max;
+} CogDrmModeConfig;
+
+extern const char *const cog_drm_mode_config_keys[];
+
+void cog_drm_mode_config_init(CogDrmModeConfig *config);
+void cog_drm_mode_config_clear(CogDrmModeConfig *config);
+bool cog_drm_mode_config_set(CogDrmModeConfig *config, const char *key, const char *value, GError **error);
+
+bool  cog_drm_mode_spec_parse(const char *str, CogDrmModeSpec *spec);
+char *cog_drm_mode_connector_name(const drmModeConnector *connector);
+
+drmModeModeInfo *cog_drm_mode_find(const drmModeConnector *connector,
+                                   CogDrmModePolicy        policy,
+                                   const CogDrmModeSpec   *spec);
+drmModeModeInfo *cog_drm_mode_select(const CogDrmModeConfig *config, const drmModeConnector *connector);
+
+G_END_DECLS
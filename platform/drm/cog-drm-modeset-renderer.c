@@ -102,6 +102,9 @@ typedef struct {
     bool            atomic_modesetting;
     bool            addfb2_modifiers;
 
+    /* Completes dropped frames at the refresh rate, see drm_commit_buffer(). */
+    guint dropped_frame_source;
+
     struct {
         drmModeObjectProperties *props;
         drmModePropertyRes     **props_info;
@@ -421,7 +424,11 @@ drm_commit_buffer_nonatomic(CogDrmModesetRenderer *self, struct buffer_object *b
     FlipHandlerData *data = g_slice_new(FlipHandlerData);
     *data = (FlipHandlerData){self, buffer};
 
-    return drmModePageFlip(get_drm_fd(self), self->crtc_id, buffer->fb_id, DRM_MODE_PAGE_FLIP_EVENT, data);
+    if (drmModePageFlip(get_drm_fd(self), self->crtc_id, buffer->fb_id, DRM_MODE_PAGE_FLIP_EVENT, data)) {
+        g_slice_free(FlipHandlerData, data);
+        return -1;
+    }
+    return 0;
 }
 
 static int
@@ -497,16 +504,23 @@ drm_commit_buffer_atomic(CogDrmModesetRenderer *self, struct buffer_object *buff
         self->mode_set = true;
     }
 
+    /*
+     * Buffers rendered before a mode change may not match the size of the
+     * new mode until the view is resized, show the area they have in common.
+     */
+    const uint32_t width = MIN(gbm_bo_get_width(buffer->bo), self->mode.hdisplay);
+    const uint32_t height = MIN(gbm_bo_get_height(buffer->bo), self->mode.vdisplay);
+
     ret |= add_plane_property(self, req, self->plane_id, "FB_ID", buffer->fb_id);
     ret |= add_plane_property(self, req, self->plane_id, "CRTC_ID", self->crtc_id);
     ret |= add_plane_property(self, req, self->plane_id, "SRC_X", 0);
     ret |= add_plane_property(self, req, self->plane_id, "SRC_Y", 0);
-    ret |= add_plane_property(self, req, self->plane_id, "SRC_W", ((uint64_t) self->mode.hdisplay) << 16);
-    ret |= add_plane_property(self, req, self->plane_id, "SRC_H", ((uint64_t) self->mode.vdisplay) << 16);
+    ret |= add_plane_property(self, req, self->plane_id, "SRC_W", ((uint64_t) width) << 16);
+    ret |= add_plane_property(self, req, self->plane_id, "SRC_H", ((uint64_t) height) << 16);
     ret |= add_plane_property(self, req, self->plane_id, "CRTC_X", 0);
     ret |= add_plane_property(self, req, self->plane_id, "CRTC_Y", 0);
-    ret |= add_plane_property(self, req, self->plane_id, "CRTC_W", self->mode.hdisplay);
-    ret |= add_plane_property(self, req, self->plane_id, "CRTC_H", self->mode.vdisplay);
+    ret |= add_plane_property(self, req, self->plane_id, "CRTC_W", width);
+    ret |= add_plane_property(self, req, self->plane_id, "CRTC_H", height);
     if (ret) {
         drmModeAtomicFree(req);
         return -1;
@@ -517,6 +531,7 @@ drm_commit_buffer_atomic(CogDrmModesetRenderer *self, struct buffer_object *buff
 
     ret = drmModeAtomicCommit(get_drm_fd(self), req, flags, data);
     if (ret) {
+        g_slice_free(FlipHandlerData, data);
         drmModeAtomicFree(req);
         return -1;
     }
@@ -525,6 +540,30 @@ drm_commit_buffer_atomic(CogDrmModesetRenderer *self, struct buffer_object *buff
     return 0;
 }
 
+static void
+drm_release_buffer_export(CogDrmModesetRenderer *self, struct buffer_object *buffer)
+{
+    if (buffer->export.resource) {
+        wpe_view_backend_exportable_fdo_dispatch_release_buffer(self->exportable, buffer->export.resource);
+        buffer->export.resource = NULL;
+    }
+
+    if (buffer->export.shm_buffer) {
+        wpe_view_backend_exportable_fdo_dispatch_release_shm_exported_buffer(self->exportable,
+                                                                             buffer->export.shm_buffer);
+        buffer->export.shm_buffer = NULL;
+    }
+}
+
+static gboolean
+drm_complete_dropped_frame(void *data)
+{
+    CogDrmModesetRenderer *self = data;
+    self->dropped_frame_source = 0;
+    wpe_view_backend_exportable_fdo_dispatch_frame_complete(self->exportable);
+    return G_SOURCE_REMOVE;
+}
+
 static void
 drm_commit_buffer(CogDrmModesetRenderer *self, struct buffer_object *buffer)
 {
@@ -534,15 +573,31 @@ drm_commit_buffer(CogDrmModesetRenderer *self, struct buffer_object *buffer)
     else
         ret = drm_commit_buffer_nonatomic(self, buffer);
 
-    if (ret)
+    if (ret) {
         g_warning("failed to schedule a page flip: %s", g_strerror(errno));
+
+        /*
+         * Typically the output went away. Drop the frame instead of stalling
+         * the web view, and redo the modeset along the next one. Completing
+         * the frame right away would make WebKit render the next one
+         * immediately, so it is delayed by a refresh period instead.
+         */
+        self->mode_set = false;
+        drm_release_buffer_export(self, buffer);
+        if (!self->dropped_frame_source) {
+            const unsigned refresh = self->mode.vrefresh ? self->mode.vrefresh : 60;
+            self->dropped_frame_source = g_timeout_add(MAX(1000 / refresh, 1), drm_complete_dropped_frame, self);
+        }
+    }
 }
 
 static void
 on_export_buffer_resource(void *data, struct wl_resource *buffer_resource)
 {
     CogDrmModesetRenderer *self = data;
-    struct buffer_object  *buffer = drm_buffer_for_resource(self, buffer_resource);
+    cog_trace_record(COG_TRACE_FRAME_EXPORT, 0);
+
+    struct buffer_object *buffer = drm_buffer_for_resource(self, buffer_resource);
     if (buffer) {
         buffer->export.resource = buffer_resource;
         drm_commit_buffer(self, buffer);
@@ -571,6 +626,7 @@ static void
 on_export_dmabuf_resource(void *data, struct wpe_view_backend_exportable_fdo_dmabuf_resource *dmabuf_resource)
 {
     CogDrmModesetRenderer *self = data;
+    cog_trace_record(COG_TRACE_FRAME_EXPORT, 0);
 
     struct buffer_object *buffer = drm_buffer_for_resource(self, dmabuf_resource->buffer_resource);
     if (buffer) {
@@ -640,22 +696,11 @@ drm_page_flip_handler(int fd, unsigned int frame, unsigned int sec, unsigned int
     struct buffer_object  *buffer = ((FlipHandlerData *) data)->buffer;
     g_slice_free(FlipHandlerData, data);
 
-    if (self->committed_buffer) {
-        struct buffer_object *buffer = self->committed_buffer;
-
-        if (buffer->export.resource) {
-            wpe_view_backend_exportable_fdo_dispatch_release_buffer(self->exportable, buffer->export.resource);
-            buffer->export.resource = NULL;
-        }
-
-        if (buffer->export.shm_buffer) {
-            wpe_view_backend_exportable_fdo_dispatch_release_shm_exported_buffer(self->exportable,
-                                                                                 buffer->export.shm_buffer);
-            buffer->export.shm_buffer = NULL;
-        }
-    }
+    if (self->committed_buffer)
+        drm_release_buffer_export(self, self->committed_buffer);
 
     self->committed_buffer = buffer;
+    cog_drm_renderer_notify_presented(&self->base, sec, usec);
     wpe_view_backend_exportable_fdo_dispatch_frame_complete(self->exportable);
 }
 
@@ -674,6 +719,8 @@ cog_drm_modeset_renderer_destroy(CogDrmRenderer *renderer)
 {
     CogDrmModesetRenderer *self = wl_container_of(renderer, self, base);
 
+    g_clear_handle_id(&self->dropped_frame_source, g_source_remove);
+
     struct buffer_object *buffer, *tmp;
     wl_list_for_each_safe(buffer, tmp, &self->buffer_list, link) {
         wl_list_remove(&buffer->link);
@@ -709,6 +756,58 @@ cog_drm_modeset_renderer_destroy(CogDrmRenderer *renderer)
     g_slice_free(CogDrmModesetRenderer, self);
 }
 
+static bool
+cog_drm_modeset_renderer_set_mode(CogDrmRenderer        *renderer,
+                                  const drmModeModeInfo *mode,
+                                  uint32_t               width,
+                                  uint32_t               height,
+                                  bool                   apply)
+{
+    if (!apply)
+        return true;
+
+    CogDrmModesetRenderer *self = wl_container_of(renderer, self, base);
+
+    const bool same_size = (mode->hdisplay == self->mode.hdisplay && mode->vdisplay == self->mode.vdisplay);
+    memcpy(&self->mode, mode, sizeof(drmModeModeInfo));
+    self->mode_set = false;
+
+    /*
+     * With the same size the buffer being shown can be reused to switch right
+     * away, otherwise the mode is set along the first buffer of the new size.
+     */
+    if (same_size && self->committed_buffer) {
+        int ret;
+        if (self->atomic_modesetting) {
+            uint32_t          blob_id = 0;
+            drmModeAtomicReq *req = drmModeAtomicAlloc();
+            ret = drmModeCreatePropertyBlob(get_drm_fd(self), &self->mode, sizeof(drmModeModeInfo), &blob_id);
+            if (!ret) {
+                ret |= add_crtc_property(self, req, self->crtc_id, "MODE_ID", blob_id);
+                ret |= add_crtc_property(self, req, self->crtc_id, "ACTIVE", 1);
+            }
+            if (!ret)
+                ret = drmModeAtomicCommit(get_drm_fd(self), req, DRM_MODE_ATOMIC_ALLOW_MODESET, NULL);
+            drmModeAtomicFree(req);
+            if (blob_id)
+                drmModeDestroyPropertyBlob(get_drm_fd(self), blob_id);
+        } else {
+            ret = drmModeSetCrtc(get_drm_fd(self), self->crtc_id, self->committed_buffer->fb_id, 0, 0,
+                                 &self->connector_id, 1, &self->mode);
+        }
+
+        if (ret)
+            g_debug("%s: Cannot switch immediately (%s), deferring to the next frame.", __func__, g_strerror(errno));
+        else
+            self->mode_set = true;
+    }
+
+    if (self->exportable && !same_size)
+        wpe_view_backend_dispatch_set_size(wpe_view_backend_exportable_fdo_get_view_backend(self->exportable), width,
+                                           height);
+    return true;
+}
+
 static struct wpe_view_backend_exportable_fdo *
 cog_drm_modeset_renderer_create_exportable(CogDrmRenderer *renderer, uint32_t width, uint32_t height)
 {
@@ -722,6 +821,13 @@ cog_drm_modeset_renderer_create_exportable(CogDrmRenderer *renderer, uint32_t wi
     return (self->exportable = wpe_view_backend_exportable_fdo_create(&client, renderer, width, height));
 }
 
+static struct gbm_bo *
+cog_drm_modeset_renderer_get_front_buffer(CogDrmRenderer *renderer)
+{
+    CogDrmModesetRenderer *self = wl_container_of(renderer, self, base);
+    return self->committed_buffer ? self->committed_buffer->bo : NULL;
+}
+
 CogDrmRenderer *
 cog_drm_modeset_renderer_new(struct gbm_device     *gbm_dev,
                              uint32_t               plane_id,
@@ -736,7 +842,9 @@ cog_drm_modeset_renderer_new(struct gbm_device     *gbm_dev,
         .base.name = "modeset",
         .base.initialize = cog_drm_modeset_renderer_initialize,
         .base.destroy = cog_drm_modeset_renderer_destroy,
+        .base.set_mode = cog_drm_modeset_renderer_set_mode,
         .base.create_exportable = cog_drm_modeset_renderer_create_exportable,
+        .base.get_front_buffer = cog_drm_modeset_renderer_get_front_buffer,
 
         .drm_source = drm_event_source_new(gbm_device_get_fd(gbm_dev)),
         .gbm_dev = gbm_dev,
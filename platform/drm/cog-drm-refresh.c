@@ -0,0 +1,222 @@
+/*
+ * cog-drm-refresh.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-drm-refresh.h"
+
+#include <inttypes.h>
+
+/* Interval between evaluations of the frame statistics. */
+#define WINDOW_MS 1000
+
+/* Content is considered animated if it keeps up with most of the idle rate. */
+#define ANIMATION_RATIO 0.9
+
+const char *const cog_drm_refresh_config_keys[] = {
+    "refresh-policy",
+    "idle-refresh",
+    "idle-timeout",
+    "vrr",
+    NULL,
+};
+
+void
+cog_drm_refresh_init(CogDrmRefresh *self)
+{
+    *self = (CogDrmRefresh){
+        .policy = COG_DRM_REFRESH_POLICY_FIXED,
+        .idle_refresh = 30,
+        .idle_timeout_ms = 3000,
+    };
+}
+
+static bool
+parse_uint(const char *value, uint32_t min, uint32_t max, uint32_t *result)
+{
+    char   *endp = NULL;
+    guint64 v = g_ascii_strtoull(value, &endp, 10);
+    if (endp == value || *endp != '\0' || v < min || v > max)
+        return false;
+
+    *result = v;
+    return true;
+}
+
+bool
+cog_drm_refresh_set(CogDrmRefresh *self, const char *key, const char *value, GError **error)
+{
+    g_assert(self);
+    g_assert(key);
+    g_assert(value);
+
+    if (g_str_equal(key, "refresh-policy")) {
+        if (g_str_equal(value, "fixed"))
+            self->policy = COG_DRM_REFRESH_POLICY_FIXED;
+        else if (g_str_equal(value, "adaptive"))
+            self->policy = COG_DRM_REFRESH_POLICY_ADAPTIVE;
+        else
+            goto invalid_value;
+    } else if (g_str_equal(key, "idle-refresh")) {
+        if (!parse_uint(value, 1, 1000, &self->idle_refresh))
+            goto invalid_value;
+    } else if (g_str_equal(key, "idle-timeout")) {
+        if (!parse_uint(value, 0, G_MAXINT32, &self->idle_timeout_ms))
+            goto invalid_value;
+    } else if (g_str_equal(key, "vrr")) {
+        /* Same spelling as accepted by g_key_file_get_boolean(). */
+        if (g_str_equal(value, "true") || g_str_equal(value, "1"))
+            self->vrr = true;
+        else if (g_str_equal(value, "false") || g_str_equal(value, "0"))
+            self->vrr = false;
+        else
+            goto invalid_value;
+    } else {
+        g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND, "Unknown refresh setting '%s'", key);
+        return false;
+    }
+
+    return true;
+
+invalid_value:
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE, "Invalid value '%s' for '%s'", value, key);
+    return false;
+}
+
+static void
+account_state(CogDrmRefresh *self, int64_t now)
+{
+    self->stats.time[self->idle] += now - self->stats.state_start;
+    self->stats.state_start = now;
+}
+
+static void
+set_idle(CogDrmRefresh *self, bool idle, int64_t now)
+{
+    if (self->idle == idle)
+        return;
+
+    account_state(self, now);
+    self->idle = idle;
+    self->stats.transitions++;
+
+    uint32_t refresh = idle ? MIN(self->idle_refresh, self->mode_refresh) : self->mode_refresh;
+    g_debug("%s: Content %s, target refresh %" PRIu32 " Hz.", __func__, idle ? "idle" : "active", refresh);
+
+    if (self->callback)
+        self->callback(refresh * 1000, self->userdata);
+}
+
+static gboolean
+on_window_elapsed(void *data)
+{
+    CogDrmRefresh *self = data;
+
+    const int64_t now = g_get_monotonic_time();
+    const double  elapsed = (double) (now - self->window_start) / G_USEC_PER_SEC;
+    const double  fps = (elapsed > 0.0) ? self->window_frames / elapsed : 0.0;
+    const bool    animating = fps >= self->idle_refresh * ANIMATION_RATIO;
+
+    self->window_start = now;
+    self->window_frames = 0;
+
+    if (self->idle) {
+        if (animating)
+            set_idle(self, false, now);
+    } else if (!animating && now - self->last_input >= (int64_t) self->idle_timeout_ms * 1000) {
+        set_idle(self, true, now);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+void
+cog_drm_refresh_start(CogDrmRefresh *self, uint32_t mode_refresh, CogDrmRefreshRateFunc callback, void *userdata)
+{
+    g_assert(self);
+    g_return_if_fail(!self->timer_id);
+
+    const int64_t now = g_get_monotonic_time();
+
+    self->callback = callback;
+    self->userdata = userdata;
+    self->mode_refresh = mode_refresh;
+    self->idle = false;
+    self->last_input = self->window_start = self->stats.state_start = now;
+
+    if (self->policy != COG_DRM_REFRESH_POLICY_ADAPTIVE)
+        return;
+
+    if (self->idle_refresh >= mode_refresh) {
+        g_warning("Idle refresh %" PRIu32 " Hz not below mode refresh %" PRIu32 " Hz, using fixed refresh policy.",
+                  self->idle_refresh, mode_refresh);
+        return;
+    }
+
+    self->timer_id = g_timeout_add(WINDOW_MS, on_window_elapsed, self);
+    g_source_set_name_by_id(self->timer_id, "Cog: DRM refresh policy");
+}
+
+void
+cog_drm_refresh_stop(CogDrmRefresh *self)
+{
+    g_assert(self);
+
+    if (!self->stats.state_start)
+        return;
+
+    g_clear_handle_id(&self->timer_id, g_source_remove);
+    account_state(self, g_get_monotonic_time());
+
+    const double active_s = (double) self->stats.time[false] / G_USEC_PER_SEC;
+    const double idle_s = (double) self->stats.time[true] / G_USEC_PER_SEC;
+    g_debug("%s: Active %.1f s (%.1f fps), idle %.1f s (%.1f fps), %u transitions.", __func__, active_s,
+            active_s > 0.0 ? self->stats.frames[false] / active_s : 0.0, idle_s,
+            idle_s > 0.0 ? self->stats.frames[true] / idle_s : 0.0, self->stats.transitions);
+
+    self->stats.state_start = 0;
+}
+
+void
+cog_drm_refresh_mode_changed(CogDrmRefresh *self, uint32_t mode_refresh)
+{
+    g_assert(self);
+
+    self->mode_refresh = mode_refresh;
+
+    if (self->timer_id && self->idle_refresh >= mode_refresh) {
+        g_debug("%s: Idle refresh not below %" PRIu32 " Hz, stopping policy.", __func__, mode_refresh);
+        set_idle(self, false, g_get_monotonic_time());
+        g_clear_handle_id(&self->timer_id, g_source_remove);
+    }
+
+    if (self->callback) {
+        uint32_t refresh = self->idle ? MIN(self->idle_refresh, mode_refresh) : mode_refresh;
+        self->callback(refresh * 1000, self->userdata);
+    }
+}
+
+void
+cog_drm_refresh_frame_presented(CogDrmRefresh *self)
+{
+    self->window_frames++;
+    self->stats.frames[self->idle]++;
+}
+
+void
+cog_drm_refresh_input(CogDrmRefresh *self)
+{
+    if (!self->timer_id)
+        return;
+
+    const int64_t now = g_get_monotonic_time();
+    self->last_input = now;
+
+    if (self->idle) {
+        set_idle(self, false, now);
+        self->window_start = now;
+        self->window_frames = 0;
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * cog-drm-refresh.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+    COG_DRM_REFRESH_POLICY_FIXED = 0,
+    COG_DRM_REFRESH_POLICY_ADAPTIVE,
+} CogDrmRefreshPolicy;
+
+typedef void (*CogDrmRefreshRateFunc)(uint32_t refresh_mhz, void *userdata);
+
+/*
+ * Adaptive refresh policy. While content is quiet and there is no input,
+ * the target refresh rate is lowered to the idle rate; input, or content
+ * which keeps up with the idle rate, ramps it back to the rate of the mode.
+ * Frame statistics come from page flips, sampled once per second.
+ */
+typedef struct {
+    CogDrmRefreshPolicy policy;
+    uint32_t            idle_refresh;    /* In Hz. */
+    uint32_t            idle_timeout_ms; /* Time without input before idling. */
+    bool                vrr;             /* Whether to enable VRR_ENABLED. */
+
+    CogDrmRefreshRateFunc callback;
+    void                 *userdata;
+
+    uint32_t mode_refresh;
+    bool     idle;
+    guint    timer_id;
+    int64_t  last_input;
+    int64_t  window_start;
+    unsigned window_frames;
+
+    struct {
+        int64_t  state_start;
+        int64_t  time[2];   /* Indexed by the "idle" flag. */
+        uint64_t frames[2];
+        unsigned transitions;
+    } stats;
+} CogDrmRefresh;
+
+extern const char *const cog_drm_refresh_config_keys[];
+
+void cog_drm_refresh_init(CogDrmRefresh *self);
+bool cog_drm_refresh_set(CogDrmRefresh *self, const char *key, const char *value, GError **error);
+
+void cog_drm_refresh_start(CogDrmRefresh *self, uint32_t mode_refresh, CogDrmRefreshRateFunc callback, void *userdata);
+void cog_drm_refresh_stop(CogDrmRefresh *self);
+void cog_drm_refresh_mode_changed(CogDrmRefresh *self, uint32_t mode_refresh);
+
+void cog_drm_refresh_frame_presented(CogDrmRefresh *self);
+void cog_drm_refresh_input(CogDrmRefresh *self);
+
+G_END_DECLS
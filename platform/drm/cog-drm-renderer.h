@@ -11,20 +11,41 @@
 #include <inttypes.h>
 #include <stdbool.h>
 
+struct gbm_bo;
 struct gbm_device;
 struct wpe_view_backend_exportable_fdo;
 typedef struct _drmModeModeInfo drmModeModeInfo;
 typedef struct _CogDrmRenderer  CogDrmRenderer;
 
+typedef void (*CogDrmRendererPresentedFunc)(CogDrmRenderer *, uint64_t time_usec, void *userdata);
+
 struct _CogDrmRenderer {
     const char *name;
 
+    /* Notified from page flip handlers when a frame reaches the screen. */
+    CogDrmRendererPresentedFunc presented_callback;
+    void                       *presented_userdata;
+
     bool (*initialize)(CogDrmRenderer *, GError **);
     void (*destroy)(CogDrmRenderer *);
 
     bool (*set_rotation)(CogDrmRenderer *, CogGLRendererRotation, bool apply);
+    bool (*set_scaling)(CogDrmRenderer *, CogGLRendererScaling, CogGLRendererFilter, bool apply);
+    bool (*set_color_transform)(CogDrmRenderer *, const uint16_t *lut, unsigned lut_size, const float *ctm, bool apply);
+    bool (*set_mode)(CogDrmRenderer *, const drmModeModeInfo *, uint32_t width, uint32_t height, bool apply);
+
+    /* Image shown below the first frames, which fade in over it. */
+    bool (*set_splash)(CogDrmRenderer *,
+                       int      dmabuf_fd,
+                       uint32_t width,
+                       uint32_t height,
+                       uint32_t stride,
+                       uint32_t format);
 
     struct wpe_view_backend_exportable_fdo *(*create_exportable)(CogDrmRenderer *, uint32_t width, uint32_t height);
+
+    /* Buffer currently being scanned out, if any. */
+    struct gbm_bo *(*get_front_buffer)(CogDrmRenderer *);
 };
 
 void cog_drm_renderer_destroy(CogDrmRenderer *self);
@@ -52,6 +73,88 @@ cog_drm_renderer_set_rotation(CogDrmRenderer *self, CogGLRendererRotation rotati
     return self->set_rotation && self->set_rotation(self, rotation, apply);
 }
 
+static inline bool
+cog_drm_renderer_supports_scaling(CogDrmRenderer *self, CogGLRendererScaling scaling, CogGLRendererFilter filter)
+{
+    const bool apply = false;
+    return self->set_scaling && self->set_scaling(self, scaling, filter, apply);
+}
+
+static inline bool
+cog_drm_renderer_set_scaling(CogDrmRenderer *self, CogGLRendererScaling scaling, CogGLRendererFilter filter)
+{
+    const bool apply = true;
+    return self->set_scaling && self->set_scaling(self, scaling, filter, apply);
+}
+
+static inline bool
+cog_drm_renderer_supports_color_transform(CogDrmRenderer *self)
+{
+    const bool apply = false;
+    return self->set_color_transform && self->set_color_transform(self, NULL, 0, NULL, apply);
+}
+
+static inline bool
+cog_drm_renderer_set_color_transform(CogDrmRenderer *self, const uint16_t *lut, unsigned lut_size, const float *ctm)
+{
+    const bool apply = true;
+    return self->set_color_transform && self->set_color_transform(self, lut, lut_size, ctm, apply);
+}
+
+static inline bool
+cog_drm_renderer_supports_mode_change(CogDrmRenderer *self)
+{
+    const bool apply = false;
+    return self->set_mode && self->set_mode(self, NULL, 0, 0, apply);
+}
+
+/*
+ * Switches the output to a new video mode, resizing the view to the given
+ * logical size.
+ */
+static inline bool
+cog_drm_renderer_set_mode(CogDrmRenderer *self, const drmModeModeInfo *mode, uint32_t width, uint32_t height)
+{
+    const bool apply = true;
+    return self->set_mode && self->set_mode(self, mode, width, height, apply);
+}
+
+static inline void
+cog_drm_renderer_set_presented_callback(CogDrmRenderer *self, CogDrmRendererPresentedFunc callback, void *userdata)
+{
+    self->presented_callback = callback;
+    self->presented_userdata = userdata;
+}
+
+static inline void
+cog_drm_renderer_notify_presented(CogDrmRenderer *self, unsigned sec, unsigned usec)
+{
+    if (self->presented_callback)
+        self->presented_callback(self, (uint64_t) sec * G_USEC_PER_SEC + usec, self->presented_userdata);
+}
+
+/*
+ * Hands over the buffer of the boot splash being scanned out, so the first
+ * frames can be faded in over it. The renderer does not take ownership of
+ * the file descriptor.
+ */
+static inline bool
+cog_drm_renderer_set_splash(CogDrmRenderer *self,
+                            int             dmabuf_fd,
+                            uint32_t        width,
+                            uint32_t        height,
+                            uint32_t        stride,
+                            uint32_t        format)
+{
+    return self->set_splash && self->set_splash(self, dmabuf_fd, width, height, stride, format);
+}
+
+static inline struct gbm_bo *
+cog_drm_renderer_get_front_buffer(CogDrmRenderer *self)
+{
+    return self->get_front_buffer ? self->get_front_buffer(self) : NULL;
+}
+
 static inline struct wpe_view_backend_exportable_fdo *
 cog_drm_renderer_create_exportable(CogDrmRenderer *self, uint32_t width, uint32_t height)
 {
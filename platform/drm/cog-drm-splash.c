@@ -0,0 +1,347 @@
+/*
+ * cog-drm-splash.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-drm-splash.h"
+
+#include <drm_fourcc.h>
+#include <errno.h>
+#include <gbm.h>
+#include <gio/gio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <xf86drm.h>
+
+#define SPLASH_MAGIC   "COGSPLSH"
+#define SPLASH_VERSION 1
+
+/*
+ * Snapshots are only ever read back on the device which wrote them, so the
+ * header uses native byte order. Rows of 32-bit pixels follow the header,
+ * tightly packed and zlib-compressed.
+ */
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+} SplashHeader;
+
+const char *const cog_drm_splash_config_keys[] = {
+    "splash",
+    "splash-save-on-exit",
+    NULL,
+};
+
+void
+cog_drm_splash_init(CogDrmSplash *self)
+{
+    *self = (CogDrmSplash){
+        .save_on_exit = true,
+        .fd = -1,
+    };
+}
+
+void
+cog_drm_splash_clear(CogDrmSplash *self)
+{
+    cog_drm_splash_hide(self);
+    g_clear_pointer(&self->path, g_free);
+}
+
+bool
+cog_drm_splash_set(CogDrmSplash *self, const char *key, const char *value, GError **error)
+{
+    g_assert(self);
+    g_assert(key);
+    g_assert(value);
+
+    if (g_str_equal(key, "splash")) {
+        g_free(self->path);
+        self->path = *value ? g_strdup(value) : NULL;
+    } else if (g_str_equal(key, "splash-save-on-exit")) {
+        /* Same spelling as accepted by g_key_file_get_boolean(). */
+        if (g_str_equal(value, "true") || g_str_equal(value, "1"))
+            self->save_on_exit = true;
+        else if (g_str_equal(value, "false") || g_str_equal(value, "0"))
+            self->save_on_exit = false;
+        else
+            goto invalid_value;
+    } else {
+        g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_KEY_NOT_FOUND, "Unknown splash setting '%s'", key);
+        return false;
+    }
+
+    return true;
+
+invalid_value:
+    g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE, "Invalid value '%s' for '%s'", value, key);
+    return false;
+}
+
+/* Maps supported formats to the opaque variant used for scanout. */
+static uint32_t
+scanout_format(uint32_t format)
+{
+    switch (format) {
+    case DRM_FORMAT_XRGB8888:
+    case DRM_FORMAT_ARGB8888:
+        return DRM_FORMAT_XRGB8888;
+    case DRM_FORMAT_XBGR8888:
+    case DRM_FORMAT_ABGR8888:
+        return DRM_FORMAT_XBGR8888;
+    default:
+        return 0;
+    }
+}
+
+static bool
+read_header(GInputStream *stream, SplashHeader *header, GError **error)
+{
+    gsize n_read = 0;
+    if (!g_input_stream_read_all(stream, header, sizeof(*header), &n_read, NULL, error))
+        return false;
+
+    if (n_read != sizeof(*header) || memcmp(header->magic, SPLASH_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SPLASH_VERSION) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Not a splash snapshot");
+        return false;
+    }
+    if (!scanout_format(header->format)) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Unsupported pixel format %#" PRIx32,
+                    header->format);
+        return false;
+    }
+    return true;
+}
+
+bool
+cog_drm_splash_show(CogDrmSplash    *self,
+                    int              fd,
+                    uint32_t         crtc_id,
+                    uint32_t         connector_id,
+                    drmModeModeInfo *mode,
+                    GError         **error)
+{
+    g_assert(self);
+    g_assert(mode);
+    g_return_val_if_fail(self->path, false);
+    g_return_val_if_fail(!self->fb_id, false);
+
+    g_autoptr(GFile) file = g_file_new_for_path(self->path);
+    g_autoptr(GFileInputStream) file_stream = g_file_read(file, NULL, error);
+    if (!file_stream)
+        return false;
+
+    SplashHeader header;
+    if (!read_header(G_INPUT_STREAM(file_stream), &header, error))
+        return false;
+
+    /* Scaling the snapshot would take longer than it saves; skip it instead. */
+    if (header.width != mode->hdisplay || header.height != mode->vdisplay) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                    "Snapshot size %" PRIu32 "x%" PRIu32 " does not match mode %s", header.width, header.height,
+                    mode->name);
+        return false;
+    }
+
+    struct drm_mode_create_dumb create = {
+        .width = header.width,
+        .height = header.height,
+        .bpp = 32,
+    };
+    if (drmIoctl(fd, DRM_IOCTL_MODE_CREATE_DUMB, &create) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Cannot create dumb buffer: %s",
+                    g_strerror(errno));
+        return false;
+    }
+    self->fd = fd;
+    self->handle = create.handle;
+
+    struct drm_mode_map_dumb map = {
+        .handle = create.handle,
+    };
+    if (drmIoctl(fd, DRM_IOCTL_MODE_MAP_DUMB, &map) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Cannot map dumb buffer: %s", g_strerror(errno));
+        goto fail;
+    }
+
+    uint8_t *pixels = mmap(NULL, create.size, PROT_WRITE, MAP_SHARED, fd, map.offset);
+    if (pixels == MAP_FAILED) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Cannot map dumb buffer: %s", g_strerror(errno));
+        goto fail;
+    }
+
+    bool ok = true;
+    {
+        g_autoptr(GConverter) decompressor = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB));
+        g_autoptr(GInputStream) stream = g_converter_input_stream_new(G_INPUT_STREAM(file_stream), decompressor);
+
+        const gsize row_size = (gsize) header.width * 4;
+        for (uint32_t y = 0; ok && y < header.height; y++) {
+            gsize n_read = 0;
+            ok = g_input_stream_read_all(stream, pixels + (gsize) y * create.pitch, row_size, &n_read, NULL, error);
+            if (ok && n_read != row_size) {
+                g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Truncated splash snapshot");
+                ok = false;
+            }
+        }
+    }
+    munmap(pixels, create.size);
+    if (!ok)
+        goto fail;
+
+    uint32_t handles[4] = {create.handle};
+    uint32_t pitches[4] = {create.pitch};
+    uint32_t offsets[4] = {0};
+    if (drmModeAddFB2(fd, header.width, header.height, scanout_format(header.format), handles, pitches, offsets,
+                      &self->fb_id, 0) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Cannot add framebuffer: %s", g_strerror(errno));
+        goto fail;
+    }
+
+    /*
+     * Legacy modesetting is available with atomic drivers as well, and the
+     * renderer does a full commit of its own along the first live frame.
+     */
+    if (drmModeSetCrtc(fd, crtc_id, self->fb_id, 0, 0, &connector_id, 1, mode) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Cannot set CRTC: %s", g_strerror(errno));
+        goto fail;
+    }
+
+    self->width = header.width;
+    self->height = header.height;
+    self->pitch = create.pitch;
+    self->format = scanout_format(header.format);
+
+    g_debug("%s: Showing %" PRIu32 "x%" PRIu32 " snapshot from %s.", __func__, header.width, header.height, self->path);
+    return true;
+
+fail:
+    cog_drm_splash_hide(self);
+    return false;
+}
+
+/*
+ * Releases the splash buffer. Removing a framebuffer which is still being
+ * scanned out disables the CRTC, so this must be called only after another
+ * frame has been presented.
+ */
+void
+cog_drm_splash_hide(CogDrmSplash *self)
+{
+    g_assert(self);
+
+    if (self->fd < 0)
+        return;
+
+    if (self->fb_id) {
+        drmModeRmFB(self->fd, self->fb_id);
+        self->fb_id = 0;
+    }
+    if (self->handle) {
+        struct drm_mode_destroy_dumb destroy = {
+            .handle = self->handle,
+        };
+        drmIoctl(self->fd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+        self->handle = 0;
+    }
+    self->fd = -1;
+}
+
+/*
+ * Exports the splash buffer as a DMA-BUF file descriptor, which the caller
+ * owns. The buffer stays alive as long as the descriptor or any image made
+ * from it, even after cog_drm_splash_hide() has been called.
+ */
+int
+cog_drm_splash_export(CogDrmSplash *self, GError **error)
+{
+    g_assert(self);
+    g_return_val_if_fail(self->fb_id, -1);
+
+    int dmabuf_fd = -1;
+    if (drmPrimeHandleToFD(self->fd, self->handle, DRM_CLOEXEC, &dmabuf_fd) != 0) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Cannot export splash buffer: %s",
+                    g_strerror(errno));
+        return -1;
+    }
+    return dmabuf_fd;
+}
+
+bool
+cog_drm_splash_save(CogDrmSplash *self, struct gbm_bo *bo, GError **error)
+{
+    g_assert(self);
+    g_return_val_if_fail(self->path, false);
+
+    if (!bo) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_INITIALIZED, "No frame has been presented yet");
+        return false;
+    }
+
+    SplashHeader header = {
+        .magic = SPLASH_MAGIC,
+        .version = SPLASH_VERSION,
+        .width = gbm_bo_get_width(bo),
+        .height = gbm_bo_get_height(bo),
+        .format = gbm_bo_get_format(bo),
+    };
+    if (!scanout_format(header.format) || gbm_bo_get_bpp(bo) != 32) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Unsupported pixel format %#" PRIx32,
+                    header.format);
+        return false;
+    }
+
+    const int64_t start = g_get_monotonic_time();
+
+    uint32_t stride = 0;
+    void    *map_data = NULL;
+    uint8_t *pixels = gbm_bo_map(bo, 0, 0, header.width, header.height, GBM_BO_TRANSFER_READ, &stride, &map_data);
+    if (!pixels) {
+        g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errno), "Cannot map front buffer: %s",
+                    g_strerror(errno));
+        return false;
+    }
+
+    /* The file is written aside and renamed, so a crash never leaves a partial snapshot behind. */
+    g_autoptr(GFile) file = g_file_new_for_path(self->path);
+    g_autoptr(GFileOutputStream) file_stream = g_file_replace(file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+    bool ok = !!file_stream;
+
+    if (ok)
+        ok = g_output_stream_write_all(G_OUTPUT_STREAM(file_stream), &header, sizeof(header), NULL, NULL, error);
+
+    /* Favour speed over size: saving may happen while shutting down. */
+    g_autoptr(GConverter) compressor = G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, 1));
+    g_autoptr(GOutputStream) stream = NULL;
+    if (ok)
+        stream = g_converter_output_stream_new(G_OUTPUT_STREAM(file_stream), compressor);
+
+    const gsize row_size = (gsize) header.width * 4;
+    for (uint32_t y = 0; ok && y < header.height; y++)
+        ok = g_output_stream_write_all(stream, pixels + (gsize) y * stride, row_size, NULL, NULL, error);
+
+    gbm_bo_unmap(bo, map_data);
+
+    if (ok)
+        ok = g_output_stream_close(stream, NULL, error);
+
+    if (!ok) {
+        /* Closing after a failure would replace the previous snapshot. */
+        g_autoptr(GCancellable) cancellable = g_cancellable_new();
+        g_cancellable_cancel(cancellable);
+        if (file_stream)
+            g_output_stream_close(G_OUTPUT_STREAM(file_stream), cancellable, NULL);
+        return false;
+    }
+
+    g_debug("%s: Saved %" PRIu32 "x%" PRIu32 " snapshot to %s in %.1f ms.", __func__, header.width, header.height,
+            self->path, (g_get_monotonic_time() - start) / 1000.0);
+    return true;
+}
@@ -0,0 +1,56 @@
+/*
+ * cog-drm-splash.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xf86drmMode.h>
+
+G_BEGIN_DECLS
+
+struct gbm_bo;
+
+/*
+ * Boot splash made from a snapshot of the last presented frame. The frame is
+ * saved compressed to a file, and on the next start it gets scanned out from
+ * a dumb buffer as soon as the output is configured, long before WebKit
+ * produces its first frame. The buffer is released once live content has
+ * replaced it on screen. It can also be exported to a renderer, which may
+ * keep it around for a while to fade the first frames in over it.
+ */
+typedef struct {
+    char *path;         /* Snapshot file, the splash is disabled when unset. */
+    bool  save_on_exit; /* Whether to save a snapshot when the shell goes away. */
+
+    int      fd;
+    uint32_t handle;
+    uint32_t fb_id;
+    uint32_t width, height;
+    uint32_t pitch;
+    uint32_t format;
+} CogDrmSplash;
+
+extern const char *const cog_drm_splash_config_keys[];
+
+void cog_drm_splash_init(CogDrmSplash *self);
+void cog_drm_splash_clear(CogDrmSplash *self);
+bool cog_drm_splash_set(CogDrmSplash *self, const char *key, const char *value, GError **error);
+
+bool cog_drm_splash_show(CogDrmSplash    *self,
+                         int              fd,
+                         uint32_t         crtc_id,
+                         uint32_t         connector_id,
+                         drmModeModeInfo *mode,
+                         GError         **error);
+void cog_drm_splash_hide(CogDrmSplash *self);
+int  cog_drm_splash_export(CogDrmSplash *self, GError **error);
+
+bool cog_drm_splash_save(CogDrmSplash *self, struct gbm_bo *bo, GError **error);
+
+G_END_DECLS
@@ -8,7 +8,11 @@
 
 #include "../../core/cog.h"
 
+#include "cog-drm-color.h"
+#include "cog-drm-mode.h"
+#include "cog-drm-refresh.h"
 #include "cog-drm-renderer.h"
+#include "cog-drm-splash.h"
 #include "cursor-drm.h"
 #include "kms.h"
 #include <assert.h>
@@ -16,9 +20,12 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <gbm.h>
+#include <glib-unix.h>
 #include <libinput.h>
 #include <libudev.h>
+#include <math.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <wayland-server.h>
 #include <wpe/fdo-egl.h>
 #include <wpe/fdo.h>
@@ -75,6 +82,7 @@ enum {
     PROP_0,
     PROP_ROTATION,
     PROP_RENDERER,
+    PROP_VIDEO_MODE,
     N_PROPERTIES,
 };
 
@@ -118,6 +126,21 @@ static struct {
     uint32_t refresh;
     double   device_scale;
 
+    /*
+     * Optional fixed logical size for the view, in the orientation of the
+     * output before applying rotation. When unset (zero) the size of the
+     * view is derived from the video mode.
+     */
+    uint32_t             view_width;
+    uint32_t             view_height;
+    CogGLRendererScaling scaling;
+    CogGLRendererFilter  scaling_filter;
+
+    CogDrmModeConfig  mode_config;
+    CogDrmColorConfig color;
+    CogDrmRefresh     refresh_policy;
+    CogDrmSplash      splash;
+
     bool atomic_modesetting;
     bool addfb2_modifiers;
     bool mode_set;
@@ -147,6 +170,10 @@ static struct {
     .height = 0,
     .refresh = 0,
     .device_scale = 1.0,
+    .view_width = 0,
+    .view_height = 0,
+    .scaling = COG_GL_RENDERER_SCALING_FIT,
+    .scaling_filter = COG_GL_RENDERER_FILTER_LINEAR,
     .atomic_modesetting = true,
     .mode_set = false,
 };
@@ -191,11 +218,38 @@ static struct {
     uint32_t input_width;
     uint32_t input_height;
 
+    /* Area of the output covered by the view, and its size in pixels. */
+    CogGLRendererRect view_rect;
+    uint32_t          view_width;
+    uint32_t          view_height;
+
     struct keyboard_event repeating_key;
 
     struct wpe_input_touch_event_raw touch_points[10];
     enum wpe_input_touch_event_type last_touch_type;
     int last_touch_id;
+    bool touch_state_changed;
+
+    /*
+     * Motion, scroll, and touch motion are coalesced until the next frame is
+     * presented, see input_flush_events(). Events which change the state of
+     * buttons, keys, or touch points are dispatched right away.
+     */
+    struct {
+        bool                           motion;
+        uint32_t                       motion_time;
+        bool                           axis;
+        struct wpe_input_axis_2d_event axis_event;
+        bool                           touch;
+        uint32_t                       touch_time;
+        guint                          timeout_id;
+    } pending;
+
+    /* Pointer and touch events, as received from libinput and sent to WebKit. */
+    struct {
+        uint64_t received;
+        uint64_t dispatched;
+    } stats;
 } input_data = {
     .udev = NULL,
     .libinput = NULL,
@@ -206,6 +260,21 @@ static struct {
     .last_touch_id = 0,
 };
 
+/* Output hotplug handling, see init_hotplug(). */
+static struct {
+    struct udev         *udev;
+    struct udev_monitor *monitor;
+    guint                source_id;
+    guint                debounce_id;
+    dev_t                devnum;
+    bool                 connected;
+    bool                 disconnected_meanwhile;
+} hotplug_data = {
+    .udev = NULL,
+    .monitor = NULL,
+    .connected = true,
+};
+
 static struct {
     GSource *drm_source;
     GSource *input_source;
@@ -224,9 +293,27 @@ static struct {
     struct wpe_view_backend *backend;
 } wpe_view_data;
 
+static bool
+parse_size(const char *str, uint32_t *width, uint32_t *height)
+{
+    unsigned w = 0, h = 0;
+    char     tail;
+    if (!str || sscanf(str, "%ux%u%c", &w, &h, &tail) != 2 || !w || !h)
+        return false;
+
+    *width = w;
+    *height = h;
+    return true;
+}
+
 static void
 init_config(CogDrmPlatform *self, CogShell *shell, const char *params_string)
 {
+    cog_drm_mode_config_init(&drm_data.mode_config);
+    cog_drm_color_config_init(&drm_data.color);
+    cog_drm_refresh_init(&drm_data.refresh_policy);
+    cog_drm_splash_init(&drm_data.splash);
+
     drm_data.device_scale = cog_shell_get_device_scale_factor (shell);
     g_debug ("init_config: overriding device_scale value, using %.2f from shell",
              drm_data.device_scale);
@@ -264,6 +351,52 @@ init_config(CogDrmPlatform *self, CogShell *shell, const char *params_string)
             else if (value)
                 g_warning("Invalid renderer '%s', using default.", value);
         }
+
+        {
+            g_autofree char *value = g_key_file_get_string(key_file, "drm", "view-size", NULL);
+            if (value && !parse_size(value, &drm_data.view_width, &drm_data.view_height))
+                g_warning("Invalid view size '%s', using default.", value);
+        }
+
+        {
+            g_autofree char *value = g_key_file_get_string(key_file, "drm", "scaling", NULL);
+            if (value && !cog_gl_renderer_scaling_from_string(value, &drm_data.scaling))
+                g_warning("Invalid scaling '%s', using default.", value);
+        }
+
+        {
+            g_autofree char *value = g_key_file_get_string(key_file, "drm", "scaling-filter", NULL);
+            if (value && !cog_gl_renderer_filter_from_string(value, &drm_data.scaling_filter))
+                g_warning("Invalid scaling filter '%s', using default.", value);
+        }
+
+        for (unsigned i = 0; cog_drm_mode_config_keys[i]; i++) {
+            g_autofree char *value = g_key_file_get_string(key_file, "drm", cog_drm_mode_config_keys[i], NULL);
+            g_autoptr(GError) error = NULL;
+            if (value && !cog_drm_mode_config_set(&drm_data.mode_config, cog_drm_mode_config_keys[i], value, &error))
+                g_warning("%s, using default.", error->message);
+        }
+
+        for (unsigned i = 0; cog_drm_color_config_keys[i]; i++) {
+            g_autofree char *value = g_key_file_get_string(key_file, "drm", cog_drm_color_config_keys[i], NULL);
+            g_autoptr(GError) error = NULL;
+            if (value && !cog_drm_color_config_set(&drm_data.color, cog_drm_color_config_keys[i], value, &error))
+                g_warning("%s, using default.", error->message);
+        }
+
+        for (unsigned i = 0; cog_drm_refresh_config_keys[i]; i++) {
+            g_autofree char *value = g_key_file_get_string(key_file, "drm", cog_drm_refresh_config_keys[i], NULL);
+            g_autoptr(GError) error = NULL;
+            if (value && !cog_drm_refresh_set(&drm_data.refresh_policy, cog_drm_refresh_config_keys[i], value, &error))
+                g_warning("%s, using default.", error->message);
+        }
+
+        for (unsigned i = 0; cog_drm_splash_config_keys[i]; i++) {
+            g_autofree char *value = g_key_file_get_string(key_file, "drm", cog_drm_splash_config_keys[i], NULL);
+            g_autoptr(GError) error = NULL;
+            if (value && !cog_drm_splash_set(&drm_data.splash, cog_drm_splash_config_keys[i], value, &error))
+                g_warning("%s, using default.", error->message);
+        }
     }
 
     if (params_string) {
@@ -293,6 +426,31 @@ init_config(CogDrmPlatform *self, CogShell *shell, const char *params_string)
                     g_warning("Invalid value '%s' for parameter '%s'.", v, k);
                 else
                     self->rotation = val;
+            } else if (g_strcmp0(k, "view-size") == 0) {
+                if (!parse_size(v, &drm_data.view_width, &drm_data.view_height))
+                    g_warning("Invalid value '%s' for parameter '%s'.", v, k);
+            } else if (g_strcmp0(k, "scaling") == 0) {
+                if (!cog_gl_renderer_scaling_from_string(v, &drm_data.scaling))
+                    g_warning("Invalid value '%s' for parameter '%s'.", v, k);
+            } else if (g_strcmp0(k, "scaling-filter") == 0) {
+                if (!cog_gl_renderer_filter_from_string(v, &drm_data.scaling_filter))
+                    g_warning("Invalid value '%s' for parameter '%s'.", v, k);
+            } else if (g_strv_contains(cog_drm_mode_config_keys, k)) {
+                g_autoptr(GError) error = NULL;
+                if (!cog_drm_mode_config_set(&drm_data.mode_config, k, v, &error))
+                    g_warning("%s.", error->message);
+            } else if (g_strv_contains(cog_drm_color_config_keys, k)) {
+                g_autoptr(GError) error = NULL;
+                if (!cog_drm_color_config_set(&drm_data.color, k, v, &error))
+                    g_warning("%s.", error->message);
+            } else if (g_strv_contains(cog_drm_refresh_config_keys, k)) {
+                g_autoptr(GError) error = NULL;
+                if (!cog_drm_refresh_set(&drm_data.refresh_policy, k, v, &error))
+                    g_warning("%s.", error->message);
+            } else if (g_strv_contains(cog_drm_splash_config_keys, k)) {
+                g_autoptr(GError) error = NULL;
+                if (!cog_drm_splash_set(&drm_data.splash, k, v, &error))
+                    g_warning("%s.", error->message);
             } else {
                 g_warning("Invalid parameter '%s'.", k);
             }
@@ -356,6 +514,58 @@ find_crtc_for_encoder(const drmModeRes *resources, const drmModeEncoder *encoder
     return -1;
 }
 
+/*
+ * Picks the configured connector, the one in use (if any), or otherwise the
+ * first connected one, and a video mode for it according to the selection
+ * policy. Returns NULL when there is no suitable connected output.
+ */
+static drmModeConnector *
+probe_connector(drmModeModeInfo **mode)
+{
+    drmModeConnector *chosen = NULL;
+    int               chosen_rank = 0;
+
+    for (int i = 0; i < drm_data.base_resources->count_connectors; ++i) {
+        drmModeConnector *connector = drmModeGetConnector(drm_data.fd, drm_data.base_resources->connectors[i]);
+        if (!connector || connector->connection != DRM_MODE_CONNECTED || !connector->count_modes) {
+            g_clear_pointer(&connector, drmModeFreeConnector);
+            continue;
+        }
+
+        g_autofree char *name = cog_drm_mode_connector_name(connector);
+        int              rank = 1;
+        if (drm_data.mode_config.connector && g_str_equal(name, drm_data.mode_config.connector))
+            rank = 3;
+        else if (connector->connector_id == drm_data.connector.obj_id)
+            rank = 2;
+
+        if (rank > chosen_rank) {
+            g_clear_pointer(&chosen, drmModeFreeConnector);
+            chosen = connector;
+            chosen_rank = rank;
+        } else {
+            drmModeFreeConnector(connector);
+        }
+    }
+    if (!chosen)
+        return NULL;
+
+    g_autofree char *connector_name = cog_drm_mode_connector_name(chosen);
+    if (drm_data.mode_config.connector && chosen_rank != 3)
+        g_warning("Connector '%s' not found or not connected, using '%s'.", drm_data.mode_config.connector,
+                  connector_name);
+    g_debug("%s: using connector id %" PRIu32 " (%s)", __func__, chosen->connector_id, connector_name);
+
+    if (!(*mode = cog_drm_mode_select(&drm_data.mode_config, chosen))) {
+        drmModeFreeConnector(chosen);
+        return NULL;
+    }
+
+    g_debug("%s: using mode [%ld] '%s' @ %" PRIu32 "Hz", __func__, (long) (*mode - chosen->modes), (*mode)->name,
+            (*mode)->vrefresh);
+    return chosen;
+}
+
 static gboolean
 init_drm(void)
 {
@@ -417,10 +627,9 @@ init_drm(void)
         drmModeConnector *connector = drmModeGetConnector (drm_data.fd,
                                                            drm_data.base_resources->connectors[i]);
 
-        g_debug ("init_drm:  connector id %u, type %u, %sconnected, %d usable modes",
-                 connector->connector_id, connector->connector_type,
-                 (connector->connection == DRM_MODE_CONNECTED) ? "" : "not ",
-                 connector->count_modes);
+        g_autofree char *name = cog_drm_mode_connector_name(connector);
+        g_debug("init_drm:  connector id %u (%s), %sconnected, %d usable modes", connector->connector_id, name,
+                (connector->connection == DRM_MODE_CONNECTED) ? "" : "not ", connector->count_modes);
 
         for (int j = 0; j < connector->count_modes; ++j) {
             drmModeModeInfo *mode = &connector->modes[j];
@@ -434,69 +643,9 @@ init_drm(void)
         g_clear_pointer (&connector, drmModeFreeConnector);
     }
 
-    for (int i = 0; i < drm_data.base_resources->count_connectors; ++i) {
-        drm_data.connector.obj = drmModeGetConnector (drm_data.fd, drm_data.base_resources->connectors[i]);
-        if (drm_data.connector.obj->connection == DRM_MODE_CONNECTED)
-            break;
-
-        g_clear_pointer (&drm_data.connector.obj, drmModeFreeConnector);
-    }
-    if (!drm_data.connector.obj)
+    if (!(drm_data.connector.obj = probe_connector(&drm_data.mode)))
         return FALSE;
-
-    g_debug("init_drm: using connector id %d, type %d", drm_data.connector.obj->connector_id,
-            drm_data.connector.obj->connector_type);
-
-    const char *user_selected_mode = g_getenv("COG_PLATFORM_DRM_VIDEO_MODE");
-
-    int user_max_width = 0;
-    int user_max_height = 0;
-    int user_max_refresh = 0;
-
-    const char *user_mode_max = g_getenv("COG_PLATFORM_DRM_MODE_MAX");
-    if (user_mode_max) {
-        if (sscanf(user_mode_max, "%dx%d@%d", &user_max_width, &user_max_height, &user_max_refresh) < 2 ||
-            user_max_width < 0 || user_max_height < 0 || user_max_refresh < 0) {
-            fprintf(stderr, "invalid value for COG_PLATFORM_DRM_MODE_MAX\n");
-            user_max_width = 0;
-            user_max_height = 0;
-            user_max_refresh = 0;
-        }
-    }
-
-    for (int i = 0, area = 0; i < drm_data.connector.obj->count_modes; ++i) {
-        drmModeModeInfo *current_mode = &drm_data.connector.obj->modes[i];
-        if (user_selected_mode && strcmp(user_selected_mode, current_mode->name) != 0) {
-            continue;
-        }
-
-        if (user_max_width && current_mode->hdisplay > user_max_width) {
-            continue;
-        }
-        if (user_max_height && current_mode->vdisplay > user_max_height) {
-            continue;
-        }
-        if (user_max_refresh && current_mode->vrefresh > user_max_refresh) {
-            continue;
-        }
-
-        if (current_mode->type & DRM_MODE_TYPE_PREFERRED) {
-            drm_data.mode = current_mode;
-            break;
-        }
-
-        int current_area = current_mode->hdisplay * current_mode->vdisplay;
-        if (current_area > area) {
-            drm_data.mode = current_mode;
-            area = current_area;
-        }
-    }
-    if (!drm_data.mode)
-        return FALSE;
-
-    g_debug("init_drm: using mode [%ld] '%s' @ %dHz",
-            (long)((drm_data.mode - drm_data.connector.obj->modes) / sizeof(drmModeModeInfo *)), drm_data.mode->name,
-            drm_data.mode->vrefresh);
+    drm_data.connector.obj_id = drm_data.connector.obj->connector_id;
 
     /* Try the currently connected encoder+crtc */
     for (int i = 0; i < drm_data.base_resources->count_encoders; ++i) {
@@ -520,8 +669,6 @@ init_drm(void)
         return FALSE;
     }
 
-    drm_data.connector.obj_id = drm_data.connector.obj->connector_id;
-
     drm_data.crtc.obj = drmModeGetCrtc (drm_data.fd, drm_data.crtc.obj_id);
     for (int i = 0; i < drm_data.base_resources->count_crtcs; ++i) {
         if (drm_data.base_resources->crtcs[i] == drm_data.crtc.obj_id) {
@@ -580,6 +727,207 @@ init_drm(void)
     return TRUE;
 }
 
+/*
+ * Looks up a property of a KMS object by name, optionally retrieving its
+ * current value. Returns the property identifier, or zero if not found.
+ */
+static uint32_t
+find_property(uint32_t obj_id, uint32_t obj_type, const char *name, uint64_t *value)
+{
+    drmModeObjectProperties *props = drmModeObjectGetProperties(drm_data.fd, obj_id, obj_type);
+    if (!props)
+        return 0;
+
+    uint32_t prop_id = 0;
+    for (uint32_t i = 0; !prop_id && i < props->count_props; i++) {
+        drmModePropertyRes *prop = drmModeGetProperty(drm_data.fd, props->props[i]);
+        if (prop && g_strcmp0(prop->name, name) == 0) {
+            prop_id = prop->prop_id;
+            if (value)
+                *value = props->prop_values[i];
+        }
+        g_clear_pointer(&prop, drmModeFreeProperty);
+    }
+
+    drmModeFreeObjectProperties(props);
+    return prop_id;
+}
+
+static inline uint32_t
+find_crtc_property(const char *name, uint64_t *value)
+{
+    return find_property(drm_data.crtc.obj_id, DRM_MODE_OBJECT_CRTC, name, value);
+}
+
+/* CTM coefficients are in S31.32 sign-magnitude format. */
+static inline uint64_t
+ctm_coefficient(double value)
+{
+    uint64_t magnitude = (uint64_t) llround(fabs(value) * (double) (UINT64_C(1) << 32));
+    return (value < 0.0) ? (magnitude | (UINT64_C(1) << 63)) : magnitude;
+}
+
+/*
+ * Programs the color configuration into the GAMMA_LUT and CTM properties of
+ * the CRTC, letting the display controller apply it for free at scanout.
+ * Returns false if the CRTC lacks the needed properties or the kernel rejects
+ * the configuration, in which case nothing is changed.
+ */
+static bool
+init_color_kms(void)
+{
+    const CogDrmColorConfig *config = &drm_data.color;
+    const bool               need_lut = cog_drm_color_config_has_curve(config);
+
+    uint64_t       lut_size = 0;
+    const uint32_t lut_prop = find_crtc_property("GAMMA_LUT", NULL);
+    const uint32_t ctm_prop = find_crtc_property("CTM", NULL);
+    find_crtc_property("GAMMA_LUT_SIZE", &lut_size);
+
+    if (need_lut && (!lut_prop || lut_size < 2)) {
+        g_debug("%s: CRTC %" PRIu32 " has no usable GAMMA_LUT.", __func__, drm_data.crtc.obj_id);
+        return false;
+    }
+    if (config->has_ctm && !ctm_prop) {
+        g_debug("%s: CRTC %" PRIu32 " has no CTM.", __func__, drm_data.crtc.obj_id);
+        return false;
+    }
+
+    uint32_t lut_blob = 0;
+    uint32_t ctm_blob = 0;
+    int      ret = 0;
+
+    if (need_lut) {
+        g_autofree uint16_t             *lut = g_new(uint16_t, lut_size * 3);
+        g_autofree struct drm_color_lut *entries = g_new0(struct drm_color_lut, lut_size);
+
+        cog_drm_color_config_build_lut(config, lut_size, lut);
+        for (uint64_t i = 0; i < lut_size; i++) {
+            entries[i].red = lut[3 * i];
+            entries[i].green = lut[3 * i + 1];
+            entries[i].blue = lut[3 * i + 2];
+        }
+        ret = drmModeCreatePropertyBlob(drm_data.fd, entries, sizeof(*entries) * lut_size, &lut_blob);
+    }
+
+    if (!ret && config->has_ctm) {
+        struct drm_color_ctm ctm;
+        for (unsigned i = 0; i < G_N_ELEMENTS(ctm.matrix); i++)
+            ctm.matrix[i] = ctm_coefficient(config->ctm[i]);
+        ret = drmModeCreatePropertyBlob(drm_data.fd, &ctm, sizeof(ctm), &ctm_blob);
+    }
+
+    /* Properties without a blob are reset, to drop any stale setting. */
+    if (ret) {
+        g_warning("%s: Cannot create property blob: %s", __func__, g_strerror(errno));
+    } else if (drm_data.atomic_modesetting) {
+        drmModeAtomicReq *req = drmModeAtomicAlloc();
+        if (lut_prop)
+            drmModeAtomicAddProperty(req, drm_data.crtc.obj_id, lut_prop, lut_blob);
+        if (ctm_prop)
+            drmModeAtomicAddProperty(req, drm_data.crtc.obj_id, ctm_prop, ctm_blob);
+
+        ret = drmModeAtomicCommit(drm_data.fd, req, DRM_MODE_ATOMIC_TEST_ONLY, NULL);
+        if (!ret)
+            ret = drmModeAtomicCommit(drm_data.fd, req, 0, NULL);
+        drmModeAtomicFree(req);
+    } else {
+        if (lut_prop)
+            ret = drmModeObjectSetProperty(drm_data.fd, drm_data.crtc.obj_id, DRM_MODE_OBJECT_CRTC, lut_prop, lut_blob);
+        if (!ret && ctm_prop)
+            ret = drmModeObjectSetProperty(drm_data.fd, drm_data.crtc.obj_id, DRM_MODE_OBJECT_CRTC, ctm_prop, ctm_blob);
+    }
+
+    /* The CRTC state holds its own references to the blobs. */
+    if (lut_blob)
+        drmModeDestroyPropertyBlob(drm_data.fd, lut_blob);
+    if (ctm_blob)
+        drmModeDestroyPropertyBlob(drm_data.fd, ctm_blob);
+
+    if (ret) {
+        g_debug("%s: Color properties rejected: %s", __func__, g_strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Variable refresh lets the panel follow page flips instead of scanning out
+ * at the fixed rate of the mode, which saves power while content is idle.
+ */
+static void
+init_vrr(void)
+{
+    uint64_t capable = 0;
+    if (!find_property(drm_data.connector.obj_id, DRM_MODE_OBJECT_CONNECTOR, "vrr_capable", &capable) || !capable) {
+        g_warning("Output does not support variable refresh rate.");
+        return;
+    }
+
+    const uint32_t prop_id = find_crtc_property("VRR_ENABLED", NULL);
+    if (!prop_id) {
+        g_warning("CRTC %" PRIu32 " does not support variable refresh rate.", drm_data.crtc.obj_id);
+        return;
+    }
+
+    int ret;
+    if (drm_data.atomic_modesetting) {
+        drmModeAtomicReq *req = drmModeAtomicAlloc();
+        drmModeAtomicAddProperty(req, drm_data.crtc.obj_id, prop_id, 1);
+        ret = drmModeAtomicCommit(drm_data.fd, req, DRM_MODE_ATOMIC_TEST_ONLY, NULL);
+        if (!ret)
+            ret = drmModeAtomicCommit(drm_data.fd, req, 0, NULL);
+        drmModeAtomicFree(req);
+    } else {
+        ret = drmModeObjectSetProperty(drm_data.fd, drm_data.crtc.obj_id, DRM_MODE_OBJECT_CRTC, prop_id, 1);
+    }
+
+    if (ret)
+        g_warning("Cannot enable variable refresh rate: %s", g_strerror(errno));
+    else
+        g_debug("%s: Variable refresh rate enabled.", __func__);
+}
+
+/* Shader LUTs are sampled with linear filtering, keep them small. */
+#define COLOR_SHADER_LUT_SIZE 256
+
+static void
+init_color(CogDrmPlatform *self)
+{
+    const CogDrmColorConfig *config = &drm_data.color;
+    if (cog_drm_color_config_is_identity(config))
+        return;
+
+    if (config->pipeline != COG_DRM_COLOR_PIPELINE_SHADER) {
+        if (init_color_kms()) {
+            g_debug("%s: Using KMS color pipeline.", __func__);
+            return;
+        }
+        if (config->pipeline == COG_DRM_COLOR_PIPELINE_KMS) {
+            g_warning("KMS color pipeline unavailable, ignoring color settings.");
+            return;
+        }
+    }
+
+    if (!cog_drm_renderer_supports_color_transform(self->renderer)) {
+        g_warning("Renderer '%s' does not support color transforms, ignoring color settings.", self->renderer->name);
+        return;
+    }
+
+    const bool has_curve = cog_drm_color_config_has_curve(config);
+    uint16_t   lut[COLOR_SHADER_LUT_SIZE * 3];
+    float      ctm[G_N_ELEMENTS(config->ctm)];
+
+    if (has_curve)
+        cog_drm_color_config_build_lut(config, COLOR_SHADER_LUT_SIZE, lut);
+    for (unsigned i = 0; i < G_N_ELEMENTS(ctm); i++)
+        ctm[i] = config->ctm[i];
+
+    cog_drm_renderer_set_color_transform(self->renderer, has_curve ? lut : NULL, has_curve ? COLOR_SHADER_LUT_SIZE : 0,
+                                         config->has_ctm ? ctm : NULL);
+    g_debug("%s: Using shader color pipeline.", __func__);
+}
+
 static const uint32_t formats[] = {
     DRM_FORMAT_RGBA8888,
     DRM_FORMAT_ARGB8888,
@@ -783,6 +1131,127 @@ input_handle_key_event(CogView *view, struct libinput_event_keyboard *key_event)
     }
 }
 
+/*
+ * Translate coordinates in the output into coordinates in the view, which
+ * may be scaled and/or letterboxed when using a fixed view size.
+ */
+static inline void
+input_map_to_view(int *x, int *y)
+{
+    const CogGLRendererRect *rect = &input_data.view_rect;
+    if (!rect->width || !rect->height)
+        return;
+
+    *x = ((int64_t) (*x - rect->x) * input_data.view_width) / rect->width;
+    *y = ((int64_t) (*y - rect->y) * input_data.view_height) / rect->height;
+}
+
+static void
+input_dispatch_touch_frame(uint32_t time)
+{
+    struct wpe_input_touch_event event = {
+        .touchpoints = input_data.touch_points,
+        .touchpoints_length = G_N_ELEMENTS(input_data.touch_points),
+        .type = input_data.last_touch_type,
+        .id = input_data.last_touch_id,
+        .time = time,
+    };
+
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, time);
+    wpe_view_backend_dispatch_touch_event(wpe_view_data.backend, &event);
+    input_data.stats.dispatched++;
+
+    for (int i = 0; i < G_N_ELEMENTS(input_data.touch_points); ++i) {
+        struct wpe_input_touch_event_raw *touch_point = &input_data.touch_points[i];
+        if (touch_point->type != wpe_input_touch_event_type_up)
+            continue;
+
+        memset(touch_point, 0, sizeof(struct wpe_input_touch_event_raw));
+        touch_point->type = wpe_input_touch_event_type_null;
+    }
+}
+
+/*
+ * Sends the events coalesced since the last call to WebKit. This is done
+ * when a frame is presented, before dispatching events which cannot be
+ * coalesced, to keep ordering, or after a frame interval if there are no
+ * frames being presented.
+ */
+static void
+input_flush_events(void)
+{
+    g_clear_handle_id(&input_data.pending.timeout_id, g_source_remove);
+
+    if (input_data.pending.motion) {
+        struct wpe_input_pointer_event event = {
+            .type = wpe_input_pointer_event_type_motion,
+            .time = input_data.pending.motion_time,
+            .x = cursor.x,
+            .y = cursor.y,
+            .button = 0,
+            .state = 0,
+            .modifiers = 0,
+        };
+        input_map_to_view(&event.x, &event.y);
+
+        cog_trace_record(COG_TRACE_INPUT_DISPATCH, event.time);
+        wpe_view_backend_dispatch_pointer_event(wpe_view_data.backend, &event);
+        kms_plane_set(cursor.plane, cursor.cursor, cursor.x, cursor.y);
+        input_data.stats.dispatched++;
+        input_data.pending.motion = false;
+    }
+
+    if (input_data.pending.axis) {
+        cog_trace_record(COG_TRACE_INPUT_DISPATCH, input_data.pending.axis_event.base.time);
+        wpe_view_backend_dispatch_axis_event(wpe_view_data.backend, &input_data.pending.axis_event.base);
+        input_data.stats.dispatched++;
+        input_data.pending.axis = false;
+    }
+
+    if (input_data.pending.touch) {
+        input_dispatch_touch_frame(input_data.pending.touch_time);
+        input_data.pending.touch = false;
+    }
+}
+
+static gboolean
+input_flush_timeout(void *data G_GNUC_UNUSED)
+{
+    input_data.pending.timeout_id = 0;
+    input_flush_events();
+    return G_SOURCE_REMOVE;
+}
+
+static void
+input_schedule_flush(void)
+{
+    if (input_data.pending.timeout_id)
+        return;
+
+    input_data.pending.timeout_id = g_timeout_add(1000 / MAX(drm_data.refresh, 1), input_flush_timeout, NULL);
+    g_source_set_name_by_id(input_data.pending.timeout_id, "Cog: input flush");
+}
+
+static void
+input_queue_axis_event(const struct wpe_input_axis_2d_event *event)
+{
+    input_data.stats.received++;
+
+    if (input_data.pending.axis && input_data.pending.axis_event.base.type != event->base.type)
+        input_flush_events();
+
+    if (input_data.pending.axis) {
+        input_data.pending.axis_event.base.time = event->base.time;
+        input_data.pending.axis_event.x_axis += event->x_axis;
+        input_data.pending.axis_event.y_axis += event->y_axis;
+    } else {
+        input_data.pending.axis_event = *event;
+        input_data.pending.axis = true;
+    }
+
+    input_schedule_flush();
+}
+
 static void
 input_handle_touch_event (enum libinput_event_type touch_type, struct libinput_event_touch *touch_event)
 {
@@ -792,35 +1261,29 @@ input_handle_touch_event (enum libinput_event_type touch_type, struct libinput_e
     switch (touch_type) {
         case LIBINPUT_EVENT_TOUCH_DOWN:
             event_type = wpe_input_touch_event_type_down;
+            input_data.touch_state_changed = true;
             break;
         case LIBINPUT_EVENT_TOUCH_UP:
             event_type = wpe_input_touch_event_type_up;
+            input_data.touch_state_changed = true;
             break;
         case LIBINPUT_EVENT_TOUCH_MOTION:
             event_type = wpe_input_touch_event_type_motion;
             break;
-        case LIBINPUT_EVENT_TOUCH_FRAME: {
-            struct wpe_input_touch_event event = {
-                .touchpoints = input_data.touch_points,
-                .touchpoints_length = G_N_ELEMENTS (input_data.touch_points),
-                .type = input_data.last_touch_type,
-                .id = input_data.last_touch_id,
-                .time = time,
-            };
-
-            wpe_view_backend_dispatch_touch_event (wpe_view_data.backend, &event);
-
-            for (int i = 0; i < G_N_ELEMENTS (input_data.touch_points); ++i) {
-                struct wpe_input_touch_event_raw *touch_point = &input_data.touch_points[i];
-                if (touch_point->type != wpe_input_touch_event_type_up)
-                    continue;
-
-                memset (touch_point, 0, sizeof (struct wpe_input_touch_event_raw));
-                touch_point->type = wpe_input_touch_event_type_null;
+        case LIBINPUT_EVENT_TOUCH_FRAME:
+            input_data.stats.received++;
+            if (input_data.touch_state_changed) {
+                /* The frame includes the latest position of all points. */
+                input_data.pending.touch = false;
+                input_data.touch_state_changed = false;
+                input_flush_events();
+                input_dispatch_touch_frame(time);
+            } else {
+                input_data.pending.touch = true;
+                input_data.pending.touch_time = time;
+                input_schedule_flush();
             }
-
             return;
-        }
         default:
             g_assert_not_reached ();
             return;
@@ -844,6 +1307,7 @@ input_handle_touch_event (enum libinput_event_type touch_type, struct libinput_e
                                                                  input_data.input_width);
         touch_point->y = libinput_event_touch_get_y_transformed (touch_event,
                                                                  input_data.input_height);
+        input_map_to_view(&touch_point->x, &touch_point->y);
     }
 }
 
@@ -873,18 +1337,10 @@ input_handle_pointer_motion_event(struct libinput_event_pointer *pointer_event,
         cursor.y = cursor.screen_height - 1;
     }
 
-    struct wpe_input_pointer_event event = {
-        .type = wpe_input_pointer_event_type_motion,
-        .time = libinput_event_pointer_get_time(pointer_event),
-        .x = cursor.x,
-        .y = cursor.y,
-        .button = 0,
-        .state = 0,
-        .modifiers = 0,
-    };
-
-    wpe_view_backend_dispatch_pointer_event(wpe_view_data.backend, &event);
-    kms_plane_set(cursor.plane, cursor.cursor, cursor.x, cursor.y);
+    input_data.stats.received++;
+    input_data.pending.motion = true;
+    input_data.pending.motion_time = libinput_event_pointer_get_time(pointer_event);
+    input_schedule_flush();
 }
 
 static void
@@ -893,6 +1349,9 @@ input_handle_pointer_button_event (struct libinput_event_pointer *pointer_event)
     if (!cursor.enabled)
         return;
 
+    input_data.stats.received++;
+    input_flush_events();
+
     struct wpe_input_pointer_event event = {
         .type = wpe_input_pointer_event_type_button,
         .time = libinput_event_pointer_get_time(pointer_event),
@@ -902,8 +1361,11 @@ input_handle_pointer_button_event (struct libinput_event_pointer *pointer_event)
         .state = libinput_event_pointer_get_button_state(pointer_event),
         .modifiers = 0,
     };
+    input_map_to_view(&event.x, &event.y);
 
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, event.time);
     wpe_view_backend_dispatch_pointer_event(wpe_view_data.backend, &event);
+    input_data.stats.dispatched++;
 }
 
 #if LIBINPUT_CHECK_VERSION(1, 19, 0)
@@ -918,6 +1380,7 @@ input_handle_pointer_discrete_scroll_event(struct libinput_event_pointer *pointe
         .x_axis = 0.0,
         .y_axis = 0.0,
     };
+    input_map_to_view(&event.base.x, &event.base.y);
 
     if (libinput_event_pointer_has_axis(pointer_event, LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL))
         event.y_axis = -drm_data.device_scale * libinput_event_pointer_get_scroll_value_v120(
@@ -926,7 +1389,7 @@ input_handle_pointer_discrete_scroll_event(struct libinput_event_pointer *pointe
         event.x_axis = drm_data.device_scale * libinput_event_pointer_get_scroll_value_v120(
                                                    pointer_event, LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL);
 
-    wpe_view_backend_dispatch_axis_event(wpe_view_data.backend, &event.base);
+    input_queue_axis_event(&event);
 }
 
 static void
@@ -940,6 +1403,7 @@ input_handle_pointer_smooth_scroll_event(struct libinput_event_pointer *pointer_
         .x_axis = 0.0,
         .y_axis = 0.0,
     };
+    input_map_to_view(&event.base.x, &event.base.y);
 
     if (libinput_event_pointer_has_axis(pointer_event, LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL))
         event.y_axis = drm_data.device_scale *
@@ -948,7 +1412,7 @@ input_handle_pointer_smooth_scroll_event(struct libinput_event_pointer *pointer_
         event.x_axis = drm_data.device_scale *
                        libinput_event_pointer_get_scroll_value(pointer_event, LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL);
 
-    wpe_view_backend_dispatch_axis_event(wpe_view_data.backend, &event.base);
+    input_queue_axis_event(&event);
 }
 #else
 static void
@@ -962,6 +1426,7 @@ input_handle_pointer_axis_event(struct libinput_event_pointer *pointer_event)
         .x_axis = 0.0,
         .y_axis = 0.0,
     };
+    input_map_to_view(&event.base.x, &event.base.y);
 
     if (libinput_event_pointer_get_axis_source(pointer_event) == LIBINPUT_POINTER_AXIS_SOURCE_WHEEL) {
         event.base.type |= wpe_input_axis_event_type_motion;
@@ -983,7 +1448,7 @@ input_handle_pointer_axis_event(struct libinput_event_pointer *pointer_event)
     event.x_axis *= drm_data.device_scale;
     event.y_axis *= drm_data.device_scale;
 
-    wpe_view_backend_dispatch_axis_event(wpe_view_data.backend, &event.base);
+    input_queue_axis_event(&event);
 }
 #endif /* !LIBINPUT_CHECK_VERSION(1, 19, 0) */
 
@@ -1073,6 +1538,8 @@ input_process_events (void)
         if (!event)
             break;
 
+        cog_drm_refresh_input(&drm_data.refresh_policy);
+
         enum libinput_event_type event_type = libinput_event_get_type (event);
         switch (event_type) {
         case LIBINPUT_EVENT_NONE:
@@ -1086,6 +1553,7 @@ input_process_events (void)
             break;
 
         case LIBINPUT_EVENT_KEYBOARD_KEY:
+            input_flush_events();
             input_handle_key_event(platform->web_view, libinput_event_get_keyboard_event(event));
             break;
 
@@ -1204,6 +1672,14 @@ input_interface_close_restricted (int fd, void *user_data)
 static void
 clear_input(CogDrmPlatform *platform)
 {
+    g_clear_handle_id(&input_data.pending.timeout_id, g_source_remove);
+    if (input_data.stats.received) {
+        g_debug("%s: %" PRIu64 " pointer/touch events received, %" PRIu64 " dispatched (%.1f%% coalesced).", __func__,
+                input_data.stats.received, input_data.stats.dispatched,
+                100.0 * (input_data.stats.received - MIN(input_data.stats.dispatched, input_data.stats.received)) /
+                    input_data.stats.received);
+    }
+
     if (platform->rotatable_input_devices) {
         g_list_free_full(platform->rotatable_input_devices, (GDestroyNotify) libinput_device_unref);
         platform->rotatable_input_devices = NULL;
@@ -1227,6 +1703,20 @@ update_logical_input_size(CogGLRendererRotation rotation)
         input_data.input_height = drm_data.mode->hdisplay;
         break;
     }
+
+    if (drm_data.view_width && drm_data.view_height) {
+        const bool swap = (rotation == COG_GL_RENDERER_ROTATION_90 || rotation == COG_GL_RENDERER_ROTATION_270);
+        const uint32_t width = drm_data.view_width * drm_data.device_scale;
+        const uint32_t height = drm_data.view_height * drm_data.device_scale;
+        input_data.view_width = swap ? height : width;
+        input_data.view_height = swap ? width : height;
+        cog_gl_renderer_fit_rect(drm_data.scaling, input_data.view_width, input_data.view_height,
+                                 input_data.input_width, input_data.input_height, &input_data.view_rect);
+    } else {
+        input_data.view_width = input_data.input_width;
+        input_data.view_height = input_data.input_height;
+        input_data.view_rect = (CogGLRendererRect){0, 0, input_data.input_width, input_data.input_height};
+    }
 }
 
 static gboolean
@@ -1361,6 +1851,328 @@ init_glib(CogDrmPlatform *self)
     return TRUE;
 }
 
+static void
+get_view_size(uint32_t *width, uint32_t *height)
+{
+    if (drm_data.view_width && drm_data.view_height) {
+        *width = drm_data.view_width;
+        *height = drm_data.view_height;
+    } else {
+        *width = drm_data.width / drm_data.device_scale;
+        *height = drm_data.height / drm_data.device_scale;
+    }
+}
+
+/*
+ * Checks with a test-only atomic commit whether the output can be driven
+ * with a mode, showing the area of the current framebuffer which fits.
+ */
+static bool
+test_mode(const drmModeModeInfo *mode)
+{
+    uint64_t fb_id = 0;
+    if (!drm_data.atomic_modesetting || !find_property(drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "FB_ID", &fb_id))
+        return true;
+
+    /* Nothing is being shown yet, the first frame will set the mode. */
+    drmModeFB *fb = fb_id ? drmModeGetFB(drm_data.fd, fb_id) : NULL;
+    if (!fb)
+        return true;
+
+    const uint32_t width = MIN(fb->width, mode->hdisplay);
+    const uint32_t height = MIN(fb->height, mode->vdisplay);
+    drmModeFreeFB(fb);
+
+    uint32_t blob_id = 0;
+    if (drmModeCreatePropertyBlob(drm_data.fd, mode, sizeof(*mode), &blob_id))
+        return false;
+
+    /* clang-format off */
+    const struct {
+        uint32_t    obj_id;
+        uint32_t    obj_type;
+        const char *name;
+        uint64_t    value;
+    } props[] = {
+        { drm_data.connector.obj_id, DRM_MODE_OBJECT_CONNECTOR, "CRTC_ID", drm_data.crtc.obj_id },
+        { drm_data.crtc.obj_id, DRM_MODE_OBJECT_CRTC, "MODE_ID", blob_id },
+        { drm_data.crtc.obj_id, DRM_MODE_OBJECT_CRTC, "ACTIVE", 1 },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "FB_ID", fb_id },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "CRTC_ID", drm_data.crtc.obj_id },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "SRC_X", 0 },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "SRC_Y", 0 },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "SRC_W", (uint64_t) width << 16 },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "SRC_H", (uint64_t) height << 16 },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "CRTC_X", 0 },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "CRTC_Y", 0 },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "CRTC_W", width },
+        { drm_data.plane.obj_id, DRM_MODE_OBJECT_PLANE, "CRTC_H", height },
+    };
+    /* clang-format on */
+
+    drmModeAtomicReq *req = drmModeAtomicAlloc();
+    bool              ok = true;
+    for (unsigned i = 0; ok && i < G_N_ELEMENTS(props); i++) {
+        uint32_t prop_id = find_property(props[i].obj_id, props[i].obj_type, props[i].name, NULL);
+        ok = prop_id && drmModeAtomicAddProperty(req, props[i].obj_id, prop_id, props[i].value) > 0;
+    }
+    if (ok)
+        ok = !drmModeAtomicCommit(drm_data.fd, req, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, NULL);
+
+    drmModeAtomicFree(req);
+    drmModeDestroyPropertyBlob(drm_data.fd, blob_id);
+    return ok;
+}
+
+/*
+ * Sets the mode on the output, even if it is the current one, and adapts
+ * everything that depends on the output size and refresh rate.
+ */
+static bool
+apply_mode(CogDrmPlatform *self, drmModeModeInfo *mode)
+{
+    drm_data.mode = mode;
+    drm_data.width = mode->hdisplay;
+    drm_data.height = mode->vdisplay;
+    drm_data.refresh = mode->vrefresh;
+
+    uint32_t width, height;
+    get_view_size(&width, &height);
+    if (!cog_drm_renderer_set_mode(self->renderer, mode, width, height))
+        return false;
+
+    update_logical_input_size(self->rotation);
+    cog_drm_refresh_mode_changed(&drm_data.refresh_policy, drm_data.refresh);
+
+    if (cursor.device) {
+        cursor.screen_width = drm_data.width;
+        cursor.screen_height = drm_data.height;
+        cursor.x = MIN(cursor.x, drm_data.width - 1);
+        cursor.y = MIN(cursor.y, drm_data.height - 1);
+    }
+
+    g_debug("%s: Using mode '%s' @ %" PRIu32 "Hz.", __func__, mode->name, mode->vrefresh);
+    return true;
+}
+
+static bool
+set_video_mode(CogDrmPlatform *self, const char *value)
+{
+    CogDrmModeSpec spec;
+    if (!cog_drm_mode_spec_parse(value, &spec)) {
+        g_warning("Invalid video mode '%s'.", value);
+        return false;
+    }
+
+    drmModeModeInfo *mode = cog_drm_mode_find(drm_data.connector.obj, drm_data.mode_config.policy, &spec);
+    if (!mode) {
+        g_warning("Video mode '%s' not available.", value);
+        return false;
+    }
+    if (mode == drm_data.mode)
+        return true;
+
+    if (!cog_drm_renderer_supports_mode_change(self->renderer)) {
+        g_warning("Renderer '%s' does not support changing the video mode.", self->renderer->name);
+        return false;
+    }
+    if (!test_mode(mode)) {
+        g_warning("Video mode '%s' rejected by the driver.", value);
+        return false;
+    }
+
+    drmModeModeInfo *previous_mode = drm_data.mode;
+    if (!apply_mode(self, mode)) {
+        g_warning("Cannot switch to video mode '%s'.", value);
+        drm_data.mode = previous_mode;
+        drm_data.width = previous_mode->hdisplay;
+        drm_data.height = previous_mode->vdisplay;
+        drm_data.refresh = previous_mode->vrefresh;
+        return false;
+    }
+
+    return true;
+}
+
+#ifndef DRM_MODE_LINK_STATUS_BAD
+#    define DRM_MODE_LINK_STATUS_BAD 1
+#endif /* !DRM_MODE_LINK_STATUS_BAD */
+
+/* Time to wait for a burst of hotplug events to settle. */
+#define HOTPLUG_DEBOUNCE_MS 100
+
+static bool
+connector_modes_equal(const drmModeConnector *a, const drmModeConnector *b)
+{
+    return a->count_modes == b->count_modes && !memcmp(a->modes, b->modes, a->count_modes * sizeof(*a->modes));
+}
+
+/*
+ * Checks whether the connector is still driven by the CRTC in use, which
+ * may not be the case after it has been disconnected, even if it has been
+ * reconnected since.
+ */
+static bool
+connector_is_active(const drmModeConnector *connector)
+{
+    drmModeEncoder *encoder = connector->encoder_id ? drmModeGetEncoder(drm_data.fd, connector->encoder_id) : NULL;
+    const bool      routed = encoder && encoder->crtc_id == drm_data.crtc.obj_id;
+    drmModeFreeEncoder(encoder);
+    if (!routed)
+        return false;
+
+    drmModeCrtc *crtc = drmModeGetCrtc(drm_data.fd, drm_data.crtc.obj_id);
+    const bool   active = crtc && crtc->mode_valid && crtc->buffer_id;
+    drmModeFreeCrtc(crtc);
+    return active;
+}
+
+/*
+ * Re-probes the output after a hotplug event. The connector object and the
+ * mode are refreshed, and when the output comes back after having been
+ * disconnected, is no longer driven by the CRTC, its modes changed, or the
+ * link needs retraining, the mode is set again. Renderers drop frames which
+ * cannot be flipped while the output is away, so page flipping resumes
+ * along the next frame.
+ */
+static gboolean
+on_hotplug_settled(void *data)
+{
+    CogDrmPlatform *self = data;
+    const int64_t   start = g_get_monotonic_time();
+
+    hotplug_data.debounce_id = 0;
+
+    const bool disconnected_meanwhile = hotplug_data.disconnected_meanwhile;
+    hotplug_data.disconnected_meanwhile = false;
+
+    drmModeRes *resources = drmModeGetResources(drm_data.fd);
+    if (resources) {
+        drmModeFreeResources(drm_data.base_resources);
+        drm_data.base_resources = resources;
+    }
+
+    drmModeModeInfo  *mode = NULL;
+    drmModeConnector *connector = probe_connector(&mode);
+    if (!connector || connector->connector_id != drm_data.connector.obj_id) {
+        if (connector) {
+            g_autofree char *name = cog_drm_mode_connector_name(connector);
+            g_warning("Output connected to '%s', switching connectors is unsupported.", name);
+            drmModeFreeConnector(connector);
+        }
+        if (hotplug_data.connected)
+            g_message("Output disconnected.");
+        hotplug_data.connected = false;
+        return G_SOURCE_REMOVE;
+    }
+
+    uint64_t link_status = 0;
+    find_property(connector->connector_id, DRM_MODE_OBJECT_CONNECTOR, "link-status", &link_status);
+
+    const bool modes_changed = !connector_modes_equal(connector, drm_data.connector.obj);
+    const bool needs_modeset = !hotplug_data.connected || disconnected_meanwhile || modes_changed ||
+                               link_status == DRM_MODE_LINK_STATUS_BAD || !connector_is_active(connector);
+
+    /* Keep the current mode, which may have been chosen at run time, if possible. */
+    if (!modes_changed)
+        mode = &connector->modes[drm_data.mode - drm_data.connector.obj->modes];
+
+    drmModeFreeConnector(drm_data.connector.obj);
+    drm_data.connector.obj = connector;
+    drm_data.mode = mode;
+    hotplug_data.connected = true;
+
+    if (!needs_modeset)
+        return G_SOURCE_REMOVE;
+
+    if (!test_mode(mode))
+        g_warning("Mode '%s' failed the atomic test after hotplug, trying anyway.", mode->name);
+
+    if (apply_mode(self, mode)) {
+        g_message("Output restored with mode %ux%u@%u in %.1f ms.", mode->hdisplay, mode->vdisplay, mode->vrefresh,
+                  (g_get_monotonic_time() - start) / 1000.0);
+        g_object_notify_by_pspec(G_OBJECT(self), s_properties[PROP_VIDEO_MODE]);
+    } else {
+        g_warning("Cannot restore output after hotplug.");
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+on_udev_event(int fd, GIOCondition condition, void *data)
+{
+    if (condition & (G_IO_ERR | G_IO_HUP)) {
+        g_warning("Hotplug monitor hangup, output changes will not be handled.");
+        hotplug_data.source_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    struct udev_device *device = udev_monitor_receive_device(hotplug_data.monitor);
+    if (!device)
+        return G_SOURCE_CONTINUE;
+
+    const char *hotplug = udev_device_get_property_value(device, "HOTPLUG");
+    if (udev_device_get_devnum(device) == hotplug_data.devnum && g_strcmp0(hotplug, "1") == 0) {
+        g_debug("%s: Hotplug event for %s.", __func__, udev_device_get_sysname(device));
+
+        /*
+         * The state is checked for each event, without probing, because the
+         * output may be reconnected before the burst of events settles.
+         */
+        drmModeConnector *connector = drmModeGetConnectorCurrent(drm_data.fd, drm_data.connector.obj_id);
+        if (!connector || connector->connection != DRM_MODE_CONNECTED)
+            hotplug_data.disconnected_meanwhile = true;
+        drmModeFreeConnector(connector);
+
+        if (hotplug_data.debounce_id)
+            g_source_remove(hotplug_data.debounce_id);
+        hotplug_data.debounce_id = g_timeout_add(HOTPLUG_DEBOUNCE_MS, on_hotplug_settled, data);
+        g_source_set_name_by_id(hotplug_data.debounce_id, "Cog: DRM hotplug");
+    }
+
+    udev_device_unref(device);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+clear_hotplug(void)
+{
+    g_clear_handle_id(&hotplug_data.debounce_id, g_source_remove);
+    g_clear_handle_id(&hotplug_data.source_id, g_source_remove);
+    g_clear_pointer(&hotplug_data.monitor, udev_monitor_unref);
+    g_clear_pointer(&hotplug_data.udev, udev_unref);
+}
+
+/*
+ * Listens for udev "change" events with HOTPLUG=1 for the DRM device in use,
+ * which the kernel sends when connectors change state. Failure to set up
+ * the monitor is not fatal, the output just stays as it is.
+ */
+static void
+init_hotplug(CogDrmPlatform *self)
+{
+    struct stat st;
+    if (fstat(drm_data.fd, &st) == -1) {
+        g_warning("Cannot stat DRM device (%s), hotplug disabled.", g_strerror(errno));
+        return;
+    }
+    hotplug_data.devnum = st.st_rdev;
+
+    if (!(hotplug_data.udev = udev_new()) ||
+        !(hotplug_data.monitor = udev_monitor_new_from_netlink(hotplug_data.udev, "udev")) ||
+        udev_monitor_filter_add_match_subsystem_devtype(hotplug_data.monitor, "drm", "drm_minor") < 0 ||
+        udev_monitor_enable_receiving(hotplug_data.monitor) < 0) {
+        g_warning("Cannot create udev monitor, hotplug disabled.");
+        clear_hotplug();
+        return;
+    }
+
+    hotplug_data.source_id = g_unix_fd_add(udev_monitor_get_fd(hotplug_data.monitor), G_IO_IN | G_IO_ERR | G_IO_HUP,
+                                           on_udev_event, self);
+    g_source_set_name_by_id(hotplug_data.source_id, "Cog: DRM udev monitor");
+}
+
 static void *
 check_supported(void *data G_GNUC_UNUSED)
 {
@@ -1385,6 +2197,56 @@ gamepad_provider_get_view_backend_for_gamepad(void *provider G_GNUC_UNUSED, void
     return wpe_view_data.backend;
 }
 
+static void
+on_frame_presented(CogDrmRenderer *renderer, uint64_t time_usec, void *userdata)
+{
+    cog_trace_record(COG_TRACE_PAGE_FLIP, time_usec);
+
+    static bool first_frame = true;
+    if (first_frame) {
+        cog_profile_mark("drm: first frame presented");
+        first_frame = false;
+
+        /* Live content is on screen now, the splash buffer is no longer scanned out. */
+        cog_drm_splash_hide(&drm_data.splash);
+    }
+
+    cog_drm_refresh_frame_presented(&drm_data.refresh_policy);
+
+    /* While idling the target rate is lowered on purpose, skipped cycles are not dropped frames then. */
+    const CogDrmRefresh *refresh = &drm_data.refresh_policy;
+    cog_metrics_frame_presented(time_usec, refresh->idle ? refresh->idle_refresh : drm_data.refresh);
+
+    /* Input coalesced during the last frame gets handled in time for the next one. */
+    input_flush_events();
+}
+
+static gboolean
+cog_drm_platform_save_splash(CogDrmPlatform *self)
+{
+    if (!drm_data.splash.path) {
+        g_warning("Cannot save splash: No snapshot file configured.");
+        return FALSE;
+    }
+
+    g_autoptr(GError) error = NULL;
+    if (!cog_drm_splash_save(&drm_data.splash, cog_drm_renderer_get_front_buffer(self->renderer), &error)) {
+        g_warning("Cannot save splash: %s", error->message);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * The shell goes away on clean shutdown, while the platform and the last
+ * presented frame are still around.
+ */
+static void
+on_shell_finalized(void *data, GObject *where_the_shell_was G_GNUC_UNUSED)
+{
+    cog_drm_platform_save_splash(data);
+}
+
 static gboolean
 cog_drm_platform_setup(CogPlatform *platform, CogShell *shell, const char *params, GError **error)
 {
@@ -1404,6 +2266,7 @@ cog_drm_platform_setup(CogPlatform *platform, CogShell *shell, const char *param
         return FALSE;
     }
 
+    cog_profile_begin("drm: device");
     if (!init_drm ()) {
         g_set_error_literal (error,
                              COG_PLATFORM_WPE_ERROR,
@@ -1411,6 +2274,21 @@ cog_drm_platform_setup(CogPlatform *platform, CogShell *shell, const char *param
                              "Failed to initialize DRM");
         return FALSE;
     }
+    cog_profile_end("drm: device");
+
+    if (drm_data.splash.path) {
+        g_autoptr(GError) splash_error = NULL;
+        if (cog_drm_splash_show(&drm_data.splash, drm_data.fd, drm_data.crtc.obj_id, drm_data.connector.obj_id,
+                                drm_data.mode, &splash_error))
+            cog_profile_mark("drm: splash shown");
+        else if (g_error_matches(splash_error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+            g_debug("%s: No splash snapshot yet.", __func__);
+        else
+            g_warning("Cannot show splash: %s", splash_error->message);
+
+        if (drm_data.splash.save_on_exit)
+            g_object_weak_ref(G_OBJECT(shell), on_shell_finalized, self);
+    }
 
     if (g_getenv ("COG_PLATFORM_DRM_CURSOR")) {
         if (!init_cursor ()) {
@@ -1418,6 +2296,7 @@ cog_drm_platform_setup(CogPlatform *platform, CogShell *shell, const char *param
         }
     }
 
+    cog_profile_begin("drm: egl");
     if (!init_gbm ()) {
         g_set_error_literal (error,
                              COG_PLATFORM_WPE_ERROR,
@@ -1433,6 +2312,7 @@ cog_drm_platform_setup(CogPlatform *platform, CogShell *shell, const char *param
                              "Failed to initialize EGL");
         return FALSE;
     }
+    cog_profile_end("drm: egl");
 
     if (self->use_gles) {
         self->renderer = cog_drm_gles_renderer_new(gbm_data.device,
@@ -1457,6 +2337,30 @@ cog_drm_platform_setup(CogPlatform *platform, CogShell *shell, const char *param
                   self->rotation * 90);
         self->rotation = COG_GL_RENDERER_ROTATION_0;
     }
+    if (cog_drm_renderer_supports_scaling(self->renderer, drm_data.scaling, drm_data.scaling_filter)) {
+        cog_drm_renderer_set_scaling(self->renderer, drm_data.scaling, drm_data.scaling_filter);
+    } else if (drm_data.view_width) {
+        g_warning("Renderer '%s' does not support scaling, ignoring view size %" PRIu32 "x%" PRIu32 ".",
+                  self->renderer->name, drm_data.view_width, drm_data.view_height);
+        drm_data.view_width = drm_data.view_height = 0;
+    }
+    init_color(self);
+    if (drm_data.refresh_policy.vrr)
+        init_vrr();
+    cog_drm_renderer_set_presented_callback(self->renderer, on_frame_presented, NULL);
+
+    if (drm_data.splash.fb_id && self->renderer->set_splash) {
+        g_autoptr(GError) splash_error = NULL;
+        int               dmabuf_fd = cog_drm_splash_export(&drm_data.splash, &splash_error);
+        if (dmabuf_fd < 0) {
+            g_warning("Cannot fade out splash: %s", splash_error->message);
+        } else {
+            if (!cog_drm_renderer_set_splash(self->renderer, dmabuf_fd, drm_data.splash.width, drm_data.splash.height,
+                                             drm_data.splash.pitch, drm_data.splash.format))
+                g_debug("%s: Renderer '%s' cannot fade out the splash.", __func__, self->renderer->name);
+            g_close(dmabuf_fd, NULL);
+        }
+    }
 
     if (!init_input(COG_DRM_PLATFORM(platform))) {
         g_set_error_literal (error,
@@ -1474,9 +2378,13 @@ cog_drm_platform_setup(CogPlatform *platform, CogShell *shell, const char *param
         return FALSE;
     }
 
+    init_hotplug(self);
+
     if (self->renderer->initialize) {
+        cog_profile_begin("drm: renderer");
         if (!self->renderer->initialize(self->renderer, error))
             return FALSE;
+        cog_profile_end("drm: renderer");
     }
     g_debug("%s: Renderer '%s' initialized.", __func__, self->renderer->name);
 
@@ -1495,13 +2403,18 @@ cog_drm_platform_finalize(GObject *object)
     g_idle_remove_by_data(&wpe_view_data);
 
     g_clear_pointer(&self->renderer, cog_drm_renderer_destroy);
+    cog_drm_refresh_stop(&drm_data.refresh_policy);
 
+    clear_hotplug();
     clear_glib();
     clear_input(self);
     clear_egl();
     clear_gbm();
     clear_cursor();
+    cog_drm_splash_clear(&drm_data.splash);
     clear_drm();
+    cog_drm_mode_config_clear(&drm_data.mode_config);
+    cog_drm_color_config_clear(&drm_data.color);
 
     G_OBJECT_CLASS(cog_drm_platform_parent_class)->finalize(object);
 }
@@ -1510,9 +2423,11 @@ static WebKitWebViewBackend *
 cog_drm_platform_get_view_backend(CogPlatform *platform, WebKitWebView *related_view, GError **error)
 {
     CogDrmPlatform *self = COG_DRM_PLATFORM(platform);
-    wpe_host_data.exportable = self->renderer->create_exportable(self->renderer,
-                                                                 drm_data.width / drm_data.device_scale,
-                                                                 drm_data.height / drm_data.device_scale);
+
+    uint32_t width, height;
+    get_view_size(&width, &height);
+
+    wpe_host_data.exportable = self->renderer->create_exportable(self->renderer, width, height);
     g_assert (wpe_host_data.exportable);
 
     wpe_view_data.backend = wpe_view_backend_exportable_fdo_get_view_backend (wpe_host_data.exportable);
@@ -1527,10 +2442,18 @@ cog_drm_platform_get_view_backend(CogPlatform *platform, WebKitWebView *related_
     return wk_view_backend;
 }
 
+static void
+on_refresh_rate_changed(uint32_t refresh_mhz, void *userdata)
+{
+    if (wpe_view_data.backend)
+        wpe_view_backend_set_target_refresh_rate(wpe_view_data.backend, refresh_mhz);
+}
+
 static gboolean
 set_target_refresh_rate(gpointer user_data)
 {
     wpe_view_backend_set_target_refresh_rate(wpe_view_data.backend, drm_data.refresh * 1000);
+    cog_drm_refresh_start(&drm_data.refresh_policy, drm_data.refresh, on_refresh_rate_changed, NULL);
     return G_SOURCE_REMOVE;
 }
 
@@ -1576,6 +2499,14 @@ cog_drm_platform_set_property(GObject *object, unsigned prop_id, const GValue *v
         }
         break;
     }
+    case PROP_VIDEO_MODE: {
+        const char *mode = g_value_get_string(value);
+        if (!self->renderer)
+            g_warning("%s: Cannot set video mode before setup.", __func__);
+        else if (mode && set_video_mode(self, mode))
+            g_object_notify_by_pspec(object, pspec);
+        break;
+    }
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
@@ -1592,6 +2523,11 @@ cog_drm_platform_get_property(GObject *object, unsigned prop_id, GValue *value,
     case PROP_RENDERER:
         g_value_set_string(value, self->use_gles ? "gles" : "modeset");
         break;
+    case PROP_VIDEO_MODE:
+        if (drm_data.mode)
+            g_value_take_string(value, g_strdup_printf("%ux%u@%u", drm_data.mode->hdisplay, drm_data.mode->vdisplay,
+                                                       drm_data.mode->vrefresh));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
@@ -1644,7 +2580,30 @@ cog_drm_platform_class_init(CogDrmPlatformClass *klass)
                             "modeset",
                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
 
+    /** CogDrmPlatform:video-mode:
+     *
+     * Video mode of the output, in `WxH@R` format (`W`idth and `H`eight in
+     * pixels, `R`efresh rate in Hz). The refresh rate may be omitted when
+     * setting the property, in which case the mode selection policy picks
+     * one. The view is resized to match the new mode.
+     */
+    s_properties[PROP_VIDEO_MODE] = g_param_spec_string("video-mode", "Video mode", "Video mode of the output", NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
     g_object_class_install_properties(object_class, N_PROPERTIES, s_properties);
+
+    /**
+     * CogDrmPlatform::save-splash:
+     * @self: The platform.
+     *
+     * Saves the frame currently on screen as the boot splash, to be shown
+     * on the next start until web content produces its first frame. This
+     * is an action signal, which needs the `splash` option to be set.
+     *
+     * Returns: Whether the snapshot was saved.
+     */
+    g_signal_new_class_handler("save-splash", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+                               G_CALLBACK(cog_drm_platform_save_splash), NULL, NULL, NULL, G_TYPE_BOOLEAN, 0);
 }
 
 static void
@@ -0,0 +1,107 @@
+/*
+ * cog-gtk-texture-view.c
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "cog-gtk-texture-view.h"
+
+/*
+ * Widget which shows a GdkTexture covering its whole allocation. Textures
+ * are appended as-is to the GTK scene graph, which allows GSK to composite
+ * them once, or to place them directly on an overlay plane.
+ *
+ * The "resize" signal mirrors the one from GtkGLArea, and is emitted with
+ * the size of the widget in device pixels whenever it changes.
+ */
+
+struct _CogGtkTextureView {
+    GtkWidget   parent;
+    GdkTexture *texture;
+    int         width;
+    int         height;
+};
+
+G_DEFINE_TYPE(CogGtkTextureView, cog_gtk_texture_view, GTK_TYPE_WIDGET)
+
+enum {
+    SIGNAL_RESIZE,
+    N_SIGNALS,
+};
+
+static unsigned s_signals[N_SIGNALS] = {
+    0,
+};
+
+static void
+cog_gtk_texture_view_snapshot(GtkWidget *widget, GtkSnapshot *snapshot)
+{
+    CogGtkTextureView *self = COG_GTK_TEXTURE_VIEW(widget);
+    if (!self->texture)
+        return;
+
+    const graphene_rect_t bounds =
+        GRAPHENE_RECT_INIT(0, 0, gtk_widget_get_width(widget), gtk_widget_get_height(widget));
+    gtk_snapshot_append_texture(snapshot, self->texture, &bounds);
+}
+
+static void
+cog_gtk_texture_view_size_allocate(GtkWidget *widget, int width, int height, int baseline)
+{
+    CogGtkTextureView *self = COG_GTK_TEXTURE_VIEW(widget);
+
+    const int scale_factor = gtk_widget_get_scale_factor(widget);
+    width *= scale_factor;
+    height *= scale_factor;
+
+    if (width == self->width && height == self->height)
+        return;
+
+    self->width = width;
+    self->height = height;
+    g_signal_emit(self, s_signals[SIGNAL_RESIZE], 0, width, height);
+}
+
+static void
+cog_gtk_texture_view_dispose(GObject *object)
+{
+    CogGtkTextureView *self = COG_GTK_TEXTURE_VIEW(object);
+    g_clear_object(&self->texture);
+
+    G_OBJECT_CLASS(cog_gtk_texture_view_parent_class)->dispose(object);
+}
+
+static void
+cog_gtk_texture_view_class_init(CogGtkTextureViewClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = cog_gtk_texture_view_dispose;
+
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
+    widget_class->snapshot = cog_gtk_texture_view_snapshot;
+    widget_class->size_allocate = cog_gtk_texture_view_size_allocate;
+
+    s_signals[SIGNAL_RESIZE] = g_signal_new("resize", COG_GTK_TYPE_TEXTURE_VIEW, G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+                                            NULL, G_TYPE_NONE, 2, G_TYPE_INT, G_TYPE_INT);
+}
+
+static void
+cog_gtk_texture_view_init(CogGtkTextureView *self)
+{
+}
+
+GtkWidget *
+cog_gtk_texture_view_new(void)
+{
+    return g_object_new(COG_GTK_TYPE_TEXTURE_VIEW, NULL);
+}
+
+void
+cog_gtk_texture_view_set_texture(CogGtkTextureView *self, GdkTexture *texture)
+{
+    g_return_if_fail(COG_GTK_IS_TEXTURE_VIEW(self));
+
+    if (g_set_object(&self->texture, texture))
+        gtk_widget_queue_draw(GTK_WIDGET(self));
+}
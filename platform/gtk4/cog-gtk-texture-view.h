@@ -0,0 +1,21 @@
+/*
+ * cog-gtk-texture-view.h
+ * Copyright (C) 2024 Igalia S.L.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define COG_GTK_TYPE_TEXTURE_VIEW (cog_gtk_texture_view_get_type())
+
+G_DECLARE_FINAL_TYPE(CogGtkTextureView, cog_gtk_texture_view, COG_GTK, TEXTURE_VIEW, GtkWidget)
+
+GtkWidget *cog_gtk_texture_view_new(void);
+void       cog_gtk_texture_view_set_texture(CogGtkTextureView *self, GdkTexture *texture);
+
+G_END_DECLS
@@ -9,6 +9,7 @@
 
 #include <gdk/gdk.h>
 #include <gtk/gtk.h>
+#include <unistd.h>
 #include <wpe/fdo-egl.h>
 #include <wpe/fdo.h>
 #if COG_HAVE_LIBPORTAL
@@ -21,10 +22,17 @@
 #include "../common/cog-cursors.h"
 #include "../common/cog-gl-utils.h"
 #include "cog-gtk-settings-dialog.h"
+#include "cog-gtk-texture-view.h"
 
 #define DEFAULT_WIDTH 1280
 #define DEFAULT_HEIGHT 720
 
+#if GTK_CHECK_VERSION(4, 14, 0)
+#    define HAVE_DMABUF_TEXTURE 1
+#else
+#    define HAVE_DMABUF_TEXTURE 0
+#endif
+
 struct _CogGtk4PlatformClass {
     CogPlatformClass parent_class;
 };
@@ -46,16 +54,28 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED(
  * TODO:
  * - Multiple views.
  * - Call cog_gl_renderer_finalize() when GL area is being destroyed.
- * - Implement an actual widget that wraps exported EGLImages into a
- *   GdkTexture and uses gtk_snapshot_append_texture() to participate in
- *   the GTK scene graph directly and avoid CogGLRenderer.
+ */
+
+/*
+ * Exported images are shown using one of two widgets, which live in a
+ * GtkStack that also receives the input events:
+ *
+ * - With GTK 4.14 or newer and EGL_MESA_image_dma_buf_export available, the
+ *   images are exported as DMA-BUFs and wrapped into a GdkDmabufTexture,
+ *   which CogGtkTextureView appends to the GTK scene graph. This avoids an
+ *   additional rendering pass, and GTK may even place it on a plane.
+ * - Otherwise, CogGLRenderer paints the images into a GtkGLArea. This is
+ *   also used if creating a texture fails at runtime, or when passing the
+ *   "renderer=gl" platform parameter.
  */
 
 struct platform_window {
     WebKitWebView* web_view;
 
     GtkWidget* gtk_window;
+    GtkWidget* view_stack;
     GtkWidget* gl_drawing_area;
+    GtkWidget* texture_view;
     GtkWidget* back_button;
     GtkWidget* forward_button;
     GtkWidget* url_entry;
@@ -77,6 +97,10 @@ struct platform_window {
 
     struct wpe_fdo_egl_exported_image* current_image;
     struct wpe_fdo_egl_exported_image* commited_image;
+
+    bool       use_dmabuf;
+    EGLDisplay egl_display;
+    unsigned   frame_tick_id;
 };
 
 static struct platform_window win = {
@@ -107,6 +131,26 @@ get_extensions(void)
     }
 }
 
+static bool
+initialize_fdo(EGLDisplay display, GError **error)
+{
+    static bool initialized = false;
+    if (initialized)
+        return true;
+
+    EGLint egl_major = 0, egl_minor = 0;
+    if (eglInitialize(display, &egl_major, &egl_minor) == EGL_FALSE) {
+        g_set_error_literal(error, COG_PLATFORM_EGL_ERROR, eglGetError(),
+            "Cannot initialize EGL");
+        return false;
+    }
+
+    g_debug("EGL %i.%i successfully initialized.", egl_major, egl_minor);
+    wpe_fdo_initialize_for_egl_display(display);
+    initialized = true;
+    return true;
+}
+
 static bool
 setup_shader(struct platform_window* window, GError** error)
 {
@@ -136,22 +180,156 @@ setup_shader(struct platform_window* window, GError** error)
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    /* Configuration for the FDO backend. */
     EGLDisplay display = eglGetCurrentDisplay();
     g_assert(display != EGL_NO_DISPLAY);
+    return initialize_fdo(display, error);
+}
 
-    EGLint egl_major = 0, egl_minor = 0;
-    if (eglInitialize(display, &egl_major, &egl_minor) == EGL_FALSE) {
-        g_set_error_literal(error, COG_PLATFORM_EGL_ERROR, eglGetError(),
-            "Cannot initialize EGL");
+/*
+ * GTK does not tell when a frame reaches the screen, the time of the frame
+ * being drawn is the closest approximation.
+ */
+static void
+record_frame_presented(GdkFrameClock *frame_clock)
+{
+    if (!frame_clock)
+        return;
+
+    const int64_t frame_time = gdk_frame_clock_get_frame_time(frame_clock);
+    int64_t       refresh_interval = 0;
+    gdk_frame_clock_get_refresh_info(frame_clock, frame_time, &refresh_interval, NULL);
+    cog_trace_record(COG_TRACE_PAGE_FLIP, frame_time);
+    cog_metrics_frame_presented(frame_time, refresh_interval > 0 ? G_USEC_PER_SEC / refresh_interval : 0);
+}
+
+#if HAVE_DMABUF_TEXTURE
+static bool
+setup_dmabuf(struct platform_window *window, GError **error)
+{
+    g_autoptr(GdkGLContext) context = gdk_display_create_gl_context(gdk_display_get_default(), error);
+    if (!context || !gdk_gl_context_realize(context, error))
+        return false;
+
+    gdk_gl_context_make_current(context);
+    EGLDisplay display = eglGetCurrentDisplay();
+    gdk_gl_context_clear_current();
+
+    if (display == EGL_NO_DISPLAY) {
+        g_set_error_literal(error, COG_PLATFORM_EGL_ERROR, 0, "GDK is not using EGL");
         return false;
     }
+    if (!epoxy_has_egl_extension(display, "EGL_MESA_image_dma_buf_export")) {
+        g_set_error_literal(error, COG_PLATFORM_EGL_ERROR, 0, "EGL_MESA_image_dma_buf_export is not supported");
+        return false;
+    }
+    if (!initialize_fdo(display, error))
+        return false;
 
-    g_debug("EGL %i.%i successfully initialized.", egl_major, egl_minor);
-    wpe_fdo_initialize_for_egl_display(display);
+    window->egl_display = display;
     return true;
 }
 
+struct dmabuf_frame {
+    struct wpe_fdo_egl_exported_image *image;
+    int                                fds[4];
+};
+
+static void
+dmabuf_frame_free(void *data)
+{
+    struct dmabuf_frame *frame = data;
+
+    for (unsigned i = 0; i < G_N_ELEMENTS(frame->fds); i++) {
+        if (frame->fds[i] < 0)
+            continue;
+
+        /* Planes may share the same file descriptor. */
+        bool closed = false;
+        for (unsigned j = 0; j < i; j++)
+            closed |= (frame->fds[j] == frame->fds[i]);
+        if (!closed)
+            close(frame->fds[i]);
+    }
+
+    if (frame->image && win.exportable)
+        wpe_view_backend_exportable_fdo_egl_dispatch_release_exported_image(win.exportable, frame->image);
+
+    g_slice_free(struct dmabuf_frame, frame);
+}
+
+static GdkTexture *
+dmabuf_texture_new(struct platform_window *window, struct wpe_fdo_egl_exported_image *image, GError **error)
+{
+    EGLImage     egl_image = wpe_fdo_egl_exported_image_get_egl_image(image);
+    int          fourcc = 0, n_planes = 0;
+    EGLuint64KHR modifier = 0;
+
+    if (!eglExportDMABUFImageQueryMESA(window->egl_display, egl_image, &fourcc, &n_planes, &modifier) ||
+        n_planes < 1 || n_planes > 4) {
+        g_set_error(error, COG_PLATFORM_EGL_ERROR, eglGetError(), "Cannot query DMA-BUF attributes");
+        return NULL;
+    }
+
+    struct dmabuf_frame *frame = g_slice_new(struct dmabuf_frame);
+    *frame = (struct dmabuf_frame){.fds = {-1, -1, -1, -1}};
+
+    EGLint strides[4] = {0}, offsets[4] = {0};
+    if (!eglExportDMABUFImageMESA(window->egl_display, egl_image, frame->fds, strides, offsets)) {
+        g_set_error(error, COG_PLATFORM_EGL_ERROR, eglGetError(), "Cannot export image as DMA-BUF");
+        dmabuf_frame_free(frame);
+        return NULL;
+    }
+
+    g_autoptr(GdkDmabufTextureBuilder) builder = gdk_dmabuf_texture_builder_new();
+    gdk_dmabuf_texture_builder_set_display(builder, gtk_widget_get_display(window->texture_view));
+    gdk_dmabuf_texture_builder_set_width(builder, wpe_fdo_egl_exported_image_get_width(image));
+    gdk_dmabuf_texture_builder_set_height(builder, wpe_fdo_egl_exported_image_get_height(image));
+    gdk_dmabuf_texture_builder_set_fourcc(builder, fourcc);
+    gdk_dmabuf_texture_builder_set_modifier(builder, modifier);
+    gdk_dmabuf_texture_builder_set_premultiplied(builder, TRUE);
+    gdk_dmabuf_texture_builder_set_n_planes(builder, n_planes);
+    for (int i = 0; i < n_planes; i++) {
+        gdk_dmabuf_texture_builder_set_fd(builder, i, frame->fds[i] >= 0 ? frame->fds[i] : frame->fds[0]);
+        gdk_dmabuf_texture_builder_set_stride(builder, i, strides[i]);
+        gdk_dmabuf_texture_builder_set_offset(builder, i, offsets[i]);
+    }
+
+    GdkTexture *texture = gdk_dmabuf_texture_builder_build(builder, dmabuf_frame_free, frame, error);
+    if (!texture) {
+        dmabuf_frame_free(frame);
+        return NULL;
+    }
+
+    /* From here on, the image is released along with the texture. */
+    frame->image = image;
+    return texture;
+}
+
+static gboolean
+on_frame_tick(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+    struct platform_window *window = user_data;
+
+    window->frame_tick_id = 0;
+    record_frame_presented(frame_clock);
+    wpe_view_backend_exportable_fdo_dispatch_frame_complete(window->exportable);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+use_gl_area(struct platform_window *window)
+{
+    if (window->frame_tick_id) {
+        gtk_widget_remove_tick_callback(window->texture_view, window->frame_tick_id);
+        window->frame_tick_id = 0;
+    }
+    cog_gtk_texture_view_set_texture(COG_GTK_TEXTURE_VIEW(window->texture_view), NULL);
+
+    window->use_dmabuf = false;
+    gtk_stack_set_visible_child(GTK_STACK(window->view_stack), window->gl_drawing_area);
+}
+#endif /* HAVE_DMABUF_TEXTURE */
+
 static void
 enter_monitor(GdkSurface *surface, GdkMonitor *monitor, gpointer user_data)
 {
@@ -170,18 +348,18 @@ realize(GtkWidget *widget, gpointer user_data)
         g_warning("Shader setup failed: %s", error->message);
         g_application_quit(g_application_get_default());
     }
-
-    g_signal_connect(gtk_native_get_surface(gtk_widget_get_native(win->gtk_window)), "enter-monitor",
-                     G_CALLBACK(enter_monitor), user_data);
 }
 
 static gboolean
 render(GtkGLArea *area, GdkGLContext *context, gpointer user_data)
 {
     struct platform_window *win = user_data;
+    const uint32_t output_width = win->width * win->device_scale_factor;
+    const uint32_t output_height = win->height * win->device_scale_factor;
+
     glClearColor(0, 0, 0, 0);
     glClear(GL_COLOR_BUFFER_BIT);
-    glViewport(0, 0, win->width * win->device_scale_factor, win->height * win->device_scale_factor);
+    glViewport(0, 0, output_width, output_height);
 
     if (win->commited_image)
         wpe_view_backend_exportable_fdo_egl_dispatch_release_exported_image(
@@ -192,22 +370,37 @@ render(GtkGLArea *area, GdkGLContext *context, gpointer user_data)
         return TRUE;
     }
 
-    cog_gl_renderer_paint(&win->gl_render, wpe_fdo_egl_exported_image_get_egl_image(win->current_image),
-                          COG_GL_RENDERER_ROTATION_0);
+    const uint32_t     image_width = wpe_fdo_egl_exported_image_get_width(win->current_image);
+    const uint32_t     image_height = wpe_fdo_egl_exported_image_get_height(win->current_image);
+    CogGLRendererLayer layer = {
+        .image = wpe_fdo_egl_exported_image_get_egl_image(win->current_image),
+        .dst = {0, 0, output_width, output_height},
+        .opacity = 1.0f,
+        .rotation = COG_GL_RENDERER_ROTATION_0,
+        .filter = COG_GL_RENDERER_FILTER_NEAREST,
+    };
+
+    /* The image may lag behind the widget size while resizing. */
+    if (image_width != output_width || image_height != output_height)
+        layer.filter = COG_GL_RENDERER_FILTER_LINEAR;
+
+    cog_gl_renderer_paint_layers(&win->gl_render, &layer, 1, output_width, output_height);
 
     win->commited_image = win->current_image;
 
+    record_frame_presented(gtk_widget_get_frame_clock(GTK_WIDGET(area)));
     wpe_view_backend_exportable_fdo_dispatch_frame_complete(win->exportable);
     return TRUE;
 }
 
 static void
-resize(GtkGLArea* area, int width, int height, gpointer user_data)
+resize(GtkWidget* widget, int width, int height, gpointer user_data)
 {
     struct platform_window* win = user_data;
 
     win->width = width / win->device_scale_factor;
     win->height = height / win->device_scale_factor;
+    cog_gl_renderer_invalidate_textures(&win->gl_render);
     wpe_view_backend_dispatch_set_size(
         wpe_view_backend_exportable_fdo_get_view_backend(win->exportable),
         win->width, win->height);
@@ -270,18 +463,20 @@ on_click_pressed(GtkGestureClick* gesture, int n_press, double x,
     double y, gpointer user_data)
 {
     struct platform_window* win = user_data;
-    int                     scale_factor = gtk_widget_get_scale_factor(GTK_WIDGET(win->gl_drawing_area));
+    int                     scale_factor = gtk_widget_get_scale_factor(win->view_stack);
 
-    gtk_widget_grab_focus(win->gl_drawing_area);
+    gtk_widget_grab_focus(win->view_stack);
 
     struct wpe_input_pointer_event wpe_event = {
         .type = wpe_input_pointer_event_type_button,
+        .time = gtk_event_controller_get_current_event_time(GTK_EVENT_CONTROLLER(gesture)),
         .x = (int) (x * scale_factor),
         .y = (int) (y * scale_factor),
         .modifiers = wpe_input_pointer_modifier_button1,
         .button = 1,
         .state = 1,
     };
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, wpe_event.time);
     wpe_view_backend_dispatch_pointer_event(
         wpe_view_backend_exportable_fdo_get_view_backend(win->exportable),
         &wpe_event);
@@ -292,16 +487,18 @@ on_click_released(GtkGestureClick* gesture, int n_press, double x,
     double y, gpointer user_data)
 {
     struct platform_window* win = user_data;
-    int                     scale_factor = gtk_widget_get_scale_factor(GTK_WIDGET(win->gl_drawing_area));
+    int                     scale_factor = gtk_widget_get_scale_factor(win->view_stack);
 
     struct wpe_input_pointer_event wpe_event = {
         .type = wpe_input_pointer_event_type_button,
+        .time = gtk_event_controller_get_current_event_time(GTK_EVENT_CONTROLLER(gesture)),
         .x = (int) (x * scale_factor),
         .y = (int) (y * scale_factor),
         .modifiers = wpe_input_pointer_modifier_button1,
         .button = 1,
         .state = 0,
     };
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, wpe_event.time);
     wpe_view_backend_dispatch_pointer_event(
         wpe_view_backend_exportable_fdo_get_view_backend(win->exportable),
         &wpe_event);
@@ -312,13 +509,15 @@ on_motion(GtkEventControllerMotion* controller, double x, double y,
     gpointer user_data)
 {
     struct platform_window* win = user_data;
-    int                     scale_factor = gtk_widget_get_scale_factor(GTK_WIDGET(win->gl_drawing_area));
+    int                     scale_factor = gtk_widget_get_scale_factor(win->view_stack);
 
     struct wpe_input_pointer_event wpe_event = {
         .type = wpe_input_pointer_event_type_motion,
+        .time = gtk_event_controller_get_current_event_time(GTK_EVENT_CONTROLLER(controller)),
         .x = (int) (x * scale_factor),
         .y = (int) (y * scale_factor),
     };
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, wpe_event.time);
     wpe_view_backend_dispatch_pointer_event(
         wpe_view_backend_exportable_fdo_get_view_backend(win->exportable),
         &wpe_event);
@@ -331,6 +530,7 @@ on_scroll(GtkEventControllerScroll* controller, double dx,
     struct platform_window* win = user_data;
     struct wpe_input_axis_event axis_event = {
         .type = wpe_input_axis_event_type_mask_2d | wpe_input_axis_event_type_motion_smooth,
+        .time = gtk_event_controller_get_current_event_time(GTK_EVENT_CONTROLLER(controller)),
         .axis = dx ? 0 : 1,
         .value = dx ? -dx * 100 : -dy * 100,
     };
@@ -339,6 +539,7 @@ on_scroll(GtkEventControllerScroll* controller, double dx,
         .x_axis = dx ? -dx * 100 : 0,
         .y_axis = dx ? 0 : -dy * 100,
     };
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, axis_event.time);
     wpe_view_backend_dispatch_axis_event(
         wpe_view_backend_exportable_fdo_get_view_backend(win->exportable),
         &event2d.base);
@@ -559,18 +760,28 @@ setup_window(struct platform_window* window)
     gtk_header_bar_set_show_title_buttons(GTK_HEADER_BAR(header_bar), TRUE);
     gtk_window_set_titlebar(GTK_WINDOW(window->gtk_window), header_bar);
 
+    window->view_stack = gtk_stack_new();
+    gtk_widget_set_hexpand(window->view_stack, TRUE);
+    gtk_widget_set_vexpand(window->view_stack, TRUE);
+    gtk_widget_set_can_focus(window->view_stack, TRUE);
+    gtk_widget_set_sensitive(window->view_stack, TRUE);
+    gtk_widget_set_focusable(window->view_stack, TRUE);
+    gtk_widget_set_focus_on_click(window->view_stack, TRUE);
+    g_signal_connect(window->view_stack, "notify::scale-factor", G_CALLBACK(scale_factor_change), window);
+
     window->gl_drawing_area = gtk_gl_area_new();
-    gtk_widget_set_hexpand(window->gl_drawing_area, TRUE);
-    gtk_widget_set_vexpand(window->gl_drawing_area, TRUE);
-    gtk_widget_set_can_focus(window->gl_drawing_area, TRUE);
-    gtk_widget_set_sensitive(window->gl_drawing_area, TRUE);
-    gtk_widget_set_focusable(window->gl_drawing_area, TRUE);
-    gtk_widget_set_focus_on_click(window->gl_drawing_area, TRUE);
     g_object_set(window->gl_drawing_area, "use-es", TRUE, NULL);
     g_signal_connect(window->gl_drawing_area, "realize", G_CALLBACK(realize), window);
     g_signal_connect(window->gl_drawing_area, "render", G_CALLBACK(render), window);
     g_signal_connect(window->gl_drawing_area, "resize", G_CALLBACK(resize), window);
-    g_signal_connect(window->gl_drawing_area, "notify::scale-factor", G_CALLBACK(scale_factor_change), window);
+    gtk_stack_add_named(GTK_STACK(window->view_stack), window->gl_drawing_area, "gl-area");
+
+    window->texture_view = cog_gtk_texture_view_new();
+    g_signal_connect(window->texture_view, "resize", G_CALLBACK(resize), window);
+    gtk_stack_add_named(GTK_STACK(window->view_stack), window->texture_view, "texture");
+
+    gtk_stack_set_visible_child(GTK_STACK(window->view_stack),
+                                window->use_dmabuf ? window->texture_view : window->gl_drawing_area);
 
     g_signal_connect(window->gtk_window, "notify::fullscreened", G_CALLBACK(on_fullscreen_change), window);
     g_signal_connect(window->gtk_window, "notify::is-active", G_CALLBACK(on_is_active_change), window);
@@ -579,17 +790,17 @@ setup_window(struct platform_window* window)
     gtk_gesture_single_set_button(GTK_GESTURE_SINGLE(press), GDK_BUTTON_PRIMARY);
     g_signal_connect(press, "pressed", G_CALLBACK(on_click_pressed), window);
     g_signal_connect(press, "released", G_CALLBACK(on_click_released), window);
-    gtk_widget_add_controller(window->gl_drawing_area, GTK_EVENT_CONTROLLER(press));
+    gtk_widget_add_controller(window->view_stack, GTK_EVENT_CONTROLLER(press));
 
     GtkEventController* motion_controller = gtk_event_controller_motion_new();
     GtkEventControllerMotion* motion = GTK_EVENT_CONTROLLER_MOTION(motion_controller);
     g_signal_connect(motion, "motion", G_CALLBACK(on_motion), window);
-    gtk_widget_add_controller(window->gl_drawing_area, motion_controller);
+    gtk_widget_add_controller(window->view_stack, motion_controller);
 
     GtkEventController* scroll_controller = gtk_event_controller_scroll_new(GTK_EVENT_CONTROLLER_SCROLL_BOTH_AXES);
     GtkEventControllerScroll* scroll = GTK_EVENT_CONTROLLER_SCROLL(scroll_controller);
     g_signal_connect(scroll, "scroll", G_CALLBACK(on_scroll), window);
-    gtk_widget_add_controller(window->gl_drawing_area, scroll_controller);
+    gtk_widget_add_controller(window->view_stack, scroll_controller);
 
     GtkEventController* key_controller = gtk_event_controller_key_new();
     GtkEventControllerKey* key = GTK_EVENT_CONTROLLER_KEY(key_controller);
@@ -620,9 +831,12 @@ setup_window(struct platform_window* window)
 
     GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, FALSE);
     gtk_window_set_child(GTK_WINDOW(window->gtk_window), box);
-    gtk_box_append(GTK_BOX(box), window->gl_drawing_area);
+    gtk_box_append(GTK_BOX(box), window->view_stack);
 
     gtk_window_present(GTK_WINDOW(window->gtk_window));
+
+    g_signal_connect(gtk_native_get_surface(GTK_NATIVE(window->gtk_window)), "enter-monitor",
+                     G_CALLBACK(enter_monitor), window);
 }
 
 static void
@@ -631,7 +845,26 @@ on_export_egl_image(void* userdata,
 {
     struct platform_window* window = userdata;
 
+    cog_trace_record(COG_TRACE_FRAME_EXPORT, 0);
+
+#if HAVE_DMABUF_TEXTURE
+    if (window->use_dmabuf) {
+        g_autoptr(GError)     error = NULL;
+        g_autoptr(GdkTexture) texture = dmabuf_texture_new(window, image, &error);
+        if (texture) {
+            cog_gtk_texture_view_set_texture(COG_GTK_TEXTURE_VIEW(window->texture_view), texture);
+            if (!window->frame_tick_id)
+                window->frame_tick_id = gtk_widget_add_tick_callback(window->texture_view, on_frame_tick, window, NULL);
+            return;
+        }
+
+        g_warning("Cannot use DMA-BUF textures, falling back to GtkGLArea: %s", error->message);
+        use_gl_area(window);
+    }
+#endif /* HAVE_DMABUF_TEXTURE */
+
     window->current_image = image;
+    cog_gl_renderer_import_image(&window->gl_render, wpe_fdo_egl_exported_image_get_egl_image(image));
     gtk_gl_area_queue_render(GTK_GL_AREA(window->gl_drawing_area));
 }
 
@@ -683,6 +916,29 @@ cog_gtk4_platform_setup(CogPlatform *platform, CogShell *shell, const char *para
 
     g_signal_connect(shell, "notify::device-scale-factor", G_CALLBACK(shell_device_factor_changed), &win);
 
+    G_GNUC_UNUSED bool try_dmabuf = HAVE_DMABUF_TEXTURE;
+    if (params) {
+        g_auto(GStrv) items = g_strsplit(params, ",", -1);
+        for (unsigned i = 0; items[i]; i++) {
+            g_strstrip(items[i]);
+            if (g_str_equal(items[i], "renderer=gl"))
+                try_dmabuf = false;
+            else if (g_str_equal(items[i], "renderer=dmabuf"))
+                try_dmabuf = HAVE_DMABUF_TEXTURE;
+            else if (items[i][0] != '\0')
+                g_warning("Unrecognized platform parameter '%s'", items[i]);
+        }
+    }
+
+#if HAVE_DMABUF_TEXTURE
+    if (try_dmabuf) {
+        g_autoptr(GError) dmabuf_error = NULL;
+        win.use_dmabuf = setup_dmabuf(&win, &dmabuf_error);
+        if (!win.use_dmabuf)
+            g_debug("DMA-BUF textures unavailable, using GtkGLArea: %s", dmabuf_error->message);
+    }
+#endif /* HAVE_DMABUF_TEXTURE */
+
     setup_window(&win);
     setup_fdo_exportable(&win);
     cog_gamepad_setup(gamepad_provider_get_view_backend_for_gamepad);
@@ -787,7 +1043,7 @@ cog_gtk4_platform_init_web_view(CogPlatform* platform, WebKitWebView* view)
     g_signal_connect(view, "mouse-target-changed", G_CALLBACK(on_mouse_target_changed), NULL);
     win.web_view = view;
 
-    win.device_scale_factor = gtk_widget_get_scale_factor(win.gl_drawing_area);
+    win.device_scale_factor = gtk_widget_get_scale_factor(win.view_stack);
     wpe_view_backend_dispatch_set_device_scale_factor(wpe_view_backend_exportable_fdo_get_view_backend(win.exportable),
                                                       win.device_scale_factor);
 }
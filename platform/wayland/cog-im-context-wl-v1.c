@@ -7,6 +7,8 @@
 
 #include "cog-im-context-wl-v1.h"
 
+#include "../../core/cog.h"
+
 #include <xkbcommon/xkbcommon.h>
 
 static struct {
@@ -451,6 +453,7 @@ text_input_keysym(void *data,
         wpe_modifiers |= wpe_input_keyboard_modifier_control;
 
     struct wpe_input_keyboard_event event = { time, sym, 0, state == true, wpe_modifiers };
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, time);
     wpe_view_backend_dispatch_keyboard_event (wl_text_input.view_backend, &event);
 }
 
@@ -348,8 +348,10 @@ pointer_on_motion(void *data, struct wl_pointer *pointer, uint32_t time, wl_fixe
     CogWlViewport *viewport = COG_WL_VIEWPORT(seat->pointer_target);
     CogView       *view = cog_viewport_get_visible_view((CogViewport *) viewport);
 
-    if (view)
+    if (view) {
+        cog_trace_record(COG_TRACE_INPUT_DISPATCH, event.time);
         wpe_view_backend_dispatch_pointer_event(cog_view_get_backend(view), &event);
+    }
 }
 
 static void
@@ -405,8 +407,10 @@ pointer_on_button(void              *data,
     CogWlViewport *viewport = COG_WL_VIEWPORT(seat->pointer_target);
     CogView       *view = cog_viewport_get_visible_view((CogViewport *) viewport);
 
-    if (view)
+    if (view) {
+        cog_trace_record(COG_TRACE_INPUT_DISPATCH, event.time);
         wpe_view_backend_dispatch_pointer_event(cog_view_get_backend(view), &event);
+    }
 }
 
 static void
@@ -433,8 +437,10 @@ dispatch_axis_event(CogWlSeat *seat)
     CogWlViewport *viewport = COG_WL_VIEWPORT(seat->pointer_target);
     CogView       *view = cog_viewport_get_visible_view((CogViewport *) viewport);
 
-    if (view)
+    if (view) {
+        cog_trace_record(COG_TRACE_INPUT_DISPATCH, event.base.time);
         wpe_view_backend_dispatch_axis_event(cog_view_get_backend(view), &event.base);
+    }
 
     seat->axis.has_delta = false;
     seat->axis.time = 0;
@@ -798,8 +804,10 @@ touch_on_down(void              *data,
     struct wpe_input_touch_event event = {seat->touch.points, 10, raw_event.type, raw_event.id, raw_event.time};
 
     CogView *view = cog_viewport_get_visible_view((CogViewport *) viewport);
-    if (view)
+    if (view) {
+        cog_trace_record(COG_TRACE_INPUT_DISPATCH, event.time);
         wpe_view_backend_dispatch_touch_event(cog_view_get_backend(view), &event);
+    }
 }
 
 static void
@@ -848,8 +856,10 @@ touch_on_up(void *data, struct wl_touch *touch, uint32_t serial, uint32_t time,
 
     CogWlViewport *viewport = COG_WL_VIEWPORT(seat->touch_target);
     CogView       *view = cog_viewport_get_visible_view((CogViewport *) viewport);
-    if (view)
+    if (view) {
+        cog_trace_record(COG_TRACE_INPUT_DISPATCH, event.time);
         wpe_view_backend_dispatch_touch_event(cog_view_get_backend(view), &event);
+    }
 
     memset(&seat->touch.points[id], 0x00, sizeof(struct wpe_input_touch_event_raw));
 }
@@ -888,8 +898,10 @@ touch_on_motion(void *data, struct wl_touch *touch, uint32_t time, int32_t id, w
 
     CogWlViewport *viewport = COG_WL_VIEWPORT(seat->touch_target);
     CogView       *view = cog_viewport_get_visible_view((CogViewport *) viewport);
-    if (view)
+    if (view) {
+        cog_trace_record(COG_TRACE_INPUT_DISPATCH, event.time);
         wpe_view_backend_dispatch_touch_event(cog_view_get_backend(view), &event);
+    }
 }
 
 static void
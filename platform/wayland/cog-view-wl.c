@@ -130,6 +130,7 @@ cog_wl_view_dispose(GObject *object)
     CogWlView *self = COG_WL_VIEW(object);
 
     g_clear_pointer(&self->frame_callback, wl_callback_destroy);
+    g_clear_handle_id(&self->offscreen_frame_id, g_source_remove);
 
     if (self->image) {
         g_assert(self->exportable);
@@ -383,6 +384,7 @@ cog_wl_view_update_surface_contents(CogWlView *view)
     wl_surface_attach(surface, buffer, 0, 0);
     wl_surface_damage(surface, 0, 0, surface_pixel_width, surface_pixel_height);
 
+    g_clear_handle_id(&view->offscreen_frame_id, g_source_remove);
     cog_wl_view_request_frame(view);
 
     wl_surface_commit(surface);
@@ -391,6 +393,32 @@ cog_wl_view_update_surface_contents(CogWlView *view)
         cog_wl_view_enter_fullscreen(view);
 }
 
+static gboolean
+on_offscreen_frame_timeout(void *data)
+{
+    CogWlView *view = data;
+
+    view->offscreen_frame_id = 0;
+    wpe_view_backend_exportable_fdo_dispatch_frame_complete(view->exportable);
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Frames of hidden views are kept but not shown. Pre-rendered views get
+ * their frames completed at the pace configured for the viewport, while
+ * the rest wait until they are shown again.
+ */
+static void
+cog_wl_view_complete_offscreen_frame(CogWlView *view, CogWlViewport *viewport)
+{
+    if (view->offscreen_frame_id || !cog_viewport_is_prerendering((CogViewport *) viewport, (CogView *) view))
+        return;
+
+    view->offscreen_frame_id = g_timeout_add(cog_viewport_get_prerender_interval((CogViewport *) viewport),
+                                             on_offscreen_frame_timeout, view);
+    g_source_set_name_by_id(view->offscreen_frame_id, "Cog: off-screen frame");
+}
+
 static bool
 validate_exported_geometry(CogWlViewport *viewport, uint32_t width, uint32_t height)
 {
@@ -415,6 +443,8 @@ on_export_shm_buffer(void *data, struct wpe_fdo_shm_exported_buffer *exported_bu
     CogWlView               *view = data;
     g_autoptr(CogWlViewport) viewport = COG_WL_VIEWPORT(cog_view_get_viewport((CogView *) view));
 
+    cog_trace_record(COG_TRACE_FRAME_EXPORT, 0);
+
     struct wl_resource   *exported_resource = wpe_fdo_shm_exported_buffer_get_resource(exported_buffer);
     struct wl_shm_buffer *exported_shm_buffer = wpe_fdo_shm_exported_buffer_get_shm_buffer(exported_buffer);
 
@@ -457,12 +487,13 @@ on_export_shm_buffer(void *data, struct wpe_fdo_shm_exported_buffer *exported_bu
     buffer->exported_buffer = exported_buffer;
     shm_buffer_copy_contents(buffer, exported_shm_buffer);
 
-    const int32_t state = wpe_view_backend_get_activity_state(cog_view_get_backend((CogView *) view));
-    if (state & wpe_view_activity_state_visible) {
+    if (cog_viewport_get_visible_view((CogViewport *) viewport) == (CogView *) view) {
         wl_surface_attach(viewport->window.wl_surface, buffer->buffer, 0, 0);
         wl_surface_damage(viewport->window.wl_surface, 0, 0, INT32_MAX, INT32_MAX);
         cog_wl_view_request_frame(view);
         wl_surface_commit(viewport->window.wl_surface);
+    } else {
+        cog_wl_view_complete_offscreen_frame(view, viewport);
     }
 }
 
@@ -472,6 +503,8 @@ on_export_wl_egl_image(void *data, struct wpe_fdo_egl_exported_image *image)
     CogWlView               *self = data;
     g_autoptr(CogWlViewport) viewport = COG_WL_VIEWPORT(cog_view_get_viewport((CogView *) self));
 
+    cog_trace_record(COG_TRACE_FRAME_EXPORT, 0);
+
     uint32_t image_width = wpe_fdo_egl_exported_image_get_width(image);
     uint32_t image_height = wpe_fdo_egl_exported_image_get_height(image);
     if (!viewport || !validate_exported_geometry(viewport, image_width, image_height)) {
@@ -485,9 +518,10 @@ on_export_wl_egl_image(void *data, struct wpe_fdo_egl_exported_image *image)
 
     self->image = image;
 
-    const int32_t state = wpe_view_backend_get_activity_state(cog_view_get_backend((CogView *) self));
-    if (state & wpe_view_activity_state_visible)
+    if (cog_viewport_get_visible_view((CogViewport *) viewport) == (CogView *) self)
         cog_wl_view_update_surface_contents(self);
+    else
+        cog_wl_view_complete_offscreen_frame(self, viewport);
 }
 
 static void
@@ -531,6 +565,19 @@ on_wl_surface_frame(void *data, struct wl_callback *callback, uint32_t time)
 {
     CogWlView *view = data;
 
+    static bool first_frame = true;
+    if (first_frame) {
+        cog_profile_mark("wayland: first frame presented");
+        first_frame = false;
+    }
+
+    /* The callback time has an unspecified base, use the same clock as other platforms instead. */
+    CogWlPlatform     *platform = (CogWlPlatform *) cog_platform_get();
+    const CogWlOutput *output = platform->display->current_output;
+    const int64_t      now = g_get_monotonic_time();
+    cog_trace_record(COG_TRACE_PAGE_FLIP, now);
+    cog_metrics_frame_presented(now, output ? (output->refresh + 500) / 1000 : 0);
+
     if (view->frame_callback) {
         g_assert(view->frame_callback == callback);
         g_clear_pointer(&view->frame_callback, wl_callback_destroy);
@@ -29,6 +29,7 @@ struct _CogWlView {
     bool is_resizing_fullscreen;
 
     struct wl_callback *frame_callback;
+    guint               offscreen_frame_id;
 
     bool    should_update_opaque_region;
     int32_t scale_factor;
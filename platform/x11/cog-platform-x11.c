@@ -16,6 +16,7 @@
 
 #include <X11/Xlib-xcb.h>
 #include <X11/Xlib.h>
+#include <xcb/present.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_cursor.h>
 
@@ -53,6 +54,12 @@ typedef EGLDisplay (EGLAPIENTRYP PFNEGLGETPLATFORMDISPLAYEXTPROC) (EGLenum platf
 #define DEFAULT_WIDTH  1024
 #define DEFAULT_HEIGHT  768
 
+/* Time to wait for PresentCompleteNotify before giving up on Present. */
+#define PRESENT_TIMEOUT_MS 250
+
+/* Number of presented frames over which pacing statistics are logged. */
+#define PRESENT_STATS_FRAMES 300
+
 struct _CogX11PlatformClass {
     CogPlatformClass parent_class;
 };
@@ -83,6 +90,9 @@ struct CogX11Display {
         xcb_atom_t atom_net_wm_name;
         xcb_atom_t atom_utf8_string;
 
+        bool    has_present;
+        uint8_t present_opcode;
+
         struct {
             int32_t x;
             int32_t y;
@@ -128,11 +138,27 @@ struct CogX11Window {
 
         bool needs_repaint;
         bool needs_frame_completion;
+        unsigned idle_source;
 
         unsigned width;
         unsigned height;
     } xcb;
 
+    struct {
+        uint32_t eid;
+        unsigned timeout_source;
+
+        uint64_t swap_count;     /* Buffer swaps done. */
+        uint64_t complete_count; /* PresentCompleteNotify events received. */
+        uint64_t frame_swap;     /* Swap showing the frame pending completion. */
+
+        uint64_t last_msc;
+        uint64_t last_ust;
+        unsigned n_frames;
+        unsigned n_skipped;
+        uint64_t interval_sum;
+    } present;
+
     struct {
         EGLSurface surface;
     } egl;
@@ -148,30 +174,107 @@ struct CogX11Window {
 static struct CogX11Display *s_display = NULL;
 static struct CogX11Window *s_window = NULL;
 
+static void xcb_paint_image(struct wpe_fdo_egl_exported_image *image);
+
 static void
-xcb_schedule_notice(void)
+xcb_frame_complete(void)
 {
-    /* There is a notice message already scheduled, do not queue another. */
-    if (s_window->xcb.needs_repaint || s_window->xcb.needs_frame_completion)
-        return;
+    s_window->xcb.needs_frame_completion = false;
+    g_clear_handle_id(&s_window->present.timeout_source, g_source_remove);
+
+    /* With Present, frames are recorded when the server reports them as shown. */
+    if (!s_display->xcb.has_present) {
+        const int64_t now = g_get_monotonic_time();
+        cog_trace_record(COG_TRACE_PAGE_FLIP, now);
+        cog_metrics_frame_presented(now, 0);
+    }
+    wpe_view_backend_exportable_fdo_dispatch_frame_complete(s_window->wpe.exportable);
+}
 
-    xcb_client_message_event_t client_message = {
-        .response_type = XCB_CLIENT_MESSAGE,
-        .format = 32,
-        .window = s_window->xcb.window,
-        .type = XCB_ATOM_NOTICE,
-    };
+static inline bool
+xcb_waiting_for_present(void)
+{
+    return s_display->xcb.has_present && s_window->present.complete_count < s_window->present.frame_swap;
+}
 
-    xcb_send_event (s_display->xcb.connection, 0, s_window->xcb.window,
-                    0, (char *) &client_message);
-    xcb_flush (s_display->xcb.connection);
+static gboolean
+xcb_idle_dispatch(void *data G_GNUC_UNUSED)
+{
+    s_window->xcb.idle_source = 0;
+
+    if (s_window->xcb.needs_repaint)
+        xcb_paint_image(s_window->wpe.image);
+
+    if (s_window->xcb.needs_frame_completion && !xcb_waiting_for_present())
+        xcb_frame_complete();
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+xcb_schedule_idle(void)
+{
+    if (!s_window->xcb.idle_source)
+        s_window->xcb.idle_source = g_idle_add(xcb_idle_dispatch, NULL);
 }
 
 static inline void
 xcb_schedule_repaint(void)
 {
-    xcb_schedule_notice();
     s_window->xcb.needs_repaint = true;
+    xcb_schedule_idle();
+}
+
+static gboolean
+xcb_present_timeout(void *data G_GNUC_UNUSED)
+{
+    s_window->present.timeout_source = 0;
+
+    g_warning("No PresentCompleteNotify received after %u ms, completing frames without Present.",
+              PRESENT_TIMEOUT_MS);
+    s_display->xcb.has_present = false;
+    xcb_frame_complete();
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+xcb_handle_present_complete(const xcb_present_complete_notify_event_t *event)
+{
+    if (event->event != s_window->present.eid || event->kind != XCB_PRESENT_COMPLETE_KIND_PIXMAP)
+        return;
+
+    s_window->present.complete_count++;
+
+    /* The refresh rate comes from the vblank count, so skipped ones are counted as dropped frames. */
+    unsigned refresh_rate = 0;
+    if (s_window->present.last_ust && event->ust > s_window->present.last_ust &&
+        event->msc > s_window->present.last_msc) {
+        const uint64_t elapsed = event->ust - s_window->present.last_ust;
+        refresh_rate = ((event->msc - s_window->present.last_msc) * G_USEC_PER_SEC + elapsed / 2) / elapsed;
+    }
+    cog_trace_record(COG_TRACE_PAGE_FLIP, event->ust);
+    cog_metrics_frame_presented(event->ust, refresh_rate);
+
+    if (s_window->present.last_ust && event->ust > s_window->present.last_ust) {
+        s_window->present.interval_sum += event->ust - s_window->present.last_ust;
+        if (event->msc > s_window->present.last_msc + 1)
+            s_window->present.n_skipped += event->msc - s_window->present.last_msc - 1;
+
+        if (++s_window->present.n_frames == PRESENT_STATS_FRAMES) {
+            g_debug("Present: %u frames, average interval %.2f ms, %u vblanks skipped.", s_window->present.n_frames,
+                    s_window->present.interval_sum / (1000.0 * s_window->present.n_frames),
+                    s_window->present.n_skipped);
+            s_window->present.n_frames = 0;
+            s_window->present.n_skipped = 0;
+            s_window->present.interval_sum = 0;
+        }
+    }
+    s_window->present.last_msc = event->msc;
+    s_window->present.last_ust = event->ust;
+
+    if (s_window->xcb.needs_frame_completion && !xcb_waiting_for_present())
+        xcb_frame_complete();
 }
 
 static void
@@ -184,22 +287,53 @@ xcb_paint_image (struct wpe_fdo_egl_exported_image *image)
     glClear (GL_COLOR_BUFFER_BIT);
     s_window->xcb.needs_repaint = false;
 
-    if (image != EGL_NO_IMAGE) {
-        if (s_window->wpe.image != image) {
-            if (s_window->wpe.image)
-                wpe_view_backend_exportable_fdo_egl_dispatch_release_exported_image(s_window->wpe.exportable,
-                                                                                    s_window->wpe.image);
-
-            s_window->wpe.image = image;
-            xcb_schedule_notice();
-            s_window->xcb.needs_frame_completion = true;
-        }
+    const bool is_new_frame = (image != EGL_NO_IMAGE && s_window->wpe.image != image);
+    if (is_new_frame) {
+        if (s_window->wpe.image)
+            wpe_view_backend_exportable_fdo_egl_dispatch_release_exported_image(s_window->wpe.exportable,
+                                                                                s_window->wpe.image);
 
-        cog_gl_renderer_paint(&s_display->gl_render, wpe_fdo_egl_exported_image_get_egl_image(s_window->wpe.image),
-                              COG_GL_RENDERER_ROTATION_0);
+        s_window->wpe.image = image;
+        s_window->xcb.needs_frame_completion = true;
+        cog_gl_renderer_import_image(&s_display->gl_render, wpe_fdo_egl_exported_image_get_egl_image(image));
+    }
+
+    if (image != EGL_NO_IMAGE) {
+        const uint32_t     image_width = wpe_fdo_egl_exported_image_get_width(s_window->wpe.image);
+        const uint32_t     image_height = wpe_fdo_egl_exported_image_get_height(s_window->wpe.image);
+        CogGLRendererLayer layer = {
+            .image = wpe_fdo_egl_exported_image_get_egl_image(s_window->wpe.image),
+            .dst = {0, 0, s_window->xcb.width, s_window->xcb.height},
+            .opacity = 1.0f,
+            .rotation = COG_GL_RENDERER_ROTATION_0,
+            .filter = COG_GL_RENDERER_FILTER_NEAREST,
+        };
+
+        /* The image may lag behind the window size while resizing. */
+        if (image_width != s_window->xcb.width || image_height != s_window->xcb.height)
+            layer.filter = COG_GL_RENDERER_FILTER_LINEAR;
+
+        cog_gl_renderer_paint_layers(&s_display->gl_render, &layer, 1, s_window->xcb.width, s_window->xcb.height);
     }
 
     eglSwapBuffers(s_display->egl.display, s_window->egl.surface);
+    s_window->present.swap_count++;
+
+    if (!is_new_frame)
+        return;
+
+    /*
+     * With Present the frame is completed once the swap showing it has been
+     * presented, which paces WebKit to the display refresh. Otherwise, defer
+     * completion to the next main loop iteration.
+     */
+    if (s_display->xcb.has_present) {
+        s_window->present.frame_swap = s_window->present.swap_count;
+        if (!s_window->present.timeout_source)
+            s_window->present.timeout_source = g_timeout_add(PRESENT_TIMEOUT_MS, xcb_present_timeout, NULL);
+    } else {
+        xcb_schedule_idle();
+    }
 }
 
 #ifdef COG_X11_USE_XKB
@@ -329,6 +463,7 @@ xcb_handle_axis(xcb_button_press_event_t *event, const int16_t axis_delta[2])
         .y_axis = axis_delta[1],
     };
 
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, input_event.base.time);
     wpe_view_backend_dispatch_axis_event (s_window->wpe.backend, &input_event.base);
 }
 
@@ -380,6 +515,7 @@ xcb_handle_button_press(xcb_button_press_event_t *event)
         .state = s_display->xcb.pointer.state,
     };
 
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, input_event.time);
     wpe_view_backend_dispatch_pointer_event (s_window->wpe.backend, &input_event);
 }
 
@@ -406,6 +542,7 @@ xcb_handle_button_release (xcb_button_release_event_t *event)
         .state = s_display->xcb.pointer.state,
     };
 
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, input_event.time);
     wpe_view_backend_dispatch_pointer_event (s_window->wpe.backend, &input_event);
 }
 
@@ -424,6 +561,7 @@ xcb_handle_motion_event (xcb_motion_notify_event_t *event)
         .state = s_display->xcb.pointer.state,
     };
 
+    cog_trace_record(COG_TRACE_INPUT_DISPATCH, input_event.time);
     wpe_view_backend_dispatch_pointer_event (s_window->wpe.backend, &input_event);
 }
 
@@ -458,6 +596,7 @@ xcb_handle_visibility_event(const xcb_visibility_notify_event_t *event)
 static void
 on_export_fdo_egl_image(void *data, struct wpe_fdo_egl_exported_image *image)
 {
+    cog_trace_record(COG_TRACE_FRAME_EXPORT, 0);
     xcb_paint_image(image);
 }
 
@@ -479,6 +618,7 @@ xcb_process_events(CogView *view)
 
             s_window->xcb.width = configure_notify->width;
             s_window->xcb.height = configure_notify->height;
+            cog_gl_renderer_invalidate_textures(&s_display->gl_render);
 
             wpe_view_backend_dispatch_set_size (s_window->wpe.backend,
                                                 s_window->xcb.width,
@@ -497,16 +637,13 @@ xcb_process_events(CogView *view)
                 g_application_quit (g_application_get_default ());
                 break;
             }
-
-            if (client_message->type == XCB_ATOM_NOTICE) {
-                if (s_window->xcb.needs_frame_completion) {
-                    s_window->xcb.needs_frame_completion = false;
-                    wpe_view_backend_exportable_fdo_dispatch_frame_complete(s_window->wpe.exportable);
-                }
-
-                if (s_window->xcb.needs_repaint)
-                    xcb_paint_image(s_window->wpe.image);
-            }
+            break;
+        }
+        case XCB_GE_GENERIC: {
+            const xcb_ge_generic_event_t *ge = (const xcb_ge_generic_event_t *) event;
+            if (s_display->xcb.has_present && ge->extension == s_display->xcb.present_opcode &&
+                ge->event_type == XCB_PRESENT_COMPLETE_NOTIFY)
+                xcb_handle_present_complete((const xcb_present_complete_notify_event_t *) event);
             break;
         }
         case XCB_KEY_PRESS:
@@ -659,6 +796,25 @@ init_xcb ()
                          8,
                          strlen("Cog"), "Cog");
 
+    const xcb_query_extension_reply_t *present = xcb_get_extension_data(s_display->xcb.connection, &xcb_present_id);
+    if (present && present->present) {
+        xcb_present_query_version_reply_t *reply = xcb_present_query_version_reply(
+            s_display->xcb.connection,
+            xcb_present_query_version(s_display->xcb.connection, XCB_PRESENT_MAJOR_VERSION, XCB_PRESENT_MINOR_VERSION),
+            NULL);
+        if (reply) {
+            g_debug("Using Present %u.%u for frame completion.", reply->major_version,
+                    reply->minor_version);
+            free(reply);
+
+            s_display->xcb.has_present = true;
+            s_display->xcb.present_opcode = present->major_opcode;
+            s_window->present.eid = xcb_generate_id(s_display->xcb.connection);
+            xcb_present_select_input(s_display->xcb.connection, s_window->present.eid, s_window->xcb.window,
+                                     XCB_PRESENT_EVENT_MASK_COMPLETE_NOTIFY);
+        }
+    }
+
     xcb_map_window (s_display->xcb.connection, s_window->xcb.window);
     xcb_flush (s_display->xcb.connection);
 
@@ -866,6 +1022,9 @@ init_glib(CogX11Platform *platform)
 static void
 clear_glib (void)
 {
+    g_clear_handle_id(&s_window->xcb.idle_source, g_source_remove);
+    g_clear_handle_id(&s_window->present.timeout_source, g_source_remove);
+
     if (s_display->xcb.source)
         g_source_destroy (s_display->xcb.source);
     g_clear_pointer (&s_display->xcb.source, g_source_unref);